@@ -0,0 +1,71 @@
+/*
+ * AtomicHistogram.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  1D histogram with atomic counters as bins. Any number of threads fill it
+ *  without a lock. The counts are moved into the bin array of the ROOT
+ *  histogram with the same binning from time to time, under the ROOT lock.
+ */
+
+#ifndef ATOMICHISTOGRAM_H_
+#define ATOMICHISTOGRAM_H_
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <stdint.h>
+
+class AtomicHistogram {
+protected:
+	unsigned nBins;
+	double low;
+	double high;
+	double binsPerUnit;
+	// Bin 0 is the underflow and bin nBins + 1 the overflow, as in ROOT
+	std::unique_ptr<std::atomic<uint32_t>[]> bins;
+
+public:
+	AtomicHistogram(unsigned nBinsX, double xLow, double xHigh) :
+			nBins(nBinsX), low(xLow), high(xHigh), binsPerUnit(nBinsX / (xHigh - xLow)),
+			bins(new std::atomic<uint32_t>[nBinsX + 2]) {
+		for (unsigned iBin = 0; iBin < nBins + 2; iBin++)
+			bins[iBin].store(0, std::memory_order_relaxed);
+	}
+	virtual ~AtomicHistogram() {
+	}
+
+	AtomicHistogram(const AtomicHistogram&) = delete;
+	AtomicHistogram& operator=(const AtomicHistogram&) = delete;
+
+	void fill(double value) {
+		unsigned bin;
+		if (value < low)
+			bin = 0;
+		else if (value >= high)
+			bin = nBins + 1;
+		else
+			bin = std::min<unsigned>(unsigned((value - low) * binsPerUnit), nBins - 1) + 1;
+		bins[bin].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Add the counts to the bin array of a histogram with the same binning
+	// and clear them. Returns the number of entries moved.
+	template<typename CELL_TYPE>
+	uint64_t moveTo(CELL_TYPE* histogramBins) {
+		uint64_t nMoved = 0;
+		for (unsigned iBin = 0; iBin < nBins + 2; iBin++) {
+			uint32_t count = bins[iBin].exchange(0, std::memory_order_relaxed);
+			histogramBins[iBin] += count;
+			nMoved += count;
+		}
+		return nMoved;
+	}
+
+	unsigned getNumberOfBins() const {
+		return nBins;
+	}
+};
+
+#endif /* ATOMICHISTOGRAM_H_ */
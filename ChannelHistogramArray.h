@@ -0,0 +1,96 @@
+/*
+ * ChannelHistogramArray.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  One histogram of a quantity for every channel, kept in a single array.
+ *  The bins are laid out as the cells of a ROOT TH2 with the channel number
+ *  on X and the quantity on Y, underflow and overflow included, so that the
+ *  array can be added to the TH2 bin array in one pass. Each event thread
+ *  fills its own arrays and adds them to the ROOT histograms now and then.
+ */
+
+#ifndef CHANNELHISTOGRAMARRAY_H_
+#define CHANNELHISTOGRAMARRAY_H_
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+template<typename BIN_TYPE>
+class ChannelHistogramArray {
+protected:
+	unsigned nChannels = 0;
+	unsigned nBins = 0;
+	double low = 0;
+	double high = 1;
+	double binsPerUnit = 1;
+	// Cell (channel + 1) + (nChannels + 2) * bin, bin 0 is the underflow
+	std::vector<BIN_TYPE> cells;
+	uint64_t nEntries = 0;
+
+public:
+	ChannelHistogramArray() {
+	}
+	ChannelHistogramArray(unsigned channels, unsigned bins, double xLow,
+			double xHigh) {
+		setBinning(channels, bins, xLow, xHigh);
+	}
+
+	void setBinning(unsigned channels, unsigned bins, double xLow, double xHigh) {
+		nChannels = channels;
+		nBins = bins;
+		low = xLow;
+		high = xHigh;
+		binsPerUnit = nBins / (high - low);
+		cells.assign(size_t(nChannels + 2) * (nBins + 2), 0);
+		nEntries = 0;
+	}
+
+	void fill(unsigned channel, double value) {
+		unsigned bin;
+		if (value < low)
+			bin = 0;
+		else if (value >= high)
+			bin = nBins + 1;
+		else
+			bin = std::min<unsigned>(unsigned((value - low) * binsPerUnit), nBins - 1) + 1;
+		cells[(channel + 1) + size_t(nChannels + 2) * bin] += 1;
+		nEntries++;
+	}
+
+	// Add the bins to the cell array of a TH2 with the same binning
+	template<typename CELL_TYPE>
+	void addTo(CELL_TYPE* histogramCells) const {
+		for (size_t iCell = 0; iCell < cells.size(); iCell++)
+			histogramCells[iCell] += cells[iCell];
+	}
+
+	void clear() {
+		std::fill(cells.begin(), cells.end(), 0);
+		nEntries = 0;
+	}
+
+	BIN_TYPE getBinContent(unsigned channel, unsigned bin) const {
+		return cells[(channel + 1) + size_t(nChannels + 2) * bin];
+	}
+
+	uint64_t getEntries() const {
+		return nEntries;
+	}
+
+	size_t getNumberOfCells() const {
+		return cells.size();
+	}
+
+	unsigned getNumberOfChannels() const {
+		return nChannels;
+	}
+
+	unsigned getNumberOfBins() const {
+		return nBins;
+	}
+};
+
+#endif /* CHANNELHISTOGRAMARRAY_H_ */
@@ -5,55 +5,101 @@
  *      Author: hovanes
  */
 
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+
 #include "CompressionTester.h"
 
 using namespace std;
 
 std::mutex CompressionTester::fileAccessMutex;
 
-void CompressionTester::writeData(const vector<uint16_t>& inputData) {
-	std::vector<int> intVector(inputData.size());
-	std::transform(inputData.begin(), inputData.end(), intVector.begin(),
-			[](uint16_t u) {return static_cast<int>(u);});
-
-	data::data decoder;
+CompressionTester::CompressionTester(const vector<string>& codecNames,
+		bool writeEncoded) :
+		writeFiles(writeEncoded) {
+	vector<string> names = codecNames;
+	if (find(names.begin(), names.end(), "all") != names.end())
+		names = WaveformCodec::getCodecNames();
+	for (auto& name : names) {
+		WaveformCodec* codec = WaveformCodec::create(name);
+		if (codec == nullptr) {
+			cerr << "CompressionTester: unknown codec " << name << endl;
+			continue;
+		}
+		codecs.emplace_back(codec);
+		statistics.emplace_back(new CodecStatistics());
+	}
+}
 
-	std::vector<uint16_t> low, high;
-	std::vector<char> encoded;
-	std::vector<char> encodedLossy;
+CompressionTester::~CompressionTester() {
+	close();
+}
 
-	std::vector<char> vec16(2 * intVector.size());
-	for (unsigned p = 0; p < intVector.size(); p++) {
-		uint16_t *ptr = reinterpret_cast<uint16_t*>(&vec16[p * 2]);
-		uint16_t value = (uint16_t) intVector[p];
-		*ptr = value;
+void CompressionTester::open(const string& prefix) {
+	if (!writeFiles)
+		return;
+	lock_guard<mutex> guard(fileAccessMutex);
+	streams.clear();
+	for (auto& codec : codecs) {
+		string fileName = prefix + "_" + codec->getName() + ".bin";
+		streams.emplace_back(new ofstream(fileName, ios::out | ios::binary));
+		if (!*streams.back())
+			cerr << "CompressionTester: cannot open " << fileName << endl;
 	}
+}
 
-	decoder.decompose(intVector, low, high);
-	decoder.encode(intVector, encoded);
-	decoder.encodeLossy(intVector, encodedLossy);
-
-	std::vector<int> vecSUB = decoder.getSubtracted(intVector);
-	std::vector<int> vecREM = decoder.getReiman(vecSUB);
+void CompressionTester::close() {
+	lock_guard<mutex> guard(fileAccessMutex);
+	if (!streams.empty())
+		cout << "Closing files" << endl;
+	streams.clear();
+}
 
-//    decoder.print(vecSUB);
-//    decoder.print(vecREM);
-//    decoder.print(intVector);
-//    decoder.print(low);
-//    decoder.print(high);
+void CompressionTester::writeData(const vector<uint16_t>& inputData,
+		vector<CodecResult>& results) {
+	// The encoding buffer of each thread keeps its capacity
+	static thread_local vector<char> encoded;
+	results.resize(codecs.size());
+	for (unsigned iCodec = 0; iCodec < codecs.size(); iCodec++) {
+		auto start = chrono::steady_clock::now();
+		codecs[iCodec]->encode(inputData, encoded);
+		auto stop = chrono::steady_clock::now();
 
-	std::lock_guard<std::mutex> guard(fileAccessMutex);
+		CodecResult& result = results[iCodec];
+		result.bytesIn = 2 * inputData.size();
+		result.bytesOut = encoded.size();
+		result.encodeNs = chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
 
-	losslessStream.write(&encoded[0], encoded.size());
-	lossyStream.write(&encodedLossy[0], encodedLossy.size());
-	rawStream.write(&vec16[0], vec16.size());
+		CodecStatistics& stats = *statistics[iCodec];
+		stats.nWaveforms.fetch_add(1, memory_order_relaxed);
+		stats.bytesIn.fetch_add(result.bytesIn, memory_order_relaxed);
+		stats.bytesOut.fetch_add(result.bytesOut, memory_order_relaxed);
+		stats.encodeNs.fetch_add(result.encodeNs, memory_order_relaxed);
 
-	for (unsigned iSample = 0; iSample < inputData.size(); iSample++) {
-		asciiStream << std::setw(5) << inputData[iSample];
-		if (iSample < inputData.size() - 1)
-			asciiStream << " , ";
+		if (writeFiles && !encoded.empty()) {
+			lock_guard<mutex> guard(fileAccessMutex);
+			if (iCodec < streams.size())
+				streams[iCodec]->write(encoded.data(), encoded.size());
+		}
 	}
-	asciiStream << endl;
+}
 
-	return;
+void CompressionTester::printStatistics(ostream& out) const {
+	out << setw(14) << "codec" << setw(12) << "waveforms" << setw(14) << "bytes in"
+			<< setw(14) << "bytes out" << setw(8) << "ratio" << setw(10) << "ns/wf"
+			<< setw(10) << "MB/s" << endl;
+	for (unsigned iCodec = 0; iCodec < codecs.size(); iCodec++) {
+		const CodecStatistics& stats = *statistics[iCodec];
+		uint64_t nWaveforms = stats.nWaveforms.load();
+		uint64_t bytesIn = stats.bytesIn.load();
+		uint64_t bytesOut = stats.bytesOut.load();
+		uint64_t encodeNs = stats.encodeNs.load();
+		out << setw(14) << codecs[iCodec]->getName() << setw(12) << nWaveforms
+				<< setw(14) << bytesIn << setw(14) << bytesOut << fixed
+				<< setprecision(3) << setw(8) << (bytesIn > 0 ? double(bytesOut) / bytesIn : 0.)
+				<< setprecision(1) << setw(10) << (nWaveforms > 0 ? double(encodeNs) / nWaveforms : 0.)
+				<< setw(10) << (encodeNs > 0 ? 1e3 * bytesIn / encodeNs : 0.) << endl;
+		out.unsetf(ios::floatfield);
+	}
 }
@@ -3,6 +3,11 @@
  *
  *  Created on: Jun 12, 2017
  *      Author: hovanes
+ *
+ *  Runs a set of waveform codecs side by side on the same waveforms and keeps
+ *  the bytes in and out and the encoding time of each. The codecs are created
+ *  by name from the WaveformCodec registry. Optionally the encoded waveforms
+ *  of each codec are written to <prefix>_<codec>.bin.
  */
 
 #ifndef COMPRESSIONTESTER_H_
@@ -10,106 +15,77 @@
 
 #include <string>
 #include <iostream>
-#include <algorithm>
 #include <vector>
-#include <functional>
-#include <ios>
-#include <iosfwd>
-#include <stdint.h>
-#include <stdlib.h>
-#include <cstdlib>
-#include <cstdio>
 #include <fstream>
-#include <thread>
+#include <memory>
+#include <atomic>
 #include <mutex>
-#include <iomanip>
-#include "data.h"
+#include <stdint.h>
+
+#include "WaveformCodec.h"
 
 class CompressionTester {
-protected:
-	std::string rawFileName;
-	std::string losslessFileName;
-	std::string lossyFileName;
-	std::string asciiFileName;
+public:
+	// What encoding one waveform cost with one codec
+	struct CodecResult {
+		uint32_t bytesIn;
+		uint32_t bytesOut;
+		uint64_t encodeNs;
+	};
+
+	// Totals of one codec since the start of the job
+	struct CodecStatistics {
+		std::atomic<uint64_t> nWaveforms;
+		std::atomic<uint64_t> bytesIn;
+		std::atomic<uint64_t> bytesOut;
+		std::atomic<uint64_t> encodeNs;
+		CodecStatistics() :
+				nWaveforms(0), bytesIn(0), bytesOut(0), encodeNs(0) {
+		}
+	};
 
-	std::ofstream rawStream;
-	std::ofstream losslessStream;
-	std::ofstream lossyStream;
+protected:
+	std::vector<std::unique_ptr<WaveformCodec> > codecs;
+	std::vector<std::unique_ptr<CodecStatistics> > statistics;
 
-	std::ofstream asciiStream;
+	bool writeFiles;
+	std::vector<std::unique_ptr<std::ofstream> > streams;
 
 	static std::mutex fileAccessMutex;
 
 public:
-	CompressionTester(std::string prefix = "tacCompression") :
-			rawFileName(prefix + "_Raw.bin"), losslessFileName(
-					prefix + "_Lossless.bin"), lossyFileName(
-					prefix + "_Lossy.bin"), asciiFileName(prefix+"_Samples.txt") {
-		rawStream.open(rawFileName, std::ios::out | std::ios::binary);
-		losslessStream.open(losslessFileName, std::ios::out | std::ios::binary);
-		lossyStream.open(lossyFileName, std::ios::out | std::ios::binary);
-		asciiStream.open(asciiFileName, std::ios::out);
-	}
-	virtual ~CompressionTester() {
-		std::cout << "Closing files" << std::endl;
-		rawStream.close();
-		losslessStream.close();
-		lossyStream.close();
-		asciiStream.close();
-	}
-
-	virtual void writeData(const std::vector<uint16_t>& inputData);
-
-	static const std::mutex& getFileAccessMutex() {
-		return fileAccessMutex;
-	}
+	// Codecs given by name, "all" for all registered ones. Unknown names are skipped.
+	CompressionTester(const std::vector<std::string>& codecNames, bool writeEncoded = false);
+	virtual ~CompressionTester();
 
-	const std::string& getLosslessFileName() const {
-		return losslessFileName;
-	}
+	CompressionTester(const CompressionTester&) = delete;
+	CompressionTester& operator=(const CompressionTester&) = delete;
 
-	void setLosslessFileName(const std::string& losslessFileName) {
-		this->losslessFileName = losslessFileName;
-	}
+	// Start the files of the encoded waveforms, <prefix>_<codec>.bin
+	virtual void open(const std::string& prefix);
+	virtual void close();
 
-	const std::ofstream& getLosslessStream() const {
-		return losslessStream;
-	}
+	// Encode the waveform with every codec, results has one entry per codec
+	virtual void writeData(const std::vector<uint16_t>& inputData,
+			std::vector<CodecResult>& results);
 
-	const std::string& getLossyFileName() const {
-		return lossyFileName;
-	}
+	// One line per codec with the compression ratio and the throughput
+	virtual void printStatistics(std::ostream& out) const;
 
-	void setLossyFileName(const std::string& lossyFileName) {
-		this->lossyFileName = lossyFileName;
+	unsigned getNumberOfCodecs() const {
+		return codecs.size();
 	}
 
-	const std::ofstream& getLossyStream() const {
-		return lossyStream;
+	const WaveformCodec& getCodec(unsigned iCodec) const {
+		return *codecs[iCodec];
 	}
 
-	const std::string& getRawFileName() const {
-		return rawFileName;
+	const CodecStatistics& getStatistics(unsigned iCodec) const {
+		return *statistics[iCodec];
 	}
 
-	void setRawFileName(const std::string& rawFileName) {
-		this->rawFileName = rawFileName;
-	}
-
-	const std::ofstream& getRawStream() const {
-		return rawStream;
-	}
-
-	const std::string& getAsciiFileName() const {
-		return asciiFileName;
-	}
-
-	void setAsciiFileName(const std::string& asciiFileName) {
-		this->asciiFileName = asciiFileName;
-	}
-
-	const std::ofstream& getAsciiStream() const {
-		return asciiStream;
+	static std::mutex& getFileAccessMutex() {
+		return fileAccessMutex;
 	}
 };
 
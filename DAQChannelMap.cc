@@ -0,0 +1,90 @@
+/*
+ * DAQChannelMap.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "DAQChannelMap.h"
+
+using namespace std;
+
+DAQChannelMap::DAQChannelMap() {
+	for (unsigned type = 0; type < NUMBER_OF_TYPES; type++)
+		slotBlocks[type].assign(maxRocid * maxSlot, -1);
+}
+
+bool DAQChannelMap::parseType(const string& name, ChannelType& type) {
+	string upperName = name;
+	transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
+	if (upperName == "FADC" || upperName == "FADC250") {
+		type = FADC;
+		return true;
+	}
+	if (upperName == "TDC" || upperName == "F1TDC" || upperName == "CAEN1290") {
+		type = TDC;
+		return true;
+	}
+	return false;
+}
+
+bool DAQChannelMap::addChannel(const Channel& channel) {
+	if (channel.rocid >= maxRocid || channel.slot >= maxSlot
+			|| channel.channel >= maxChannel) {
+		cerr << "DAQChannelMap: address of " << channel.name
+				<< " is out of range" << endl;
+		return false;
+	}
+	if (find(channel.type, channel.rocid, channel.slot, channel.channel) >= 0) {
+		cerr << "DAQChannelMap: " << channel.name << " has the address of "
+				<< channels[find(channel.type, channel.rocid, channel.slot,
+						channel.channel)].name << endl;
+		return false;
+	}
+	int32_t& block = slotBlocks[channel.type][channel.rocid * maxSlot + channel.slot];
+	if (block < 0) {
+		block = channelIndices[channel.type].size();
+		channelIndices[channel.type].resize(block + maxChannel, -1);
+	}
+	channelIndices[channel.type][block + channel.channel] = channels.size();
+	channels.push_back(channel);
+	return true;
+}
+
+bool DAQChannelMap::read(const string& fileName) {
+	ifstream listFile(fileName);
+	if (!listFile) {
+		cerr << "DAQChannelMap: cannot open " << fileName << endl;
+		return false;
+	}
+	string line;
+	unsigned lineNumber = 0;
+	bool allGood = true;
+	while (getline(listFile, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+		istringstream lineStream(line);
+		Channel channel;
+		string typeName;
+		if (!(lineStream >> channel.name))
+			continue;
+		if (!(lineStream >> typeName >> channel.rocid >> channel.slot >> channel.channel)
+				|| !parseType(typeName, channel.type)) {
+			cerr << "DAQChannelMap: cannot read line " << lineNumber << " of "
+					<< fileName << endl;
+			allGood = false;
+			continue;
+		}
+		lineStream >> channel.threshold;
+		if (!addChannel(channel))
+			allGood = false;
+	}
+	cout << "DAQChannelMap: " << channels.size() << " channels from "
+			<< fileName << endl;
+	return allGood;
+}
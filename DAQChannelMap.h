@@ -0,0 +1,98 @@
+/*
+ * DAQChannelMap.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  List of the DAQ channels watched by the channel monitor. Every channel has
+ *  a name, a type (FADC for the FADC250, TDC for the F1TDC and CAEN TDC) and
+ *  its crate, slot and channel. The list is read from a text file with one
+ *  channel per line:
+ *
+ *     # name      type  rocid  slot  channel  [threshold]
+ *     COUNTER_1   FADC  31     5     0        200
+ *     COUNTER_1T  TDC   78     8     18
+ *
+ *  The channels are numbered in the order of the file. The number of a
+ *  channel is found from its address by direct indexing, first into a table
+ *  over all crates and slots and then into a block of channels that exists
+ *  only for the slots in the list.
+ */
+
+#ifndef DAQCHANNELMAP_H_
+#define DAQCHANNELMAP_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class DAQChannelMap {
+public:
+	enum ChannelType : uint8_t {
+		FADC = 0,
+		TDC = 1,
+		NUMBER_OF_TYPES
+	};
+
+	struct Channel {
+		std::string name;
+		ChannelType type = FADC;
+		uint32_t rocid = 0;
+		uint32_t slot = 0;
+		uint32_t channel = 0;
+		// Threshold of the FADC samples for the signal time, 0 for the default
+		unsigned threshold = 0;
+	};
+
+	// Largest addresses in the table
+	static const uint32_t maxRocid = 128;
+	static const uint32_t maxSlot = 32;
+	static const uint32_t maxChannel = 128;
+
+protected:
+	std::vector<Channel> channels;
+	// Start of the channel block of every crate and slot in channelIndices,
+	// -1 if no channel of the slot is in the list
+	std::vector<int32_t> slotBlocks[NUMBER_OF_TYPES];
+	// Channel number for every channel of the listed slots, -1 if not listed
+	std::vector<int32_t> channelIndices[NUMBER_OF_TYPES];
+
+public:
+	DAQChannelMap();
+	virtual ~DAQChannelMap() {
+	}
+
+	// Read the channel list from a file, false on errors
+	virtual bool read(const std::string& fileName);
+
+	// Add a channel, false if the address is out of range or already taken
+	virtual bool addChannel(const Channel& channel);
+
+	// Channel number for the address, -1 if it is not in the list
+	int find(ChannelType type, uint32_t rocid, uint32_t slot,
+			uint32_t channel) const {
+		if (rocid >= maxRocid || slot >= maxSlot || channel >= maxChannel)
+			return -1;
+		int32_t block = slotBlocks[type][rocid * maxSlot + slot];
+		if (block < 0)
+			return -1;
+		return channelIndices[type][block + channel];
+	}
+
+	const std::vector<Channel>& getChannels() const {
+		return channels;
+	}
+
+	size_t size() const {
+		return channels.size();
+	}
+
+	bool empty() const {
+		return channels.empty();
+	}
+
+	// Type from its name, false if the name is unknown
+	static bool parseType(const std::string& name, ChannelType& type);
+};
+
+#endif /* DAQCHANNELMAP_H_ */
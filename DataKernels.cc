@@ -0,0 +1,548 @@
+/*
+ * DataKernels.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DATAKERNELS_X86
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "DataKernels.h"
+
+using namespace std;
+
+namespace {
+
+struct KernelSet {
+	const char* name;
+	int (*getMinimum)(const int*, size_t);
+	void (*split)(const int*, size_t, int, uint16_t*, uint16_t*);
+	void (*pack)(const int*, size_t, int, char*, char*, int&, int&);
+	void (*packTile)(const uint16_t*, size_t, size_t, uint16_t*, uint8_t*,
+			uint8_t*, uint16_t*, uint16_t*);
+};
+
+const uint16_t noSample = 0xFFFF;
+
+// Scalar versions, also used for the samples left over by the vector loops
+
+int getMinimumScalar(const int* samples, size_t n) {
+	int minimum = samples[0];
+	for (size_t i = 1; i < n; i++)
+		minimum = min(minimum, samples[i]);
+	return minimum;
+}
+
+void splitScalar(const int* samples, size_t n, int minimum, uint16_t* low,
+		uint16_t* high) {
+	for (size_t i = 0; i < n; i++) {
+		uint16_t value = uint16_t(samples[i] - minimum);
+		low[i] = value & 0x000F;
+		high[i] = (value & 0x1FF0) >> 4;
+	}
+}
+
+// From sample begin on, begin even
+void packScalar(const int* samples, size_t begin, size_t n, int minimum,
+		char* nibbles, char* highBytes, int& first, int& last) {
+	for (size_t i = begin; i < n; i++) {
+		uint16_t value = uint16_t(samples[i] - minimum);
+		if (i % 2 == 0) {
+			// The low part of an unpaired last sample is not kept
+			if (i + 1 < n)
+				nibbles[i / 2] = char((value & 0x000F)
+						| ((uint16_t(samples[i + 1] - minimum) & 0x000F) << 4));
+		}
+		highBytes[i] = char((value & 0x1FF0) >> 4);
+		if ((value & 0x1FF0) != 0) {
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+}
+
+void packScalar(const int* samples, size_t n, int minimum, char* nibbles,
+		char* highBytes, int& first, int& last) {
+	first = last = -1;
+	packScalar(samples, 0, n, minimum, nibbles, highBytes, first, last);
+}
+
+// Lanes begin to end of the tile
+void packTileScalar(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		size_t begin, size_t end, uint16_t* minimums, uint8_t* nibbles,
+		uint8_t* highBytes, uint16_t* first, uint16_t* last) {
+	for (size_t lane = begin; lane < end; lane++) {
+		uint16_t minimum = noSample;
+		for (size_t i = 0; i < nSamples; i++)
+			minimum = min(minimum, tile[i * nLanes + lane]);
+		minimums[lane] = minimum;
+		first[lane] = last[lane] = noSample;
+		for (size_t i = 0; i < nSamples; i++) {
+			uint16_t value = tile[i * nLanes + lane] - minimum;
+			if (i % 2 == 1)
+				nibbles[(i / 2) * nLanes + lane] = ((tile[(i - 1) * nLanes + lane] - minimum) & 0x000F)
+						| ((value & 0x000F) << 4);
+			highBytes[i * nLanes + lane] = uint8_t((value & 0x1FF0) >> 4);
+			if ((value & 0x1FF0) != 0) {
+				if (first[lane] == noSample)
+					first[lane] = i;
+				last[lane] = i;
+			}
+		}
+	}
+}
+
+void packTileScalar(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last) {
+	packTileScalar(tile, nSamples, nLanes, 0, nLanes, minimums, nibbles,
+			highBytes, first, last);
+}
+
+const KernelSet scalarKernels = { "scalar", getMinimumScalar, splitScalar,
+		packScalar, packTileScalar };
+
+#ifdef DATAKERNELS_X86
+
+// Record the lanes of a mask of non-zero high parts starting at sample i
+inline void markNonZero(uint32_t nonZero, size_t i, int& first, int& last) {
+	if (nonZero == 0)
+		return;
+	if (first < 0)
+		first = i + __builtin_ctz(nonZero);
+	last = i + 31 - __builtin_clz(nonZero);
+}
+
+__attribute__((target("sse4.1")))
+int getMinimumSSE41(const int* samples, size_t n) {
+	if (n < 4)
+		return getMinimumScalar(samples, n);
+	__m128i minimum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+	size_t i = 4;
+	for (; i + 4 <= n; i += 4)
+		minimum = _mm_min_epi32(minimum,
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i)));
+	minimum = _mm_min_epi32(minimum, _mm_shuffle_epi32(minimum, 0x4E));
+	minimum = _mm_min_epi32(minimum, _mm_shuffle_epi32(minimum, 0xB1));
+	int result = _mm_cvtsi128_si32(minimum);
+	for (; i < n; i++)
+		result = min(result, samples[i]);
+	return result;
+}
+
+// Eight samples minus the minimum as 16-bit lanes, modulo 2^16
+__attribute__((target("sse4.1")))
+inline __m128i loadWords(const int* samples, __m128i minimum) {
+	const __m128i wordMask = _mm_set1_epi32(0xFFFF);
+	__m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+	__m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + 4));
+	first = _mm_and_si128(_mm_sub_epi32(first, minimum), wordMask);
+	second = _mm_and_si128(_mm_sub_epi32(second, minimum), wordMask);
+	return _mm_packus_epi32(first, second);
+}
+
+__attribute__((target("sse4.1")))
+void splitSSE41(const int* samples, size_t n, int minimum, uint16_t* low,
+		uint16_t* high) {
+	const __m128i minimums = _mm_set1_epi32(minimum);
+	const __m128i lowMask = _mm_set1_epi16(0x000F);
+	const __m128i highMask = _mm_set1_epi16(0x1FF0);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i words = loadWords(samples + i, minimums);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(low + i), _mm_and_si128(words, lowMask));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(high + i),
+				_mm_srli_epi16(_mm_and_si128(words, highMask), 4));
+	}
+	splitScalar(samples + i, n - i, minimum, low + i, high + i);
+}
+
+__attribute__((target("sse4.1")))
+void packSSE41(const int* samples, size_t n, int minimum, char* nibbles,
+		char* highBytes, int& first, int& last) {
+	const __m128i minimums = _mm_set1_epi32(minimum);
+	const __m128i lowMask = _mm_set1_epi16(0x000F);
+	const __m128i highMask = _mm_set1_epi16(0x1FF0);
+	const __m128i byteMask = _mm_set1_epi16(0x00FF);
+	const __m128i pairMask = _mm_set1_epi32(0x00FF);
+	const __m128i zero = _mm_setzero_si128();
+	first = last = -1;
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i words0 = loadWords(samples + i, minimums);
+		__m128i words1 = loadWords(samples + i + 8, minimums);
+		// A pair of low parts is one 32-bit lane, the odd one moves next to the even one
+		__m128i low0 = _mm_and_si128(words0, lowMask);
+		__m128i low1 = _mm_and_si128(words1, lowMask);
+		__m128i pairs0 = _mm_and_si128(_mm_or_si128(low0, _mm_srli_epi32(low0, 12)), pairMask);
+		__m128i pairs1 = _mm_and_si128(_mm_or_si128(low1, _mm_srli_epi32(low1, 12)), pairMask);
+		__m128i packed = _mm_packus_epi16(_mm_packus_epi32(pairs0, pairs1), zero);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(nibbles + i / 2), packed);
+
+		__m128i high0 = _mm_and_si128(words0, highMask);
+		__m128i high1 = _mm_and_si128(words1, highMask);
+		__m128i bytes = _mm_packus_epi16(
+				_mm_and_si128(_mm_srli_epi16(high0, 4), byteMask),
+				_mm_and_si128(_mm_srli_epi16(high1, 4), byteMask));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(highBytes + i), bytes);
+
+		__m128i isZero = _mm_packs_epi16(_mm_cmpeq_epi16(high0, zero),
+				_mm_cmpeq_epi16(high1, zero));
+		markNonZero(~uint32_t(_mm_movemask_epi8(isZero)) & 0xFFFF, i, first, last);
+	}
+	packScalar(samples, i, n, minimum, nibbles, highBytes, first, last);
+}
+
+// Eight lanes from lane on, one sample row at a time
+__attribute__((target("sse4.1")))
+void packLanesSSE41(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		size_t lane, uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last) {
+	const __m128i lowMask = _mm_set1_epi16(0x000F);
+	const __m128i highMask = _mm_set1_epi16(0x1FF0);
+	const __m128i byteMask = _mm_set1_epi16(0x00FF);
+	const __m128i none = _mm_set1_epi16(-1);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i minimum = none;
+	for (size_t i = 0; i < nSamples; i++)
+		minimum = _mm_min_epu16(minimum,
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + i * nLanes + lane)));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(minimums + lane), minimum);
+	__m128i firstSample = none, lastSample = none, evenLow = zero;
+	for (size_t i = 0; i < nSamples; i++) {
+		__m128i value = _mm_sub_epi16(_mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(tile + i * nLanes + lane)), minimum);
+		if (i % 2 == 0) {
+			evenLow = _mm_and_si128(value, lowMask);
+		} else {
+			__m128i pair = _mm_or_si128(evenLow, _mm_slli_epi16(_mm_and_si128(value, lowMask), 4));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(nibbles + (i / 2) * nLanes + lane),
+					_mm_packus_epi16(pair, zero));
+		}
+		__m128i high = _mm_and_si128(value, highMask);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(highBytes + i * nLanes + lane),
+				_mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(high, 4), byteMask), zero));
+		__m128i nonZero = _mm_xor_si128(_mm_cmpeq_epi16(high, zero), none);
+		__m128i index = _mm_set1_epi16(short(i));
+		firstSample = _mm_blendv_epi8(firstSample, index,
+				_mm_and_si128(nonZero, _mm_cmpeq_epi16(firstSample, none)));
+		lastSample = _mm_blendv_epi8(lastSample, index, nonZero);
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(first + lane), firstSample);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(last + lane), lastSample);
+}
+
+__attribute__((target("sse4.1")))
+void packTileSSE41(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last) {
+	for (size_t lane = 0; lane + 8 <= nLanes; lane += 8)
+		packLanesSSE41(tile, nSamples, nLanes, lane, minimums, nibbles,
+				highBytes, first, last);
+	packTileScalar(tile, nSamples, nLanes, nLanes - nLanes % 8, nLanes,
+			minimums, nibbles, highBytes, first, last);
+}
+
+const KernelSet sse41Kernels = { "sse4.1", getMinimumSSE41, splitSSE41,
+		packSSE41, packTileSSE41 };
+
+__attribute__((target("avx2")))
+int getMinimumAVX2(const int* samples, size_t n) {
+	if (n < 8)
+		return getMinimumScalar(samples, n);
+	__m256i minimum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples));
+	size_t i = 8;
+	for (; i + 8 <= n; i += 8)
+		minimum = _mm256_min_epi32(minimum,
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i)));
+	__m128i half = _mm_min_epi32(_mm256_castsi256_si128(minimum),
+			_mm256_extracti128_si256(minimum, 1));
+	half = _mm_min_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+	half = _mm_min_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+	int result = _mm_cvtsi128_si32(half);
+	for (; i < n; i++)
+		result = min(result, samples[i]);
+	return result;
+}
+
+// Sixteen samples minus the minimum as 16-bit lanes in order, modulo 2^16
+__attribute__((target("avx2")))
+inline __m256i loadWords(const int* samples, __m256i minimum) {
+	const __m256i wordMask = _mm256_set1_epi32(0xFFFF);
+	__m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples));
+	__m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + 8));
+	first = _mm256_and_si256(_mm256_sub_epi32(first, minimum), wordMask);
+	second = _mm256_and_si256(_mm256_sub_epi32(second, minimum), wordMask);
+	// The packs work within 128-bit lanes, the quarters are put back in order
+	return _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), 0xD8);
+}
+
+__attribute__((target("avx2")))
+void splitAVX2(const int* samples, size_t n, int minimum, uint16_t* low,
+		uint16_t* high) {
+	const __m256i minimums = _mm256_set1_epi32(minimum);
+	const __m256i lowMask = _mm256_set1_epi16(0x000F);
+	const __m256i highMask = _mm256_set1_epi16(0x1FF0);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256i words = loadWords(samples + i, minimums);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(low + i), _mm256_and_si256(words, lowMask));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(high + i),
+				_mm256_srli_epi16(_mm256_and_si256(words, highMask), 4));
+	}
+	splitSSE41(samples + i, n - i, minimum, low + i, high + i);
+}
+
+__attribute__((target("avx2")))
+void packAVX2(const int* samples, size_t n, int minimum, char* nibbles,
+		char* highBytes, int& first, int& last) {
+	const __m256i minimums = _mm256_set1_epi32(minimum);
+	const __m256i lowMask = _mm256_set1_epi16(0x000F);
+	const __m256i highMask = _mm256_set1_epi16(0x1FF0);
+	const __m256i byteMask = _mm256_set1_epi16(0x00FF);
+	const __m256i pairMask = _mm256_set1_epi32(0x00FF);
+	const __m256i zero = _mm256_setzero_si256();
+	first = last = -1;
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256i words0 = loadWords(samples + i, minimums);
+		__m256i words1 = loadWords(samples + i + 16, minimums);
+		__m256i low0 = _mm256_and_si256(words0, lowMask);
+		__m256i low1 = _mm256_and_si256(words1, lowMask);
+		__m256i pairs0 = _mm256_and_si256(_mm256_or_si256(low0, _mm256_srli_epi32(low0, 12)), pairMask);
+		__m256i pairs1 = _mm256_and_si256(_mm256_or_si256(low1, _mm256_srli_epi32(low1, 12)), pairMask);
+		__m256i pairWords = _mm256_permute4x64_epi64(_mm256_packus_epi32(pairs0, pairs1), 0xD8);
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairWords, zero), 0xD8);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(nibbles + i / 2),
+				_mm256_castsi256_si128(packed));
+
+		__m256i high0 = _mm256_and_si256(words0, highMask);
+		__m256i high1 = _mm256_and_si256(words1, highMask);
+		__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(
+				_mm256_and_si256(_mm256_srli_epi16(high0, 4), byteMask),
+				_mm256_and_si256(_mm256_srli_epi16(high1, 4), byteMask)), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(highBytes + i), bytes);
+
+		__m256i isZero = _mm256_permute4x64_epi64(_mm256_packs_epi16(
+				_mm256_cmpeq_epi16(high0, zero), _mm256_cmpeq_epi16(high1, zero)), 0xD8);
+		markNonZero(~uint32_t(_mm256_movemask_epi8(isZero)), i, first, last);
+	}
+	packScalar(samples, i, n, minimum, nibbles, highBytes, first, last);
+}
+
+// Sixteen lanes from lane on, one sample row at a time
+__attribute__((target("avx2")))
+void packLanesAVX2(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		size_t lane, uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last) {
+	const __m256i lowMask = _mm256_set1_epi16(0x000F);
+	const __m256i highMask = _mm256_set1_epi16(0x1FF0);
+	const __m256i byteMask = _mm256_set1_epi16(0x00FF);
+	const __m256i none = _mm256_set1_epi16(-1);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i minimum = none;
+	for (size_t i = 0; i < nSamples; i++)
+		minimum = _mm256_min_epu16(minimum,
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tile + i * nLanes + lane)));
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(minimums + lane), minimum);
+	__m256i firstSample = none, lastSample = none, evenLow = zero;
+	for (size_t i = 0; i < nSamples; i++) {
+		__m256i value = _mm256_sub_epi16(_mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(tile + i * nLanes + lane)), minimum);
+		if (i % 2 == 0) {
+			evenLow = _mm256_and_si256(value, lowMask);
+		} else {
+			__m256i pair = _mm256_or_si256(evenLow,
+					_mm256_slli_epi16(_mm256_and_si256(value, lowMask), 4));
+			__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(pair, zero), 0xD8);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(nibbles + (i / 2) * nLanes + lane),
+					_mm256_castsi256_si128(bytes));
+		}
+		__m256i high = _mm256_and_si256(value, highMask);
+		__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(
+				_mm256_and_si256(_mm256_srli_epi16(high, 4), byteMask), zero), 0xD8);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(highBytes + i * nLanes + lane),
+				_mm256_castsi256_si128(bytes));
+		__m256i nonZero = _mm256_xor_si256(_mm256_cmpeq_epi16(high, zero), none);
+		__m256i index = _mm256_set1_epi16(short(i));
+		firstSample = _mm256_blendv_epi8(firstSample, index,
+				_mm256_and_si256(nonZero, _mm256_cmpeq_epi16(firstSample, none)));
+		lastSample = _mm256_blendv_epi8(lastSample, index, nonZero);
+	}
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(first + lane), firstSample);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(last + lane), lastSample);
+}
+
+__attribute__((target("avx2")))
+void packTileAVX2(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last) {
+	size_t lane = 0;
+	for (; lane + 16 <= nLanes; lane += 16)
+		packLanesAVX2(tile, nSamples, nLanes, lane, minimums, nibbles,
+				highBytes, first, last);
+	for (; lane + 8 <= nLanes; lane += 8)
+		packLanesSSE41(tile, nSamples, nLanes, lane, minimums, nibbles,
+				highBytes, first, last);
+	packTileScalar(tile, nSamples, nLanes, lane, nLanes, minimums, nibbles,
+			highBytes, first, last);
+}
+
+const KernelSet avx2Kernels = { "avx2", getMinimumAVX2, splitAVX2, packAVX2,
+		packTileAVX2 };
+
+#endif
+
+const KernelSet* findKernels(const string& name) {
+#ifdef DATAKERNELS_X86
+	__builtin_cpu_init();
+	if (name == "avx2" && __builtin_cpu_supports("avx2"))
+		return &avx2Kernels;
+	if (name == "sse4.1" && __builtin_cpu_supports("sse4.1"))
+		return &sse41Kernels;
+#endif
+	if (name == "scalar")
+		return &scalarKernels;
+	return nullptr;
+}
+
+const KernelSet* chooseKernels() {
+	for (const char* name : { "avx2", "sse4.1" }) {
+		const KernelSet* kernels = findKernels(name);
+		if (kernels != nullptr)
+			return kernels;
+	}
+	return &scalarKernels;
+}
+
+// Chosen when the library is loaded
+const KernelSet* kernelSet = chooseKernels();
+
+}
+
+namespace DataKernels {
+
+// The transposes use SSE2 only, which every x86-64 CPU has
+
+void fillTile(const uint16_t* const * waveforms, size_t nWaveforms,
+		size_t nSamples, size_t nLanes, uint16_t* tile) {
+	size_t lane = 0;
+	size_t i = 0;
+#ifdef __SSE2__
+	// Blocks of 8 waveforms by 8 samples
+	for (; lane + 8 <= nWaveforms; lane += 8) {
+		for (i = 0; i + 8 <= nSamples; i += 8) {
+			__m128i rows[8];
+			for (unsigned row = 0; row < 8; row++)
+				rows[row] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(waveforms[lane + row] + i));
+			__m128i pairs[8], quads[8];
+			for (unsigned row = 0; row < 8; row += 2) {
+				pairs[row] = _mm_unpacklo_epi16(rows[row], rows[row + 1]);
+				pairs[row + 1] = _mm_unpackhi_epi16(rows[row], rows[row + 1]);
+			}
+			for (unsigned row = 0; row < 8; row += 4) {
+				quads[row] = _mm_unpacklo_epi32(pairs[row], pairs[row + 2]);
+				quads[row + 1] = _mm_unpackhi_epi32(pairs[row], pairs[row + 2]);
+				quads[row + 2] = _mm_unpacklo_epi32(pairs[row + 1], pairs[row + 3]);
+				quads[row + 3] = _mm_unpackhi_epi32(pairs[row + 1], pairs[row + 3]);
+			}
+			for (unsigned column = 0; column < 4; column++) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(tile + (i + 2 * column) * nLanes + lane),
+						_mm_unpacklo_epi64(quads[column], quads[column + 4]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(tile + (i + 2 * column + 1) * nLanes + lane),
+						_mm_unpackhi_epi64(quads[column], quads[column + 4]));
+			}
+		}
+		for (; i < nSamples; i++)
+			for (unsigned row = 0; row < 8; row++)
+				tile[i * nLanes + lane + row] = waveforms[lane + row][i];
+	}
+#endif
+	for (; lane < nLanes; lane++) {
+		const uint16_t* samples = waveforms[min(lane, nWaveforms - 1)];
+		for (i = 0; i < nSamples; i++)
+			tile[i * nLanes + lane] = samples[i];
+	}
+}
+
+void readTile(const uint8_t* tile, size_t nRows, size_t nLanes,
+		size_t nWaveforms, uint8_t* waveformBytes) {
+	size_t lane = 0;
+#ifdef __SSE2__
+	// Blocks of 8 lanes by 8 rows
+	for (; lane + 8 <= nWaveforms; lane += 8) {
+		size_t i = 0;
+		for (; i + 8 <= nRows; i += 8) {
+			__m128i rows[8];
+			for (unsigned row = 0; row < 8; row++)
+				rows[row] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tile + (i + row) * nLanes + lane));
+			__m128i pairs[4], quads[4];
+			for (unsigned row = 0; row < 4; row++)
+				pairs[row] = _mm_unpacklo_epi8(rows[2 * row], rows[2 * row + 1]);
+			quads[0] = _mm_unpacklo_epi16(pairs[0], pairs[1]);
+			quads[1] = _mm_unpackhi_epi16(pairs[0], pairs[1]);
+			quads[2] = _mm_unpacklo_epi16(pairs[2], pairs[3]);
+			quads[3] = _mm_unpackhi_epi16(pairs[2], pairs[3]);
+			__m128i columns[4] = { _mm_unpacklo_epi32(quads[0], quads[2]),
+					_mm_unpackhi_epi32(quads[0], quads[2]),
+					_mm_unpacklo_epi32(quads[1], quads[3]),
+					_mm_unpackhi_epi32(quads[1], quads[3]) };
+			for (unsigned column = 0; column < 4; column++) {
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(waveformBytes + (lane + 2 * column) * nRows + i),
+						columns[column]);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(waveformBytes + (lane + 2 * column + 1) * nRows + i),
+						_mm_unpackhi_epi64(columns[column], columns[column]));
+			}
+		}
+		for (; i < nRows; i++)
+			for (unsigned column = 0; column < 8; column++)
+				waveformBytes[(lane + column) * nRows + i] = tile[i * nLanes + lane + column];
+	}
+#endif
+	for (; lane < nWaveforms; lane++)
+		for (size_t i = 0; i < nRows; i++)
+			waveformBytes[lane * nRows + i] = tile[i * nLanes + lane];
+}
+
+int getMinimum(const int* samples, size_t n) {
+	return kernelSet->getMinimum(samples, n);
+}
+
+void split(const int* samples, size_t n, int minimum, uint16_t* low,
+		uint16_t* high) {
+	kernelSet->split(samples, n, minimum, low, high);
+}
+
+void pack(const int* samples, size_t n, int minimum, char* nibbles,
+		char* highBytes, int& first, int& last) {
+	kernelSet->pack(samples, n, minimum, nibbles, highBytes, first, last);
+}
+
+void packTile(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last) {
+	kernelSet->packTile(tile, nSamples, nLanes, minimums, nibbles, highBytes,
+			first, last);
+}
+
+const char* getKernelName() {
+	return kernelSet->name;
+}
+
+bool selectKernels(const string& name) {
+	const KernelSet* kernels = findKernels(name);
+	if (kernels == nullptr)
+		return false;
+	kernelSet = kernels;
+	return true;
+}
+
+}
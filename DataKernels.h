@@ -0,0 +1,67 @@
+/*
+ * DataKernels.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Vectorized kernels of the waveform encoder of data::data. The running sum
+ *  of decompose() followed by its first differences gives back the samples
+ *  minus their minimum modulo 2^16, so the kernels go straight from the samples
+ *  to the 4-bit and 9-bit parts on 16-bit lanes. The kernel set is chosen once
+ *  from the CPU: AVX2, SSE4.1 or scalar code on any other machine. The output
+ *  is the same with all of them.
+ */
+
+#ifndef DATAKERNELS_H_
+#define DATAKERNELS_H_
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+namespace DataKernels {
+
+// Minimum of n > 0 samples
+int getMinimum(const int* samples, size_t n);
+
+// The samples minus the minimum, modulo 2^16, split into bits 0-3 (low) and
+// bits 4-12 (high), as data::decompose() returns them
+void split(const int* samples, size_t n, int minimum, uint16_t* low,
+		uint16_t* high);
+
+// The encoder layout of the split: the low parts of sample pairs packed into
+// n / 2 bytes, the first in the low nibble, and the high parts truncated to a
+// byte each. first and last are the first and last sample with a non-zero
+// high part, -1 if there is none.
+void pack(const int* samples, size_t n, int minimum, char* nibbles,
+		char* highBytes, int& first, int& last);
+
+// The same as pack() for a tile of waveforms of nSamples samples each, in
+// structure-of-arrays layout: sample i of waveform w is tile[i * nLanes + w],
+// nLanes a multiple of 8. Every waveform is a lane of the vector
+// instructions. The outputs have the same layout: the minimums per lane, the
+// nibble bytes at [j * nLanes + w] for j < nSamples / 2, the high bytes at
+// [i * nLanes + w], and first and last per lane, 0xFFFF if there is none.
+void packTile(const uint16_t* tile, size_t nSamples, size_t nLanes,
+		uint16_t* minimums, uint8_t* nibbles, uint8_t* highBytes,
+		uint16_t* first, uint16_t* last);
+
+// Transpose nWaveforms <= nLanes waveforms of nSamples samples into a tile of
+// nLanes lanes. The lanes past nWaveforms repeat the last waveform.
+void fillTile(const uint16_t* const * waveforms, size_t nWaveforms,
+		size_t nSamples, size_t nLanes, uint16_t* tile);
+
+// Transpose the first nWaveforms lanes of a byte tile of nRows rows back,
+// row i of lane w goes to waveformBytes[w * nRows + i]
+void readTile(const uint8_t* tile, size_t nRows, size_t nLanes,
+		size_t nWaveforms, uint8_t* waveformBytes);
+
+// Name of the kernel set in use, "avx2", "sse4.1" or "scalar"
+const char* getKernelName();
+// Use another kernel set, for tests and benchmarks. Returns false if the CPU
+// does not support it. Not to be called while the kernels are in use.
+bool selectKernels(const std::string& name);
+
+}
+
+#endif /* DATAKERNELS_H_ */
@@ -0,0 +1,212 @@
+/*
+ * HistogramDeltaProtocol.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Wire format used between HistogramDeltaPublisher in the plugin and the
+ *  tac_aggregator daemon. Every message is a frame of
+ *
+ *     uint32 payload length | uint8 message type | payload
+ *
+ *  HELLO    : source name, run number. Starts a new stream from a source, the
+ *             aggregator drops whatever it had from the same source and run.
+ *  RUN      : run number. The following messages go to the stream of this
+ *             run, started by an earlier HELLO on the same connection.
+ *  DEFINE   : histogram id, name, title, axis titles and binning
+ *  DELTA    : histogram id, entries change, number of changed cells and the
+ *             changed cells as (index increment, value change) pairs
+ *
+ *  Integers are LEB128 varints, signed ones are zigzag encoded. Cell changes
+ *  are sent as varints when they are all integer, as raw doubles otherwise.
+ */
+
+#ifndef HISTOGRAMDELTAPROTOCOL_H_
+#define HISTOGRAMDELTAPROTOCOL_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+namespace HistogramDeltaProtocol {
+
+enum MessageType : uint8_t {
+	MSG_HELLO = 1,
+	MSG_DEFINE = 2,
+	MSG_DELTA = 3,
+	MSG_RUN = 4
+};
+
+enum CellEncoding : uint8_t {
+	CELLS_VARINT = 0,
+	CELLS_DOUBLE = 1
+};
+
+// Size of the frame header (length and type)
+static const size_t frameHeaderSize = 5;
+// Largest payload accepted by the aggregator
+static const uint32_t maxPayloadSize = 64 * 1024 * 1024;
+
+// Binning and labels of a histogram as sent in a DEFINE message
+struct HistogramDefinition {
+	uint32_t id = 0;
+	std::string name;
+	std::string title;
+	std::string xTitle;
+	std::string yTitle;
+	uint32_t dimension = 1;
+	uint32_t nBinsX = 0;
+	double xMin = 0;
+	double xMax = 0;
+	uint32_t nBinsY = 0;
+	double yMin = 0;
+	double yMax = 0;
+
+	// Number of cells including underflow and overflow bins
+	size_t getNumberOfCells() const {
+		if (dimension == 2)
+			return size_t(nBinsX + 2) * size_t(nBinsY + 2);
+		return nBinsX + 2;
+	}
+};
+
+class Writer {
+protected:
+	std::vector<char>& buffer;
+	size_t frameStart;
+
+public:
+	// Start a new frame of the given type at the end of the buffer
+	Writer(std::vector<char>& buf, MessageType type) :
+			buffer(buf), frameStart(buf.size()) {
+		buffer.resize(frameStart + frameHeaderSize);
+		buffer[frameStart + 4] = char(type);
+	}
+	// Fill in the payload length of the frame
+	void finish() {
+		uint32_t length = buffer.size() - frameStart - frameHeaderSize;
+		memcpy(&buffer[frameStart], &length, sizeof(length));
+	}
+
+	void putVarint(uint64_t value) {
+		while (value >= 0x80) {
+			buffer.push_back(char((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		buffer.push_back(char(value));
+	}
+	void putSigned(int64_t value) {
+		putVarint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+	}
+	void putDouble(double value) {
+		size_t pos = buffer.size();
+		buffer.resize(pos + sizeof(value));
+		memcpy(&buffer[pos], &value, sizeof(value));
+	}
+	void putString(const std::string& value) {
+		putVarint(value.size());
+		buffer.insert(buffer.end(), value.begin(), value.end());
+	}
+	void putDefinition(const HistogramDefinition& def) {
+		putVarint(def.id);
+		putString(def.name);
+		putString(def.title);
+		putString(def.xTitle);
+		putString(def.yTitle);
+		putVarint(def.dimension);
+		putVarint(def.nBinsX);
+		putDouble(def.xMin);
+		putDouble(def.xMax);
+		putVarint(def.nBinsY);
+		putDouble(def.yMin);
+		putDouble(def.yMax);
+	}
+};
+
+class Reader {
+protected:
+	const char* current;
+	const char* end;
+	bool valid = true;
+
+public:
+	Reader(const char* payload, size_t length) :
+			current(payload), end(payload + length) {
+	}
+
+	// False once a read went past the end of the payload
+	bool isValid() const {
+		return valid;
+	}
+	bool atEnd() const {
+		return current >= end;
+	}
+
+	uint64_t getVarint() {
+		uint64_t value = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			if (current >= end) {
+				valid = false;
+				return 0;
+			}
+			uint8_t byte = uint8_t(*current++);
+			value |= uint64_t(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+		valid = false;
+		return value;
+	}
+	int64_t getSigned() {
+		uint64_t value = getVarint();
+		return int64_t(value >> 1) ^ -int64_t(value & 1);
+	}
+	double getDouble() {
+		double value = 0;
+		if (end - current < std::ptrdiff_t(sizeof(value))) {
+			valid = false;
+			return value;
+		}
+		memcpy(&value, current, sizeof(value));
+		current += sizeof(value);
+		return value;
+	}
+	std::string getString() {
+		uint64_t length = getVarint();
+		if (uint64_t(end - current) < length) {
+			valid = false;
+			return std::string();
+		}
+		std::string value(current, length);
+		current += length;
+		return value;
+	}
+	HistogramDefinition getDefinition() {
+		HistogramDefinition def;
+		def.id = getVarint();
+		def.name = getString();
+		def.title = getString();
+		def.xTitle = getString();
+		def.yTitle = getString();
+		def.dimension = getVarint();
+		def.nBinsX = getVarint();
+		def.xMin = getDouble();
+		def.xMax = getDouble();
+		def.nBinsY = getVarint();
+		def.yMin = getDouble();
+		def.yMax = getDouble();
+		return def;
+	}
+};
+
+// True if the value can be sent as a varint without loss
+inline bool isIntegral(double value) {
+	return value == std::floor(value) && std::fabs(value) < 9.0e15;
+}
+
+}
+
+#endif /* HISTOGRAMDELTAPROTOCOL_H_ */
@@ -0,0 +1,299 @@
+/*
+ * HistogramDeltaPublisher.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "TArrayD.h"
+
+#include "HistogramDeltaPublisher.h"
+
+using namespace std;
+using namespace HistogramDeltaProtocol;
+
+HistogramDeltaPublisher::HistogramDeltaPublisher(string addr,
+		const HistogramVersions& histogramVersions) :
+		address(addr), versions(histogramVersions), totalBytesSent(0) {
+	char hostName[256] = "localhost";
+	gethostname(hostName, sizeof(hostName) - 1);
+	stringstream nameStream;
+	nameStream << hostName << ":" << getpid();
+	sourceName = nameStream.str();
+	senderThread = thread(&HistogramDeltaPublisher::sendLoop, this);
+}
+
+// What was queued before is still sent
+HistogramDeltaPublisher::~HistogramDeltaPublisher() {
+	{
+		lock_guard<mutex> queueGuard(queueMutex);
+		stopSender = true;
+	}
+	queueCondition.notify_all();
+	senderThread.join();
+	closeSocket();
+	if (nDroppedPushes > 0)
+		cout << "Dropped " << nDroppedPushes
+				<< " TAC histogram pushes the aggregator could not keep up with" << endl;
+}
+
+void HistogramDeltaPublisher::forgetRun(int32_t runNumber) {
+	lock_guard<mutex> guard(publishMutex);
+	runStreams.erase(runNumber);
+	// A run with the same number starts over with a HELLO
+	if (hasStreamRun && streamRun == runNumber)
+		hasStreamRun = false;
+}
+
+// The address is either a path to a Unix domain socket or host:port
+bool HistogramDeltaPublisher::connectSocket() {
+	auto colonPos = address.find_last_of(':');
+	if (colonPos != string::npos && address.find('/') == string::npos) {
+		socketFD = socket(AF_INET, SOCK_STREAM, 0);
+		if (socketFD < 0)
+			return false;
+		sockaddr_in inetAddress = { };
+		inetAddress.sin_family = AF_INET;
+		inetAddress.sin_port = htons(atoi(address.substr(colonPos + 1).c_str()));
+		string host = address.substr(0, colonPos);
+		if (host.empty() || host == "localhost")
+			host = "127.0.0.1";
+		if (inet_pton(AF_INET, host.c_str(), &inetAddress.sin_addr) != 1
+				|| connect(socketFD, reinterpret_cast<sockaddr*>(&inetAddress),
+						sizeof(inetAddress)) != 0) {
+			closeSocket();
+			return false;
+		}
+		int noDelay = 1;
+		setsockopt(socketFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	} else {
+		socketFD = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (socketFD < 0)
+			return false;
+		sockaddr_un unixAddress = { };
+		unixAddress.sun_family = AF_UNIX;
+		address.copy(unixAddress.sun_path, sizeof(unixAddress.sun_path) - 1);
+		if (connect(socketFD, reinterpret_cast<sockaddr*>(&unixAddress),
+				sizeof(unixAddress)) != 0) {
+			closeSocket();
+			return false;
+		}
+	}
+	// A stuck aggregator counts as a lost connection
+	timeval timeout = { 1, 0 };
+	setsockopt(socketFD, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	cout << "Publishing TAC histogram deltas to " << address << endl;
+	return true;
+}
+
+void HistogramDeltaPublisher::closeSocket() {
+	if (socketFD >= 0)
+		close(socketFD);
+	socketFD = -1;
+}
+
+void HistogramDeltaPublisher::resetState() {
+	runStreams.clear();
+	hasStreamRun = false;
+	sendBuffer.clear();
+}
+
+void HistogramDeltaPublisher::collect(int32_t runNumber,
+		const vector<TH1*>& histograms) {
+	{
+		lock_guard<mutex> queueGuard(queueMutex);
+		if (!connected)
+			return;
+		if (streamLost) {
+			streamLost = false;
+			resetState();
+		}
+	}
+	auto streamIter = runStreams.find(runNumber);
+	if (streamIter == runStreams.end()) {
+		Writer hello(sendBuffer, MSG_HELLO);
+		hello.putString(sourceName);
+		hello.putSigned(runNumber);
+		hello.finish();
+		streamIter = runStreams.insert(make_pair(runNumber, RunStream())).first;
+	} else if (!hasStreamRun || streamRun != runNumber) {
+		Writer runWriter(sendBuffer, MSG_RUN);
+		runWriter.putSigned(runNumber);
+		runWriter.finish();
+	}
+	streamRun = runNumber;
+	hasStreamRun = true;
+	for (TH1* histo : histograms)
+		collectHistogram(streamIter->second, histo);
+}
+
+void HistogramDeltaPublisher::collectHistogram(RunStream& stream, TH1* histo) {
+	auto& histograms = stream.histograms;
+	auto& histogramIndex = stream.histogramIndex;
+	auto indexIter = histogramIndex.find(histo);
+	if (indexIter == histogramIndex.end()) {
+		// First time we see this histogram, send its definition
+		PublishedHistogram published;
+		published.histo = histo;
+		HistogramDefinition& def = published.definition;
+		def.id = histograms.size();
+		def.name = histo->GetName();
+		def.title = histo->GetTitle();
+		def.xTitle = histo->GetXaxis()->GetTitle();
+		def.yTitle = histo->GetYaxis()->GetTitle();
+		def.dimension = histo->GetDimension() == 2 ? 2 : 1;
+		def.nBinsX = histo->GetNbinsX();
+		def.xMin = histo->GetXaxis()->GetXmin();
+		def.xMax = histo->GetXaxis()->GetXmax();
+		if (def.dimension == 2) {
+			def.nBinsY = histo->GetNbinsY();
+			def.yMin = histo->GetYaxis()->GetXmin();
+			def.yMax = histo->GetYaxis()->GetXmax();
+		}
+		published.lastSent.assign(def.getNumberOfCells(), 0.0);
+
+		Writer writer(sendBuffer, MSG_DEFINE);
+		writer.putDefinition(def);
+		writer.finish();
+
+		indexIter = histogramIndex.insert(make_pair(histo, def.id)).first;
+		histograms.push_back(std::move(published));
+	}
+	PublishedHistogram& published = histograms[indexIter->second];
+
+	UInt_t version = versions.get(histo);
+	if (version == published.version)
+		return;
+	double entries = histo->GetEntries();
+
+	changedCells.clear();
+	changedValues.clear();
+	bool allIntegral = true;
+	size_t nCells = published.lastSent.size();
+	const TArrayD* cellArray = dynamic_cast<const TArrayD*>(histo);
+	for (size_t iCell = 0; iCell < nCells; iCell++) {
+		double content =
+				cellArray != nullptr ?
+						cellArray->fArray[iCell] : histo->GetBinContent(iCell);
+		double change = content - published.lastSent[iCell];
+		if (change != 0) {
+			changedCells.push_back(iCell);
+			changedValues.push_back(change);
+			allIntegral = allIntegral && isIntegral(change);
+			published.lastSent[iCell] = content;
+		}
+	}
+
+	Writer writer(sendBuffer, MSG_DELTA);
+	writer.putVarint(published.definition.id);
+	writer.putDouble(entries - published.lastEntries);
+	writer.putVarint(allIntegral ? CELLS_VARINT : CELLS_DOUBLE);
+	writer.putVarint(changedCells.size());
+	uint32_t previousCell = 0;
+	for (size_t iChange = 0; iChange < changedCells.size(); iChange++) {
+		writer.putVarint(changedCells[iChange] - previousCell);
+		previousCell = changedCells[iChange];
+		if (allIntegral)
+			writer.putSigned(int64_t(changedValues[iChange]));
+		else
+			writer.putDouble(changedValues[iChange]);
+	}
+	writer.finish();
+	published.lastEntries = entries;
+	published.version = version;
+	totalCellsSent += changedCells.size();
+}
+
+bool HistogramDeltaPublisher::send() {
+	if (sendBuffer.empty())
+		return false;
+	{
+		lock_guard<mutex> queueGuard(queueMutex);
+		if (streamLost) {
+			// The next collect() starts over with a HELLO anyway
+			sendBuffer.clear();
+			return false;
+		}
+		if (pendingBuffer.size() + sendBuffer.size() > maxPendingBytes) {
+			// The aggregator does not keep up, drop everything and start over
+			pendingBuffer.clear();
+			sendBuffer.clear();
+			streamLost = true;
+			nDroppedPushes++;
+			return false;
+		}
+		if (pendingBuffer.empty())
+			pendingBuffer.swap(sendBuffer);
+		else
+			pendingBuffer.insert(pendingBuffer.end(), sendBuffer.begin(),
+					sendBuffer.end());
+		sendBuffer.clear();
+	}
+	queueCondition.notify_one();
+	return true;
+}
+
+bool HistogramDeltaPublisher::writeSocket(const vector<char>& buffer) {
+	size_t nSent = 0;
+	while (nSent < buffer.size()) {
+		ssize_t nBytes = ::send(socketFD, &buffer[nSent], buffer.size() - nSent,
+				MSG_NOSIGNAL);
+		if (nBytes <= 0)
+			return false;
+		nSent += nBytes;
+	}
+	totalBytesSent += nSent;
+	return true;
+}
+
+// Connects, retrying every second, and writes whatever send() queued. The
+// queue lock is never held while the socket is used.
+void HistogramDeltaPublisher::sendLoop() {
+	vector<char> outBuffer;
+	unique_lock<mutex> queueLock(queueMutex);
+	while (true) {
+		if (socketFD < 0) {
+			if (stopSender)
+				break;
+			queueLock.unlock();
+			bool isConnected = connectSocket();
+			queueLock.lock();
+			if (!isConnected) {
+				queueCondition.wait_for(queueLock, chrono::seconds(1),
+						[this] {return stopSender;});
+				continue;
+			}
+			connected = true;
+		}
+		queueCondition.wait(queueLock,
+				[this] {return stopSender || !pendingBuffer.empty();});
+		if (pendingBuffer.empty())
+			break;
+		outBuffer.swap(pendingBuffer);
+		queueLock.unlock();
+		bool isSent = writeSocket(outBuffer);
+		outBuffer.clear();
+		queueLock.lock();
+		if (!isSent) {
+			cout << "Lost connection to TAC aggregator at " << address << endl;
+			// The aggregator drops our partial stream when we say HELLO again
+			closeSocket();
+			connected = false;
+			streamLost = true;
+			pendingBuffer.clear();
+		}
+	}
+}
@@ -0,0 +1,148 @@
+/*
+ * HistogramDeltaPublisher.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Sends the changes of the monitoring histograms since the last push to the
+ *  tac_aggregator daemon over a Unix domain socket or a loopback TCP port.
+ *  Histograms whose version (see HistogramVersions.h) did not change are
+ *  skipped without looking at their bins, for the others only the changed
+ *  cells are sent.
+ *
+ *  The event threads only encode the changes. Connecting and writing to the
+ *  socket is done by a sender thread, so that a slow or dead aggregator never
+ *  holds an event thread or the ROOT lock. While the sender is not connected
+ *  nothing is collected. If the encoded changes pile up faster than the
+ *  aggregator reads them they are dropped and the stream starts over with a
+ *  HELLO, which makes the aggregator forget what this process sent before.
+ *
+ *  Every run has its own stream, so that the last events of a run can still
+ *  be pushed after the next run has started. A RUN message switches between
+ *  the streams of the runs that were started with a HELLO.
+ */
+
+#ifndef HISTOGRAMDELTAPUBLISHER_H_
+#define HISTOGRAMDELTAPUBLISHER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <stdint.h>
+
+#include <TH1.h>
+
+#include "HistogramDeltaProtocol.h"
+#include "HistogramVersions.h"
+
+class HistogramDeltaPublisher {
+protected:
+	// Bookkeeping for every histogram that was sent at least once
+	struct PublishedHistogram {
+		TH1* histo = nullptr;
+		HistogramDeltaProtocol::HistogramDefinition definition;
+		// Cell contents as of the last push
+		std::vector<double> lastSent;
+		double lastEntries = 0;
+		UInt_t version = 0;
+	};
+
+	// What was sent for one run since its HELLO
+	struct RunStream {
+		std::vector<PublishedHistogram> histograms;
+		std::map<const TH1*, uint32_t> histogramIndex;
+	};
+
+	// Socket path, or host:port for a TCP connection
+	std::string address;
+	// Name identifying this process to the aggregator
+	std::string sourceName;
+	// Change counters of the histograms, owned by the plugin
+	const HistogramVersions& versions;
+	// Only used by the sender thread
+	int socketFD = -1;
+
+	// Runs that had their HELLO on the current connection
+	std::map<int32_t, RunStream> runStreams;
+	// Run of the last HELLO or RUN message, the DEFINE and DELTA messages go to it
+	int32_t streamRun = 0;
+	bool hasStreamRun = false;
+
+	std::vector<char> sendBuffer;
+	// Scratch space for the changed cells of one histogram
+	std::vector<uint32_t> changedCells;
+	std::vector<double> changedValues;
+
+	// Only one thread at a time collects and sends
+	std::mutex publishMutex;
+
+	// Hand-over to the sender thread, all protected by queueMutex
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::vector<char> pendingBuffer;
+	bool connected = false;
+	// The sender lost the connection or pending changes were dropped
+	bool streamLost = false;
+	bool stopSender = false;
+	std::thread senderThread;
+
+	// Encoded changes allowed to wait for the sender before they are dropped
+	static const size_t maxPendingBytes = 64 << 20;
+
+	std::atomic<uint64_t> totalBytesSent;
+	uint64_t totalCellsSent = 0;
+	uint64_t nDroppedPushes = 0;
+
+	virtual bool connectSocket();
+	virtual void closeSocket();
+	virtual bool writeSocket(const std::vector<char>& buffer);
+	// Body of the sender thread
+	virtual void sendLoop();
+	// Forget what was sent, the next push of every run sends everything again
+	virtual void resetState();
+	virtual void collectHistogram(RunStream& stream, TH1* histo);
+
+public:
+	HistogramDeltaPublisher(std::string addr, const HistogramVersions& histogramVersions);
+	virtual ~HistogramDeltaPublisher();
+
+	HistogramDeltaPublisher(const HistogramDeltaPublisher&) = delete;
+	HistogramDeltaPublisher& operator=(const HistogramDeltaPublisher&) = delete;
+
+	// Put the changes of all histograms of the run into the send buffer. The
+	// histograms must be protected from filling while this is called. Nothing
+	// is done while the sender thread is not connected.
+	virtual void collect(int32_t runNumber,
+			const std::vector<TH1*>& histograms);
+	// Forget the stream of a run whose histograms are deleted
+	virtual void forgetRun(int32_t runNumber);
+	// Queue what was collected for the sender thread, this never blocks on the
+	// socket. Returns false if nothing was queued.
+	virtual bool send();
+
+	std::mutex& getPublishMutex() {
+		return publishMutex;
+	}
+
+	const std::string& getAddress() const {
+		return address;
+	}
+
+	uint64_t getTotalBytesSent() const {
+		return totalBytesSent;
+	}
+
+	uint64_t getTotalCellsSent() const {
+		return totalCellsSent;
+	}
+
+	uint64_t getNumberOfDroppedPushes() const {
+		return nDroppedPushes;
+	}
+};
+
+#endif /* HISTOGRAMDELTAPUBLISHER_H_ */
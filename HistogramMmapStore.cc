@@ -0,0 +1,174 @@
+/*
+ * HistogramMmapStore.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "HistogramMmapStore.h"
+
+using namespace std;
+
+const char HistogramMmapStore::fileMagic[8] = { 'T', 'A', 'C', 'H', 'M', 'A', 'P', '\0' };
+
+// Bin contents of every histogram start on a cache line
+static size_t alignOffset(size_t offset) {
+	return (offset + 63) & ~size_t(63);
+}
+
+HistogramMmapStore::~HistogramMmapStore() {
+	detach();
+}
+
+bool HistogramMmapStore::attach(const string& name, int32_t runNumber,
+		const vector<TH1*>& histograms) {
+	detach();
+
+	// Work out the layout for the current set of histograms
+	vector<AttachedHistogram> newAttached;
+	vector<FileEntry> entries;
+	size_t dataOffset = 0;
+	for (TH1* histo : histograms) {
+		AttachedHistogram hist;
+		hist.histo = histo;
+		hist.array = dynamic_cast<TArrayD*>(hist.histo);
+		if (hist.array == nullptr || hist.array->fN <= 0)
+			continue;
+		FileEntry entry = { };
+		strncpy(entry.name, hist.histo->GetName(), sizeof(entry.name) - 1);
+		entry.nCells = hist.array->fN;
+		newAttached.push_back(hist);
+		entries.push_back(entry);
+	}
+	dataOffset = alignOffset(sizeof(FileHeader) + entries.size() * sizeof(FileEntry));
+	for (auto& entry : entries) {
+		entry.offset = dataOffset;
+		dataOffset = alignOffset(dataOffset + entry.nCells * sizeof(Double_t));
+	}
+	size_t fileSize = dataOffset;
+
+	fileDescriptor = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fileDescriptor < 0) {
+		cerr << "HistogramMmapStore: cannot open " << name << ": "
+				<< strerror(errno) << endl;
+		return false;
+	}
+	struct stat fileStat;
+	bool sameSize = fstat(fileDescriptor, &fileStat) == 0
+			&& size_t(fileStat.st_size) == fileSize;
+	if (!sameSize) {
+		// New or incompatible file, start from an empty one of the right size
+		if (ftruncate(fileDescriptor, 0) != 0
+				|| ftruncate(fileDescriptor, fileSize) != 0) {
+			cerr << "HistogramMmapStore: cannot resize " << name << ": "
+					<< strerror(errno) << endl;
+			closeFile();
+			return false;
+		}
+	}
+	void* mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fileDescriptor, 0);
+	if (mapping == MAP_FAILED) {
+		cerr << "HistogramMmapStore: cannot map " << name << ": "
+				<< strerror(errno) << endl;
+		closeFile();
+		return false;
+	}
+	mappedData = static_cast<char*>(mapping);
+	mappedSize = fileSize;
+	fileName = name;
+
+	resumed = sameSize && layoutMatches(entries, runNumber);
+	if (!resumed) {
+		// Start from what the histograms have now. The header is written last
+		// so that a file cut short by a crash is not taken for a valid one.
+		memset(mappedData, 0, sizeof(FileHeader));
+		memcpy(mappedData + sizeof(FileHeader), entries.data(),
+				entries.size() * sizeof(FileEntry));
+		for (size_t iHist = 0; iHist < newAttached.size(); iHist++) {
+			memcpy(mappedData + entries[iHist].offset,
+					newAttached[iHist].array->fArray,
+					entries[iHist].nCells * sizeof(Double_t));
+		}
+		FileHeader header = { };
+		header.version = fileVersion;
+		header.nHistograms = entries.size();
+		header.runNumber = runNumber;
+		header.fileSize = fileSize;
+		memcpy(header.magic, fileMagic, sizeof(header.magic));
+		memcpy(mappedData, &header, sizeof(header));
+	}
+
+	for (size_t iHist = 0; iHist < newAttached.size(); iHist++) {
+		AttachedHistogram& hist = newAttached[iHist];
+		hist.ownArray = hist.array->fArray;
+		hist.array->fArray = reinterpret_cast<Double_t*>(mappedData
+				+ entries[iHist].offset);
+		// Entries and the other statistics are not in the file, get them from the bins
+		if (resumed)
+			hist.histo->ResetStats();
+	}
+	attached.swap(newAttached);
+
+	cout << "HistogramMmapStore: " << attached.size() << " newAttached in "
+			<< fileName << (resumed ? ", resumed from the file" : "") << endl;
+	return true;
+}
+
+bool HistogramMmapStore::layoutMatches(const vector<FileEntry>& entries,
+		int32_t runNumber) const {
+	FileHeader header;
+	memcpy(&header, mappedData, sizeof(header));
+	if (memcmp(header.magic, fileMagic, sizeof(header.magic)) != 0
+			|| header.version != fileVersion
+			|| header.nHistograms != entries.size()
+			|| header.runNumber != runNumber || header.fileSize != mappedSize)
+		return false;
+	const char* entryData = mappedData + sizeof(FileHeader);
+	for (auto& entry : entries) {
+		FileEntry fileEntry;
+		memcpy(&fileEntry, entryData, sizeof(fileEntry));
+		entryData += sizeof(FileEntry);
+		if (strncmp(entry.name, fileEntry.name, sizeof(entry.name)) != 0
+				|| entry.nCells != fileEntry.nCells
+				|| entry.offset != fileEntry.offset)
+			return false;
+	}
+	return true;
+}
+
+void HistogramMmapStore::detach() {
+	for (auto& hist : attached) {
+		memcpy(hist.ownArray, hist.array->fArray, hist.array->fN * sizeof(Double_t));
+		hist.array->fArray = hist.ownArray;
+	}
+	attached.clear();
+	if (mappedData != nullptr) {
+		msync(mappedData, mappedSize, MS_SYNC);
+		munmap(mappedData, mappedSize);
+		mappedData = nullptr;
+		mappedSize = 0;
+	}
+	closeFile();
+	resumed = false;
+}
+
+void HistogramMmapStore::sync(bool wait) {
+	if (mappedData != nullptr)
+		msync(mappedData, mappedSize, wait ? MS_SYNC : MS_ASYNC);
+}
+
+void HistogramMmapStore::closeFile() {
+	if (fileDescriptor >= 0) {
+		close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+}
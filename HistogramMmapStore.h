@@ -0,0 +1,106 @@
+/*
+ * HistogramMmapStore.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Keeps the bin contents of the monitoring histograms in a memory-mapped
+ *  file. The bin array of every attached histogram (the TArrayD part of TH1D
+ *  and TH2D) is pointed to its place in the mapping, so filling writes
+ *  directly into the page cache and the counts survive a crash of the process
+ *  without any explicit write. If the file of the run already exists with the
+ *  same layout, the histograms resume from its contents.
+ *
+ *  The histograms must not be rebinned or deleted while they are attached,
+ *  detach() gives them their own arrays back.
+ *
+ *  File layout:
+ *     FileHeader | FileEntry for every histogram | bin contents (64 byte aligned)
+ */
+
+#ifndef HISTOGRAMMMAPSTORE_H_
+#define HISTOGRAMMMAPSTORE_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <TH1.h>
+
+class HistogramMmapStore {
+protected:
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t nHistograms;
+		int32_t runNumber;
+		uint32_t reserved;
+		uint64_t fileSize;
+	};
+
+	struct FileEntry {
+		char name[64];
+		uint64_t nCells;
+		// Offset of the bin contents from the start of the file
+		uint64_t offset;
+	};
+
+	// Histogram whose bins live in the mapping
+	struct AttachedHistogram {
+		TH1* histo = nullptr;
+		TArrayD* array = nullptr;
+		// Array allocated by ROOT, given back on detach
+		Double_t* ownArray = nullptr;
+	};
+
+	static const char fileMagic[8];
+	static const uint32_t fileVersion = 1;
+
+	std::string fileName;
+	int fileDescriptor = -1;
+	char* mappedData = nullptr;
+	size_t mappedSize = 0;
+	bool resumed = false;
+
+	std::vector<AttachedHistogram> attached;
+
+	// Check that the existing file was written for the same histograms
+	virtual bool layoutMatches(const std::vector<FileEntry>& entries,
+			int32_t runNumber) const;
+	virtual void closeFile();
+
+public:
+	HistogramMmapStore() {
+	}
+	virtual ~HistogramMmapStore();
+
+	HistogramMmapStore(const HistogramMmapStore&) = delete;
+	HistogramMmapStore& operator=(const HistogramMmapStore&) = delete;
+
+	// Map the file and move the histogram bins into it. A previously attached
+	// file is detached first. Returns false if the file could not be used, the
+	// histograms then keep their own arrays. Must be called with the histograms
+	// protected from filling.
+	virtual bool attach(const std::string& name, int32_t runNumber,
+			const std::vector<TH1*>& histograms);
+	// Copy the contents back into the histogram arrays and unmap the file.
+	// Must be called with the histograms protected from filling.
+	virtual void detach();
+	// Ask the kernel to write the dirty pages, wait for it if requested
+	virtual void sync(bool wait = false);
+
+	bool isAttached() const {
+		return mappedData != nullptr;
+	}
+
+	// True if the histograms were restored from an existing file
+	bool wasResumed() const {
+		return resumed;
+	}
+
+	const std::string& getFileName() const {
+		return fileName;
+	}
+};
+
+#endif /* HISTOGRAMMMAPSTORE_H_ */
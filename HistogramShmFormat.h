@@ -0,0 +1,86 @@
+/*
+ * HistogramShmFormat.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Layout of the POSIX shared-memory segment HistogramShmPublisher writes the
+ *  monitoring histograms into and HistogramShmReader maps for local display
+ *  clients:
+ *
+ *     SegmentHeader | HistogramHeader for every histogram | bin contents
+ *
+ *  Every HistogramHeader and every bin array starts on a cache line. The
+ *  cells are in the order of the ROOT bin array, underflow and overflow
+ *  included (x + (nBinsX + 2) * y for 2D).
+ *
+ *  Each histogram has its own seqlock. The publisher makes the sequence odd,
+ *  writes the cells and the entries, then makes it even again. A reader takes
+ *  the sequence, looks at the cells in place and checks that the sequence is
+ *  still the same even number afterwards, otherwise it looks again. The
+ *  publisher never waits for a reader. A reader spins while the sequence is
+ *  odd, but only for a bounded number of times, so that a publisher that died
+ *  in the middle of a write makes the read fail instead of hanging it.
+ *
+ *  A segment describes one run. When the next run starts the publisher marks
+ *  the old segment closed and creates a new one under the same name, readers
+ *  that see the closed flag map it again.
+ */
+
+#ifndef HISTOGRAMSHMFORMAT_H_
+#define HISTOGRAMSHMFORMAT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+namespace HistogramShmFormat {
+
+static const char segmentMagic[8] = { 'T', 'A', 'C', 'H', 'S', 'H', 'M', '\0' };
+static const uint32_t segmentVersion = 1;
+static const size_t cacheLine = 64;
+
+inline size_t alignOffset(size_t offset) {
+	return (offset + cacheLine - 1) & ~(cacheLine - 1);
+}
+
+struct SegmentHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t nHistograms;
+	int32_t runNumber;
+	uint32_t reserved;
+	uint64_t segmentSize;
+	// Set when the publisher has moved on to a new segment
+	std::atomic<uint32_t> closed;
+	// Number of publications, only for the display
+	std::atomic<uint64_t> publishCount;
+};
+
+// The atomics are lock-free on the platforms the plugin runs on, so they work
+// across processes
+struct alignas(64) HistogramHeader {
+	// Even when the cells are consistent, odd while they are written
+	std::atomic<uint64_t> sequence;
+	double entries;
+	char name[64];
+	uint32_t dimension;
+	int32_t nBinsX;
+	double xMin;
+	double xMax;
+	int32_t nBinsY;
+	double yMin;
+	double yMax;
+	uint64_t nCells;
+	// Offset of the cells from the start of the segment
+	uint64_t offset;
+};
+
+// Offset of the first histogram header
+inline size_t getHistogramTableOffset() {
+	return alignOffset(sizeof(SegmentHeader));
+}
+
+}
+
+#endif /* HISTOGRAMSHMFORMAT_H_ */
@@ -0,0 +1,144 @@
+/*
+ * HistogramShmPublisher.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "HistogramShmPublisher.h"
+
+using namespace std;
+using namespace HistogramShmFormat;
+
+HistogramShmPublisher::HistogramShmPublisher(string name,
+		const HistogramVersions& histogramVersions) :
+		segmentName(name), versions(histogramVersions) {
+	if (segmentName.empty() || segmentName[0] != '/')
+		segmentName = "/" + segmentName;
+}
+
+HistogramShmPublisher::~HistogramShmPublisher() {
+	closeSegment();
+	shm_unlink(segmentName.c_str());
+}
+
+bool HistogramShmPublisher::create(int32_t runNumber,
+		const vector<TH1*>& runHistograms) {
+	closeSegment();
+
+	vector<PublishedHistogram> newHistograms;
+	for (TH1* histo : runHistograms) {
+		PublishedHistogram hist;
+		hist.histo = histo;
+		hist.array = dynamic_cast<TArrayD*>(hist.histo);
+		if (hist.array == nullptr || hist.array->fN <= 0)
+			continue;
+		newHistograms.push_back(hist);
+	}
+	size_t tableOffset = getHistogramTableOffset();
+	size_t dataOffset = alignOffset(tableOffset
+			+ newHistograms.size() * sizeof(HistogramHeader));
+	vector<size_t> cellOffsets;
+	for (auto& hist : newHistograms) {
+		cellOffsets.push_back(dataOffset);
+		dataOffset = alignOffset(dataOffset + hist.array->fN * sizeof(double));
+	}
+	size_t segmentSize = dataOffset;
+
+	// Readers that still have the old segment mapped see it closed, the new
+	// one is created from scratch under the same name
+	shm_unlink(segmentName.c_str());
+	segmentFD = shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (segmentFD < 0 || ftruncate(segmentFD, segmentSize) != 0) {
+		cerr << "HistogramShmPublisher: cannot create " << segmentName << ": "
+				<< strerror(errno) << endl;
+		closeSegment();
+		return false;
+	}
+	void* mapping = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED, segmentFD, 0);
+	if (mapping == MAP_FAILED) {
+		cerr << "HistogramShmPublisher: cannot map " << segmentName << ": "
+				<< strerror(errno) << endl;
+		closeSegment();
+		return false;
+	}
+	mappedData = static_cast<char*>(mapping);
+	mappedSize = segmentSize;
+
+	// ftruncate gave zeroed memory, all sequences start even and all cells empty
+	for (size_t iHist = 0; iHist < newHistograms.size(); iHist++) {
+		PublishedHistogram& hist = newHistograms[iHist];
+		HistogramHeader* header = reinterpret_cast<HistogramHeader*>(mappedData
+				+ tableOffset) + iHist;
+		strncpy(header->name, hist.histo->GetName(), sizeof(header->name) - 1);
+		header->dimension = hist.histo->GetDimension();
+		header->nBinsX = hist.histo->GetXaxis()->GetNbins();
+		header->xMin = hist.histo->GetXaxis()->GetXmin();
+		header->xMax = hist.histo->GetXaxis()->GetXmax();
+		header->nBinsY = hist.histo->GetYaxis()->GetNbins();
+		header->yMin = hist.histo->GetYaxis()->GetXmin();
+		header->yMax = hist.histo->GetYaxis()->GetXmax();
+		header->nCells = hist.array->fN;
+		header->offset = cellOffsets[iHist];
+		hist.header = header;
+		hist.cells = reinterpret_cast<double*>(mappedData + cellOffsets[iHist]);
+	}
+	histograms.swap(newHistograms);
+
+	// The magic is written last, a reader does not take a half-made segment
+	SegmentHeader* segmentHeader = reinterpret_cast<SegmentHeader*>(mappedData);
+	segmentHeader->version = segmentVersion;
+	segmentHeader->nHistograms = histograms.size();
+	segmentHeader->runNumber = runNumber;
+	segmentHeader->segmentSize = segmentSize;
+	atomic_thread_fence(memory_order_release);
+	memcpy(segmentHeader->magic, segmentMagic, sizeof(segmentHeader->magic));
+
+	cout << "HistogramShmPublisher: " << histograms.size() << " histograms in "
+			<< segmentName << endl;
+	return true;
+}
+
+void HistogramShmPublisher::publish() {
+	if (mappedData == nullptr)
+		return;
+	for (auto& hist : histograms) {
+		UInt_t version = versions.get(hist.histo);
+		if (hist.published && version == hist.version)
+			continue;
+		uint64_t sequence = hist.header->sequence.load(memory_order_relaxed);
+		hist.header->sequence.store(sequence + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		memcpy(hist.cells, hist.array->fArray, hist.header->nCells * sizeof(double));
+		hist.header->entries = hist.histo->GetEntries();
+		hist.header->sequence.store(sequence + 2, memory_order_release);
+		hist.published = true;
+		hist.version = version;
+		nHistogramsPublished++;
+	}
+	reinterpret_cast<SegmentHeader*>(mappedData)->publishCount.fetch_add(1,
+			memory_order_relaxed);
+}
+
+void HistogramShmPublisher::closeSegment() {
+	if (mappedData != nullptr) {
+		reinterpret_cast<SegmentHeader*>(mappedData)->closed.store(1,
+				memory_order_release);
+		munmap(mappedData, mappedSize);
+		mappedData = nullptr;
+		mappedSize = 0;
+	}
+	if (segmentFD >= 0) {
+		close(segmentFD);
+		segmentFD = -1;
+	}
+	histograms.clear();
+}
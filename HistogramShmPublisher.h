@@ -0,0 +1,93 @@
+/*
+ * HistogramShmPublisher.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Publishes the bin arrays of the monitoring histograms into a POSIX
+ *  shared-memory segment (see HistogramShmFormat.h) for display clients on
+ *  the same host. A publication copies the histograms whose version
+ *  changed since the last one, each under its seqlock, so a reader never
+ *  takes a lock and never makes the event threads wait. The readers use
+ *  HistogramShmReader.
+ */
+
+#ifndef HISTOGRAMSHMPUBLISHER_H_
+#define HISTOGRAMSHMPUBLISHER_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+#include <TH1.h>
+
+#include "HistogramShmFormat.h"
+#include "HistogramVersions.h"
+
+class HistogramShmPublisher {
+protected:
+	struct PublishedHistogram {
+		TH1* histo = nullptr;
+		// The bin array is looked up on every publication, HistogramMmapStore moves it
+		TArrayD* array = nullptr;
+		HistogramShmFormat::HistogramHeader* header = nullptr;
+		double* cells = nullptr;
+		bool published = false;
+		// Version of the histogram at the last publication
+		UInt_t version = 0;
+	};
+
+	// Name of the segment, like /tac_monitor
+	std::string segmentName;
+	// Change counters of the histograms, owned by the plugin
+	const HistogramVersions& versions;
+	int segmentFD = -1;
+	char* mappedData = nullptr;
+	size_t mappedSize = 0;
+
+	std::vector<PublishedHistogram> histograms;
+
+	// Only one thread at a time publishes
+	std::mutex publishMutex;
+
+	uint64_t nHistogramsPublished = 0;
+
+	// Mark the segment closed for the readers and unmap it
+	virtual void closeSegment();
+
+public:
+	HistogramShmPublisher(std::string name, const HistogramVersions& histogramVersions);
+	virtual ~HistogramShmPublisher();
+
+	HistogramShmPublisher(const HistogramShmPublisher&) = delete;
+	HistogramShmPublisher& operator=(const HistogramShmPublisher&) = delete;
+
+	// Create the segment of a run for the histograms, replacing the one of the
+	// previous run. Returns false if the segment could not be created. Must be
+	// called with the histograms protected from changes of their binning.
+	virtual bool create(int32_t runNumber,
+			const std::vector<TH1*>& runHistograms);
+
+	// Copy the changed histograms into the segment. The histograms must be
+	// protected from filling while this is called.
+	virtual void publish();
+
+	std::mutex& getPublishMutex() {
+		return publishMutex;
+	}
+
+	bool isOpen() const {
+		return mappedData != nullptr;
+	}
+
+	const std::string& getSegmentName() const {
+		return segmentName;
+	}
+
+	uint64_t getNumberOfHistogramsPublished() const {
+		return nHistogramsPublished;
+	}
+};
+
+#endif /* HISTOGRAMSHMPUBLISHER_H_ */
@@ -0,0 +1,214 @@
+/*
+ * HistogramShmReader.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Reader side of the shared-memory histograms published by the TAC_Monitor
+ *  plugin (see HistogramShmFormat.h). The segment is mapped read-only and the
+ *  cells are looked at where they are, the seqlock of each histogram tells
+ *  whether what was seen is consistent. Header only and without ROOT, so that
+ *  any display client can use it:
+ *
+ *     HistogramShmReader reader;
+ *     reader.open("/tac_monitor");
+ *     int index = reader.find("TACAmpPULSE_3");
+ *     reader.read(index, [](const HistogramShmFormat::HistogramHeader& header,
+ *             const double* cells) { ... });
+ *
+ *  When isClosed() becomes true the plugin has started a new run, open() has
+ *  to be called again. A histogram left half written by a plugin that died
+ *  makes read() return false.
+ */
+
+#ifndef HISTOGRAMSHMREADER_H_
+#define HISTOGRAMSHMREADER_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "HistogramShmFormat.h"
+
+class HistogramShmReader {
+protected:
+	std::string segmentName;
+	const char* mappedData = nullptr;
+	size_t mappedSize = 0;
+	const HistogramShmFormat::SegmentHeader* segmentHeader = nullptr;
+	const HistogramShmFormat::HistogramHeader* table = nullptr;
+
+	// Times beginRead() looks at an odd sequence before it gives up
+	static const unsigned maxSpins = 1 << 20;
+
+	// The cells of every histogram have to be inside the mapping, the names
+	// have to be terminated
+	bool tableIsValid() const {
+		using namespace HistogramShmFormat;
+		size_t cellsStart = getHistogramTableOffset()
+				+ segmentHeader->nHistograms * sizeof(HistogramHeader);
+		for (unsigned index = 0; index < segmentHeader->nHistograms; index++) {
+			const HistogramHeader& header = table[index];
+			if (memchr(header.name, '\0', sizeof(header.name)) == nullptr
+					|| header.offset < cellsStart || header.offset > mappedSize
+					|| header.nCells > (mappedSize - header.offset) / sizeof(double))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	HistogramShmReader() {
+	}
+	virtual ~HistogramShmReader() {
+		close();
+	}
+
+	HistogramShmReader(const HistogramShmReader&) = delete;
+	HistogramShmReader& operator=(const HistogramShmReader&) = delete;
+
+	// Map the segment, false if it does not exist or is not complete yet
+	bool open(const std::string& name) {
+		using namespace HistogramShmFormat;
+		close();
+		segmentName = name;
+		if (segmentName.empty() || segmentName[0] != '/')
+			segmentName = "/" + segmentName;
+		int segmentFD = shm_open(segmentName.c_str(), O_RDONLY, 0);
+		if (segmentFD < 0)
+			return false;
+		struct stat segmentStat;
+		if (fstat(segmentFD, &segmentStat) != 0
+				|| size_t(segmentStat.st_size) < sizeof(SegmentHeader)) {
+			::close(segmentFD);
+			return false;
+		}
+		size_t size = segmentStat.st_size;
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, segmentFD, 0);
+		::close(segmentFD);
+		if (mapping == MAP_FAILED)
+			return false;
+		mappedData = static_cast<const char*>(mapping);
+		mappedSize = size;
+		segmentHeader = reinterpret_cast<const SegmentHeader*>(mappedData);
+		if (memcmp(segmentHeader->magic, segmentMagic, sizeof(segmentMagic)) != 0
+				|| segmentHeader->version != segmentVersion
+				|| segmentHeader->segmentSize != mappedSize
+				|| getHistogramTableOffset()
+						+ segmentHeader->nHistograms * sizeof(HistogramHeader) > mappedSize) {
+			close();
+			return false;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		table = reinterpret_cast<const HistogramHeader*>(mappedData
+				+ getHistogramTableOffset());
+		if (!tableIsValid()) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close() {
+		if (mappedData != nullptr)
+			munmap(const_cast<char*>(mappedData), mappedSize);
+		mappedData = nullptr;
+		mappedSize = 0;
+		segmentHeader = nullptr;
+		table = nullptr;
+	}
+
+	bool isOpen() const {
+		return mappedData != nullptr;
+	}
+
+	// True once the publisher has replaced or removed the segment
+	bool isClosed() const {
+		return segmentHeader == nullptr
+				|| segmentHeader->closed.load(std::memory_order_acquire) != 0;
+	}
+
+	int32_t getRunNumber() const {
+		return segmentHeader != nullptr ? segmentHeader->runNumber : -1;
+	}
+
+	uint64_t getPublishCount() const {
+		return segmentHeader != nullptr ?
+				segmentHeader->publishCount.load(std::memory_order_relaxed) : 0;
+	}
+
+	unsigned size() const {
+		return segmentHeader != nullptr ? segmentHeader->nHistograms : 0;
+	}
+
+	// Binning and name, these do not change while the segment is open
+	const HistogramShmFormat::HistogramHeader& getHeader(unsigned index) const {
+		return table[index];
+	}
+
+	// Index of the histogram with the name, -1 if there is none
+	int find(const std::string& name) const {
+		for (unsigned index = 0; index < size(); index++) {
+			if (name == table[index].name)
+				return index;
+		}
+		return -1;
+	}
+
+	// Cells in place, only consistent between beginRead() and a successful endRead()
+	const double* getCells(unsigned index) const {
+		return reinterpret_cast<const double*>(mappedData + table[index].offset);
+	}
+
+	// Get the sequence to give to endRead(), waits while the histogram is
+	// written. False if it stays odd, the publisher may have died while writing.
+	bool beginRead(unsigned index, uint64_t& sequence) const {
+		for (unsigned iSpin = 0; iSpin < maxSpins; iSpin++) {
+			sequence = table[index].sequence.load(std::memory_order_acquire);
+			if ((sequence & 1) == 0)
+				return true;
+			if (iSpin % 1024 == 1023)
+				std::this_thread::yield();
+		}
+		return false;
+	}
+
+	// True if the histogram did not change since beginRead()
+	bool endRead(unsigned index, uint64_t sequence) const {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return table[index].sequence.load(std::memory_order_relaxed) == sequence;
+	}
+
+	// Call visit(header, cells) until it has seen consistent cells. Returns
+	// false if the histogram was written during every one of maxTries attempts,
+	// or if its write never finishes.
+	template<typename VISITOR>
+	bool read(unsigned index, VISITOR visit, unsigned maxTries = 100) const {
+		for (unsigned iTry = 0; iTry < maxTries; iTry++) {
+			uint64_t sequence;
+			if (!beginRead(index, sequence))
+				return false;
+			visit(table[index], getCells(index));
+			if (endRead(index, sequence))
+				return true;
+		}
+		return false;
+	}
+
+	// Consistent copy of the cells and the entries, for clients that keep them
+	bool copy(unsigned index, std::vector<double>& cells, double& entries) const {
+		cells.resize(table[index].nCells);
+		return read(index, [&](const HistogramShmFormat::HistogramHeader& header,
+				const double* values) {
+			memcpy(cells.data(), values, header.nCells * sizeof(double));
+			entries = header.entries;
+		});
+	}
+};
+
+#endif /* HISTOGRAMSHMREADER_H_ */
@@ -0,0 +1,119 @@
+/*
+ * HistogramSnapshotWriter.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TMemFile.h"
+#include "TKey.h"
+#include "TDirectory.h"
+
+#include "HistogramSnapshotWriter.h"
+
+using namespace std;
+
+HistogramSnapshotWriter::HistogramSnapshotWriter(unsigned threads,
+		const HistogramVersions& histogramVersions) :
+		nThreads(threads < 1 ? 1 : threads), versions(histogramVersions) {
+}
+
+HistogramSnapshotWriter::~HistogramSnapshotWriter() {
+	clearPending();
+}
+
+void HistogramSnapshotWriter::setFileName(const string& name, bool keepContents) {
+	if (name == fileName)
+		return;
+	fileName = name;
+	fileStarted = keepContents;
+	writtenVersions.clear();
+	clearPending();
+}
+
+void HistogramSnapshotWriter::collect(
+		const vector<TH1*>& histograms) {
+	clearPending();
+	for (TH1* histo : histograms) {
+		UInt_t version = versions.get(histo);
+		auto writtenIter = writtenVersions.find(histo);
+		if (fileStarted && writtenIter != writtenVersions.end()
+				&& writtenIter->second == version) {
+			nUnchanged++;
+			continue;
+		}
+		TH1* clone = static_cast<TH1*>(histo->Clone());
+		clone->SetDirectory(nullptr);
+		pending.push_back(clone);
+		writtenVersions[histo] = version;
+	}
+}
+
+bool HistogramSnapshotWriter::write() {
+	TDirectory::TContext directoryContext;
+	unique_ptr<TFile> outFile(TFile::Open(fileName.c_str(),
+			fileStarted ? "UPDATE" : "RECREATE"));
+	if (!outFile || outFile->IsZombie()) {
+		cerr << "HistogramSnapshotWriter: cannot open " << fileName << endl;
+		// Everything is written again the next time
+		writtenVersions.clear();
+		clearPending();
+		return false;
+	}
+	fileStarted = true;
+	if (nThreads > 1 && pending.size() > 1) {
+		writeParallel(outFile.get());
+	} else {
+		outFile->cd();
+		for (auto clone : pending)
+			clone->Write(nullptr, TObject::kOverwrite);
+	}
+	nWritten += pending.size();
+	clearPending();
+	// Writes the list of keys and the free segments, the file is complete again
+	outFile->Close();
+	return true;
+}
+
+void HistogramSnapshotWriter::writeParallel(TFile* outFile) {
+	unsigned nWorkers = min<size_t>(nThreads, pending.size());
+	int compression = outFile->GetCompressionSettings();
+	vector<unique_ptr<TMemFile> > memFiles(nWorkers);
+	vector<thread> workers;
+	for (unsigned iWorker = 0; iWorker < nWorkers; iWorker++) {
+		workers.emplace_back([&, iWorker]() {
+			memFiles[iWorker].reset(new TMemFile("tac_snapshot.root", "RECREATE",
+					"", compression));
+			memFiles[iWorker]->cd();
+			for (size_t iClone = iWorker; iClone < pending.size(); iClone += nWorkers)
+				pending[iClone]->Write();
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	// The compressed buffers are copied, nothing is streamed again
+	outFile->cd();
+	for (auto& memFile : memFiles) {
+		TIter nextKey(memFile->GetListOfKeys());
+		while (TKey* memKey = static_cast<TKey*>(nextKey())) {
+			// The cycles of earlier snapshots go first, so that their space is reused
+			outFile->Delete((string(memKey->GetName()) + ";*").c_str());
+			TKey* key = new TKey(outFile, *memKey, 0);
+			key->WriteFile();
+		}
+		memFile->Close();
+	}
+}
+
+void HistogramSnapshotWriter::clearPending() {
+	for (auto clone : pending)
+		delete clone;
+	pending.clear();
+}
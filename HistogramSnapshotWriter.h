@@ -0,0 +1,94 @@
+/*
+ * HistogramSnapshotWriter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Writes the periodic snapshots of the monitoring histograms into the ROOT
+ *  file of the run. Only the histograms whose version (HistogramVersions.h)
+ *  changed since they were last written are cloned and written, the file is
+ *  recreated at the first snapshot of a run and updated afterwards. A histogram
+ *  written again replaces its previous key cycle, so the space of the old one
+ *  is reused and the file keeps one cycle per histogram.
+ *
+ *  With more than one thread the clones are streamed and compressed in
+ *  parallel, every thread into its own TMemFile, and the compressed keys are
+ *  then copied into the file as they are.
+ */
+
+#ifndef HISTOGRAMSNAPSHOTWRITER_H_
+#define HISTOGRAMSNAPSHOTWRITER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+#include <TH1.h>
+
+#include "HistogramVersions.h"
+
+class TFile;
+
+class HistogramSnapshotWriter {
+protected:
+	// ROOT file of the run, recreated by the first snapshot written into it
+	std::string fileName;
+	bool fileStarted = false;
+	unsigned nThreads;
+	// Change counters of the histograms, owned by the plugin
+	const HistogramVersions& versions;
+
+	// Version of every histogram when it was last written
+	std::map<const TH1*, UInt_t> writtenVersions;
+	// Clones of the changed histograms, waiting to be written
+	std::vector<TH1*> pending;
+
+	// Only one thread at a time takes a snapshot
+	std::mutex snapshotMutex;
+
+	uint64_t nWritten = 0;
+	uint64_t nUnchanged = 0;
+
+	// Stream and compress the clones in parallel, then copy the keys into the file
+	virtual void writeParallel(TFile* outFile);
+	virtual void clearPending();
+
+public:
+	HistogramSnapshotWriter(unsigned threads, const HistogramVersions& histogramVersions);
+	virtual ~HistogramSnapshotWriter();
+
+	HistogramSnapshotWriter(const HistogramSnapshotWriter&) = delete;
+	HistogramSnapshotWriter& operator=(const HistogramSnapshotWriter&) = delete;
+
+	// File of the snapshots, a new name starts over with all histograms. The
+	// file is recreated by the first snapshot unless its contents are kept.
+	virtual void setFileName(const std::string& name, bool keepContents = false);
+
+	// Clone the histograms that changed since they were last written. The
+	// histograms must be protected from filling while this is called.
+	virtual void collect(
+			const std::vector<TH1*>& histograms);
+	// Write what was collected, this does not need the histograms. Returns
+	// false if the file could not be opened.
+	virtual bool write();
+
+	std::mutex& getSnapshotMutex() {
+		return snapshotMutex;
+	}
+
+	const std::string& getFileName() const {
+		return fileName;
+	}
+
+	// Histograms written and the ones skipped because they did not change
+	uint64_t getNumberWritten() const {
+		return nWritten;
+	}
+	uint64_t getNumberUnchanged() const {
+		return nUnchanged;
+	}
+};
+
+#endif /* HISTOGRAMSNAPSHOTWRITER_H_ */
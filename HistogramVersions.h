@@ -0,0 +1,53 @@
+/*
+ * HistogramVersions.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Change counters of the monitoring histograms, so that the snapshot writer
+ *  and the publishers can skip the histograms that did not change. The number
+ *  of entries is not enough for that: the display histograms rebuilt with
+ *  Reset() and a fixed number of SetBinContent() calls end up with the same
+ *  entries every time.
+ *
+ *  The table is owned by the plugin and kept apart from the histograms, so
+ *  that nothing of it is streamed into the ROOT files. Whatever changes a
+ *  histogram, including restoring its counts, calls touch() on it under the
+ *  ROOT write lock. get() needs the read lock at least.
+ */
+
+#ifndef HISTOGRAMVERSIONS_H_
+#define HISTOGRAMVERSIONS_H_
+
+#include <unordered_map>
+
+#include <TH1.h>
+
+class HistogramVersions {
+protected:
+	std::unordered_map<const TH1*, UInt_t> versions;
+
+public:
+	HistogramVersions() {
+	}
+
+	HistogramVersions(const HistogramVersions&) = delete;
+	HistogramVersions& operator=(const HistogramVersions&) = delete;
+
+	void touch(const TH1* histo) {
+		versions[histo]++;
+	}
+
+	// 0 for a histogram that was never touched
+	UInt_t get(const TH1* histo) const {
+		auto versionIter = versions.find(histo);
+		return versionIter != versions.end() ? versionIter->second : 0;
+	}
+
+	// Called before the histogram is deleted, another one may get its address
+	void remove(const TH1* histo) {
+		versions.erase(histo);
+	}
+};
+
+#endif /* HISTOGRAMVERSIONS_H_ */
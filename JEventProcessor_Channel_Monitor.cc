@@ -0,0 +1,278 @@
+/*
+ * JEventProcessor_Channel_Monitor.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <algorithm>
+
+#include "TDirectory.h"
+#include "TH2D.h"
+
+#include <JANA/JApplication.h>
+#include <DANA/DApplication.h>
+#include <DANA/ReadWriteLock.h>
+#include "TRIGGER/DL1Trigger.h"
+#include <DAQ/Df250PulseData.h>
+#include <DAQ/Df250WindowRawData.h>
+#include <DAQ/DF1TDCHit.h>
+#include <DAQ/DCAEN1290TDCHit.h>
+
+#include "JEventProcessor_Channel_Monitor.h"
+#include "JEventProcessor_TAC_Monitor.h"
+#include "TimedWriteLock.h"
+
+using namespace jana;
+using namespace std;
+
+atomic<uint64_t> JEventProcessor_Channel_Monitor::nextInstanceId(1);
+
+// Channel list file, nothing is monitored if it is empty
+string JEventProcessor_Channel_Monitor::channelListFile = "";
+// Number of events of a thread between additions to the ROOT histograms
+unsigned JEventProcessor_Channel_Monitor::flushPeriod = 1000;
+// FADC threshold for the signal time
+unsigned JEventProcessor_Channel_Monitor::defaultThreshold = 200;
+// Time units for the timing from raw FADC
+double JEventProcessor_Channel_Monitor::fadc250RawTimeScale = 4.0;
+// Time units for the course and fine time of the firmware pulse (4 ns / 64)
+double JEventProcessor_Channel_Monitor::fadc250PulseTimeScale = 0.0625;
+
+// Histograms of the quantities, the channel number is on X
+namespace {
+struct QuantityDefinition {
+	const char* name;
+	const char* title;
+	const char* yTitle;
+	int nBins;
+	double low;
+	double high;
+};
+
+const QuantityDefinition quantityDefinitions[JEventProcessor_Channel_Monitor::NUMBER_OF_QUANTITIES] = {
+	{ "CHANNEL_NHITS", "Number of FADC pulses or TDC hits per channel", "Number of hits [#]",
+			8, 0., 8. },
+	{ "CHANNEL_WAVE_PEAK", "FADC waveform maximum per channel", "FlashADC sample maximum",
+			500, 0., 5000. },
+	{ "CHANNEL_WAVE_TIME", "FADC waveform threshold time per channel", "FlashADC threshold time (ns)",
+			400, 0., 400. },
+	{ "CHANNEL_PULSE_PEAK", "FADC pulse peak per channel", "FlashADC pulse peak",
+			500, 0., 5000. },
+	{ "CHANNEL_PULSE_INTEGRAL", "FADC pulse integral per channel", "FlashADC pulse integral",
+			1000, 0., 14000. },
+	{ "CHANNEL_PULSE_TIME", "FADC pulse time per channel", "FlashADC pulse time (ns)",
+			400, 0., 400. },
+	{ "CHANNEL_TDC_TIME", "TDC time per channel", "TDC time [ns]",
+			500, 0., 500. },
+};
+
+// Thread histograms of the current thread for the processor they belong to
+struct ThreadHistogramsCache {
+	uint64_t instanceId = 0;
+	void* histograms = nullptr;
+};
+thread_local ThreadHistogramsCache threadHistogramsCache;
+
+// Time of a TDC hit in ns
+double convertTDCTime(const DTTabUtilities* ttabUtilities, const DF1TDCHit* hit) {
+	return ttabUtilities->Convert_DigiTimeToNs_F1TDC(hit);
+}
+double convertTDCTime(const DTTabUtilities* ttabUtilities, const DCAEN1290TDCHit* hit) {
+	return ttabUtilities->Convert_DigiTimeToNs_CAEN1290TDC(hit);
+}
+}
+
+JEventProcessor_Channel_Monitor::JEventProcessor_Channel_Monitor() :
+		instanceId(nextInstanceId++) {
+}
+
+jerror_t JEventProcessor_Channel_Monitor::init(void) {
+	gPARMS->SetDefaultParameter<string,string>( "TAC:CHANNEL_LIST", channelListFile );
+	gPARMS->GetParameter( "TAC:CHANNEL_LIST" )->GetValue( channelListFile );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:CHANNEL_FLUSH_PERIOD", flushPeriod );
+	gPARMS->GetParameter( "TAC:CHANNEL_FLUSH_PERIOD" )->GetValue( flushPeriod );
+	if( flushPeriod < 1 ) flushPeriod = 1;
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:CHANNEL_THRESHOLD", defaultThreshold );
+	gPARMS->GetParameter( "TAC:CHANNEL_THRESHOLD" )->GetValue( defaultThreshold );
+	if( channelListFile.empty() )
+		return NOERROR;
+
+	channelMap.read( channelListFile );
+	if( channelMap.empty() )
+		return NOERROR;
+
+	rootLock = dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock();
+	volatile WriteLock rootRWLock(*rootLock);
+	TDirectory *mainDir = gDirectory;
+	gDirectory->mkdir("TAC_CHANNELS")->cd();
+	createHistograms();
+	mainDir->cd();
+	return NOERROR;
+}
+
+void JEventProcessor_Channel_Monitor::createHistograms() {
+	auto& channels = channelMap.getChannels();
+	int nChannels = channels.size();
+	for (unsigned quantity = 0; quantity < NUMBER_OF_QUANTITIES; quantity++) {
+		auto& def = quantityDefinitions[quantity];
+		TH2* histo = new TH2D(def.name, def.title, nChannels, 0., nChannels,
+				def.nBins, def.low, def.high);
+		histo->GetXaxis()->SetTitle("Channel");
+		histo->GetYaxis()->SetTitle(def.yTitle);
+		for (int iChannel = 0; iChannel < nChannels; iChannel++)
+			histo->GetXaxis()->SetBinLabel(iChannel + 1, channels[iChannel].name.c_str());
+		histograms[quantity] = histo;
+	}
+}
+
+JEventProcessor_Channel_Monitor::ThreadHistograms* JEventProcessor_Channel_Monitor::getThreadHistograms() {
+	if (threadHistogramsCache.instanceId == instanceId)
+		return static_cast<ThreadHistograms*>(threadHistogramsCache.histograms);
+	unique_ptr<ThreadHistograms> threadHistos(new ThreadHistograms());
+	unsigned nChannels = channelMap.size();
+	for (unsigned quantity = 0; quantity < NUMBER_OF_QUANTITIES; quantity++) {
+		auto& def = quantityDefinitions[quantity];
+		threadHistos->arrays[quantity].setBinning(nChannels, def.nBins, def.low, def.high);
+	}
+	threadHistos->nHits.assign(nChannels, 0);
+	ThreadHistograms* threadHistosPointer = threadHistos.get();
+	{
+		lock_guard<mutex> registryGuard(registryMutex);
+		threadHistograms.push_back(std::move(threadHistos));
+	}
+	threadHistogramsCache.instanceId = instanceId;
+	threadHistogramsCache.histograms = threadHistosPointer;
+	return threadHistosPointer;
+}
+
+jerror_t JEventProcessor_Channel_Monitor::brun(JEventLoop* eventLoop,
+		int32_t runNumber) {
+	return NOERROR;
+}
+
+jerror_t JEventProcessor_Channel_Monitor::evnt(JEventLoop* eventLoop,
+		uint64_t eventNumber) {
+	if (channelMap.empty())
+		return NOERROR;
+
+	// Same trigger selection as the TAC monitor
+	const DL1Trigger *trigWords = nullptr;
+	try {
+		eventLoop->GetSingle(trigWords);
+	} catch (...) {
+	};
+	if (trigWords == nullptr
+			|| (trigWords->trig_mask & JEventProcessor_TAC_Monitor::getTriggerMask()) == 0)
+		return NOERROR;
+
+	// The hit vectors are only used by this thread, they are filled before the
+	// mutex is taken
+	ThreadHistograms* threadHistos = getThreadHistograms();
+	auto& windowRawData = threadHistos->windowRawData;
+	auto& pulseData = threadHistos->pulseData;
+	auto& f1TDCHits = threadHistos->f1TDCHits;
+	auto& caenTDCHits = threadHistos->caenTDCHits;
+	windowRawData.clear();
+	pulseData.clear();
+	f1TDCHits.clear();
+	caenTDCHits.clear();
+	eventLoop->Get(windowRawData);
+	eventLoop->Get(pulseData);
+	eventLoop->Get(f1TDCHits);
+	eventLoop->Get(caenTDCHits);
+	const DTTabUtilities* ttabUtilities = nullptr;
+	if (!f1TDCHits.empty() || !caenTDCHits.empty())
+		eventLoop->GetSingle(ttabUtilities);
+
+	auto& channels = channelMap.getChannels();
+	lock_guard<mutex> threadGuard(threadHistos->mutex);
+	auto& arrays = threadHistos->arrays;
+
+	for (auto rawData : windowRawData) {
+		int iChannel = channelMap.find(DAQChannelMap::FADC, rawData->rocid,
+				rawData->slot, rawData->channel);
+		if (iChannel < 0 || rawData->samples.empty())
+			continue;
+		auto& samples = rawData->samples;
+		unsigned threshold = channels[iChannel].threshold > 0 ?
+				channels[iChannel].threshold : defaultThreshold;
+		auto peak = max_element(samples.begin(), samples.end());
+		auto crossing = find_if(samples.begin(), samples.end(),
+				[threshold](uint16_t sample) {return sample > threshold;});
+		arrays[WAVE_PEAK].fill(iChannel, *peak);
+		if (crossing != samples.end())
+			arrays[WAVE_TIME].fill(iChannel,
+					distance(samples.begin(), crossing) * fadc250RawTimeScale);
+	}
+	for (auto pulse : pulseData) {
+		int iChannel = channelMap.find(DAQChannelMap::FADC, pulse->rocid,
+				pulse->slot, pulse->channel);
+		if (iChannel < 0)
+			continue;
+		threadHistos->nHits[iChannel]++;
+		arrays[PULSE_PEAK].fill(iChannel, pulse->pulse_peak);
+		arrays[PULSE_INTEGRAL].fill(iChannel, pulse->integral);
+		arrays[PULSE_TIME].fill(iChannel,
+				(pulse->course_time * 64 + pulse->fine_time) * fadc250PulseTimeScale);
+	}
+	if (ttabUtilities != nullptr) {
+		fillTDCHits(f1TDCHits, ttabUtilities, *threadHistos);
+		fillTDCHits(caenTDCHits, ttabUtilities, *threadHistos);
+	}
+	for (unsigned iChannel = 0; iChannel < channels.size(); iChannel++) {
+		arrays[N_HITS].fill(iChannel, threadHistos->nHits[iChannel]);
+		threadHistos->nHits[iChannel] = 0;
+	}
+
+	if (++threadHistos->nEvents >= flushPeriod)
+		flush(*threadHistos);
+	return NOERROR;
+}
+
+template<typename TDC_HIT>
+void JEventProcessor_Channel_Monitor::fillTDCHits(
+		const vector<const TDC_HIT*>& tdcHits,
+		const DTTabUtilities* ttabUtilities, ThreadHistograms& threadHistos) {
+	for (auto tdcHit : tdcHits) {
+		int iChannel = channelMap.find(DAQChannelMap::TDC, tdcHit->rocid,
+				tdcHit->slot, tdcHit->channel);
+		if (iChannel < 0)
+			continue;
+		threadHistos.nHits[iChannel]++;
+		threadHistos.arrays[TDC_TIME].fill(iChannel,
+				convertTDCTime(ttabUtilities, tdcHit));
+	}
+}
+
+void JEventProcessor_Channel_Monitor::flush(ThreadHistograms& threadHistos) {
+	{
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		for (unsigned quantity = 0; quantity < NUMBER_OF_QUANTITIES; quantity++) {
+			auto& array = threadHistos.arrays[quantity];
+			if (array.getEntries() == 0)
+				continue;
+			TH2D* histo = dynamic_cast<TH2D*>(histograms[quantity]);
+			array.addTo(histo->GetArray());
+			histo->SetEntries(histo->GetEntries() + array.getEntries());
+		}
+	}
+	for (auto& array : threadHistos.arrays)
+		array.clear();
+	threadHistos.nEvents = 0;
+}
+
+jerror_t JEventProcessor_Channel_Monitor::erun(void) {
+	// Add what the threads have not added yet
+	lock_guard<mutex> registryGuard(registryMutex);
+	for (auto& threadHistos : threadHistograms) {
+		lock_guard<mutex> threadGuard(threadHistos->mutex);
+		flush(*threadHistos);
+	}
+	return NOERROR;
+}
+
+jerror_t JEventProcessor_Channel_Monitor::fini(void) {
+	return NOERROR;
+}
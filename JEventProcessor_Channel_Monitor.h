@@ -0,0 +1,126 @@
+/*
+ * JEventProcessor_Channel_Monitor.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  The raw data monitoring of the TAC for any list of FADC250 and TDC
+ *  channels (see DAQChannelMap.h). Every quantity is one TH2 with the
+ *  channel number on X. The raw data of an event are gone through once and
+ *  filled into the per-thread ChannelHistogramArrays, which are added to the
+ *  ROOT histograms every TAC:CHANNEL_FLUSH_PERIOD events of the thread. The
+ *  processor does nothing if TAC:CHANNEL_LIST is not set.
+ */
+
+#ifndef JEVENTPROCESSOR_CHANNEL_MONITOR_H_
+#define JEVENTPROCESSOR_CHANNEL_MONITOR_H_
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <pthread.h>
+
+#include <TH2.h>
+
+#include <JANA/JEventProcessor.h>
+#include <TTAB/DTTabUtilities.h>
+
+#include "DAQChannelMap.h"
+#include "ChannelHistogramArray.h"
+
+class Df250WindowRawData;
+class Df250PulseData;
+class DF1TDCHit;
+class DCAEN1290TDCHit;
+
+class JEventProcessor_Channel_Monitor: public jana::JEventProcessor {
+public:
+	enum Quantity {
+		// Number of pulses or TDC hits of the channel in the event
+		N_HITS,
+		// Maximum sample and threshold crossing time of the FADC window
+		WAVE_PEAK,
+		WAVE_TIME,
+		// Firmware pulse peak, integral and time
+		PULSE_PEAK,
+		PULSE_INTEGRAL,
+		PULSE_TIME,
+		TDC_TIME,
+		NUMBER_OF_QUANTITIES
+	};
+
+protected:
+	// Histograms of one event thread
+	struct ThreadHistograms {
+		// Only taken by the owning thread, and by erun() to add what is left
+		std::mutex mutex;
+		ChannelHistogramArray<uint32_t> arrays[NUMBER_OF_QUANTITIES];
+		// Hits of every channel in the current event
+		std::vector<uint16_t> nHits;
+		unsigned nEvents = 0;
+		// Raw data of the current event, kept to reuse their memory
+		std::vector<const Df250WindowRawData*> windowRawData;
+		std::vector<const Df250PulseData*> pulseData;
+		std::vector<const DF1TDCHit*> f1TDCHits;
+		std::vector<const DCAEN1290TDCHit*> caenTDCHits;
+	};
+
+	DAQChannelMap channelMap;
+
+	// One histogram per quantity, created if there are channels in the list
+	TH2* histograms[NUMBER_OF_QUANTITIES] = { };
+
+	// ROOT read-write lock of the application, protects the histograms
+	pthread_rwlock_t* rootLock = nullptr;
+
+	// Protects the list of thread histograms
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadHistograms> > threadHistograms;
+	// Tells apart the thread histograms of different processors
+	uint64_t instanceId;
+
+	static std::atomic<uint64_t> nextInstanceId;
+
+	// File with the channel list, the processor is off if empty
+	static std::string channelListFile;
+	// Number of events of a thread between additions to the ROOT histograms
+	static unsigned flushPeriod;
+	// Threshold for the FADC time of the channels without their own
+	static unsigned defaultThreshold;
+	// Time units of the raw FADC samples in ns
+	static double fadc250RawTimeScale;
+	// Time units of the firmware pulse time in ns
+	static double fadc250PulseTimeScale;
+
+	virtual jerror_t init(void);
+	virtual jerror_t brun(jana::JEventLoop *eventLoop, int32_t runNumber);
+	virtual jerror_t evnt(jana::JEventLoop *eventLoop, uint64_t eventNumber);
+	virtual jerror_t erun(void);
+	virtual jerror_t fini(void);
+
+	virtual void createHistograms();
+
+	// Histograms of the calling thread, created on its first event
+	ThreadHistograms* getThreadHistograms();
+
+	// Add the thread histograms to the ROOT histograms and clear them. Called
+	// with the mutex of the thread histograms held.
+	virtual void flush(ThreadHistograms& threadHistos);
+
+	// Fill the TDC times of the listed channels, for the F1TDC and CAEN hits
+	template<typename TDC_HIT>
+	void fillTDCHits(const std::vector<const TDC_HIT*>& tdcHits,
+			const DTTabUtilities* ttabUtilities, ThreadHistograms& threadHistos);
+
+public:
+	JEventProcessor_Channel_Monitor();
+	virtual ~JEventProcessor_Channel_Monitor() {
+	}
+
+	const DAQChannelMap& getChannelMap() const {
+		return channelMap;
+	}
+};
+
+#endif /* JEVENTPROCESSOR_CHANNEL_MONITOR_H_ */
@@ -12,9 +12,11 @@
 
 #include "TApplication.h"  // needed to display canvas
 #include "TSystem.h"
+#include "TROOT.h"
 #include "TFile.h"
 #include "TH1.h"
 #include "TH1F.h"
+#include "TArrayD.h"
 #include "TF1.h"
 #include "TF2.h"
 #include "TH2F.h"
@@ -39,6 +41,8 @@
 #include <TTAB/DTTabUtilities.h>
 
 #include "JEventProcessor_TAC_Monitor.h"
+#include "JEventProcessor_Channel_Monitor.h"
+#include "TACHistogramDefinitions.h"
 
 using namespace jana;
 using namespace std;
@@ -50,6 +54,8 @@ void InitPlugin(JApplication *app) {
 	InitJANAPlugin(app);
 	cout << "Plugin initialized" << endl;
 	app->AddProcessor(new JEventProcessor_TAC_Monitor());
+	// Only monitors something if TAC:CHANNEL_LIST is given
+	app->AddProcessor(new JEventProcessor_Channel_Monitor());
 	cout << "Processor added" << endl;
 }
 }
@@ -85,11 +91,93 @@ double JEventProcessor_TAC_Monitor::fadc250DigiTimeScale = (1./16.0);
 // Time units for the timing from raw FADC
 double JEventProcessor_TAC_Monitor::fadc250RawTimeScale = 4.0;
 
+// Address of the tac_aggregator daemon, the deltas are not published if empty
+string JEventProcessor_TAC_Monitor::aggregatorAddress = "";
+// Number of useful events between pushes to the aggregator
+unsigned JEventProcessor_TAC_Monitor::aggregatorPeriod = 10000;
+
+// Keep the histogram bins in tac_monitor_<run>.hist so that they survive a crash
+bool JEventProcessor_TAC_Monitor::histogramMmap = false;
+
+// Shared-memory segment for the local display clients, not published if empty
+string JEventProcessor_TAC_Monitor::shmName = "";
+// Number of useful events between publications into the segment
+unsigned JEventProcessor_TAC_Monitor::shmPeriod = 1000;
+
+// Threads streaming and compressing the changed histograms of a ROOT snapshot
+unsigned JEventProcessor_TAC_Monitor::snapshotThreads = 4;
+
+// Seconds an ended run waits for its last events before it is written and deleted
+unsigned JEventProcessor_TAC_Monitor::runEndDelay = 5;
+
+// Prometheus text file and Unix socket with the health counters of the monitor
+string JEventProcessor_TAC_Monitor::metricsFile = "";
+string JEventProcessor_TAC_Monitor::metricsSocket = "";
+// Seconds between exports of the health counters
+unsigned JEventProcessor_TAC_Monitor::metricsPeriod = 10;
+
+// Codecs compared on the waveforms, the compression test is off if empty
+string JEventProcessor_TAC_Monitor::codecList = "";
+// Keep the waveforms encoded by every codec in files
+bool JEventProcessor_TAC_Monitor::codecFiles = false;
+
+// Quantities histogrammed for every codec of the compression test
+static const struct {
+	const char* key;
+	const char* title;
+	const char* xTitle;
+	unsigned nBins;
+	double low;
+	double high;
+} codecQuantities[] = {
+	{ "TACCODEC_BYTES_IN", "Raw bytes per waveform, ", "Bytes", 256, 0., 2048. },
+	{ "TACCODEC_BYTES_OUT", "Encoded bytes per waveform, ", "Bytes", 256, 0., 2048. },
+	{ "TACCODEC_RATIO", "Encoded over raw size per waveform, ", "Ratio", 250, 0., 5. },
+	{ "TACCODEC_ENCODE_NS", "Encoding time per waveform, ", "Time [ns]", 200, 0., 20000. }
+};
+static const unsigned numberOfCodecQuantities = sizeof(codecQuantities) / sizeof(codecQuantities[0]);
+
+// Write one record per accepted event into tac_features_<run>.bin
+bool JEventProcessor_TAC_Monitor::featureOutput = false;
+// Keep the waveform samples in the feature file
+bool JEventProcessor_TAC_Monitor::featureSamples = true;
+// Keep the tagger hits within this distance from the cut values in ns, all hits
+// if 0. tac_replay needs all hits to give the histograms of the plugin.
+double JEventProcessor_TAC_Monitor::featureTaggerWindow = 0.0;
+// Number of events in a block of the feature file
+unsigned JEventProcessor_TAC_Monitor::featureBlockSize = 4096;
+
+// Calibrate the TAGH and TAGM coincidence windows per counter
+bool JEventProcessor_TAC_Monitor::taggerCalibration = false;
+// The calibration starts from this file and is written back to it
+string JEventProcessor_TAC_Monitor::taggerCalibrationFile = "tac_tagger_calib.txt";
+
+// Number of recent waveforms kept per event thread for the display
+unsigned JEventProcessor_TAC_Monitor::waveformRingSize = 64;
+// Number of useful events between refreshes of the waveform histograms
+unsigned JEventProcessor_TAC_Monitor::waveformDisplayPeriod = 1000;
+
+// Fit the waveforms with the template made from TACFADCRAW_AVG
+bool JEventProcessor_TAC_Monitor::templateFit = true;
+// Number of waveforms in the average before it is used as the template
+unsigned JEventProcessor_TAC_Monitor::templateMinEntries = 1000;
+// Number of useful events between updates of the template
+unsigned JEventProcessor_TAC_Monitor::templateUpdatePeriod = 10000;
+
+// Write the events with saturated, piled-up or odd waveforms with their samples
+bool JEventProcessor_TAC_Monitor::anomalyOutput = false;
+
+// Number of useful events between moves of the atomic histograms into the ROOT ones
+unsigned JEventProcessor_TAC_Monitor::atomicFlushPeriod = 1000;
+
+// Number of time slices in the <key>_ROLLING histograms, 30 slices of 10 s
+unsigned JEventProcessor_TAC_Monitor::rollingWindowSlices = 30;
+
 
 jerror_t JEventProcessor_TAC_Monitor::init(void) {
 	cout << "Executing JEventProcessor_TAC_Monitor::init()" << endl;
-	volatile WriteLock rootRWLock(
-			*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
+	rootLock = dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock();
+	volatile WriteLock rootRWLock(*rootLock);
 
 	cout << "lock is taken" << endl;
 	// Create parameters and assign values
@@ -99,15 +187,154 @@ jerror_t JEventProcessor_TAC_Monitor::init(void) {
 	gPARMS->GetParameter( "TAC:TAGM_FADC_MEAN_TIME" )->GetValue( timeCutValue_TAGM );
 	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:TAC_FADC_THRESHOLD", tacThreshold );
 	gPARMS->GetParameter( "TAC:TAC_FADC_THRESHOLD" )->GetValue( tacThreshold );
+	gPARMS->SetDefaultParameter<string,string>( "TAC:AGGREGATOR_ADDRESS", aggregatorAddress );
+	gPARMS->GetParameter( "TAC:AGGREGATOR_ADDRESS" )->GetValue( aggregatorAddress );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:AGGREGATOR_PERIOD", aggregatorPeriod );
+	gPARMS->GetParameter( "TAC:AGGREGATOR_PERIOD" )->GetValue( aggregatorPeriod );
+	if( aggregatorPeriod < 1 ) aggregatorPeriod = 1;
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:HISTOGRAM_MMAP", histogramMmap );
+	gPARMS->GetParameter( "TAC:HISTOGRAM_MMAP" )->GetValue( histogramMmap );
+	gPARMS->SetDefaultParameter<string,string>( "TAC:SHM_NAME", shmName );
+	gPARMS->GetParameter( "TAC:SHM_NAME" )->GetValue( shmName );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:SHM_PERIOD", shmPeriod );
+	gPARMS->GetParameter( "TAC:SHM_PERIOD" )->GetValue( shmPeriod );
+	if( shmPeriod < 1 ) shmPeriod = 1;
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:SNAPSHOT_THREADS", snapshotThreads );
+	gPARMS->GetParameter( "TAC:SNAPSHOT_THREADS" )->GetValue( snapshotThreads );
+	if( snapshotThreads < 1 ) snapshotThreads = 1;
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:RUN_END_DELAY", runEndDelay );
+	gPARMS->GetParameter( "TAC:RUN_END_DELAY" )->GetValue( runEndDelay );
+	gPARMS->SetDefaultParameter<string,string>( "TAC:METRICS_FILE", metricsFile );
+	gPARMS->GetParameter( "TAC:METRICS_FILE" )->GetValue( metricsFile );
+	gPARMS->SetDefaultParameter<string,string>( "TAC:METRICS_SOCKET", metricsSocket );
+	gPARMS->GetParameter( "TAC:METRICS_SOCKET" )->GetValue( metricsSocket );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:METRICS_PERIOD", metricsPeriod );
+	gPARMS->GetParameter( "TAC:METRICS_PERIOD" )->GetValue( metricsPeriod );
+	if( metricsPeriod < 1 ) metricsPeriod = 1;
+	gPARMS->SetDefaultParameter<string,string>( "TAC:CODECS", codecList );
+	gPARMS->GetParameter( "TAC:CODECS" )->GetValue( codecList );
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:CODEC_FILES", codecFiles );
+	gPARMS->GetParameter( "TAC:CODEC_FILES" )->GetValue( codecFiles );
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:FEATURES", featureOutput );
+	gPARMS->GetParameter( "TAC:FEATURES" )->GetValue( featureOutput );
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:FEATURES_SAMPLES", featureSamples );
+	gPARMS->GetParameter( "TAC:FEATURES_SAMPLES" )->GetValue( featureSamples );
+	gPARMS->SetDefaultParameter<string,double>( "TAC:FEATURES_TAGGER_WINDOW", featureTaggerWindow );
+	gPARMS->GetParameter( "TAC:FEATURES_TAGGER_WINDOW" )->GetValue( featureTaggerWindow );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:FEATURES_BLOCK_SIZE", featureBlockSize );
+	gPARMS->GetParameter( "TAC:FEATURES_BLOCK_SIZE" )->GetValue( featureBlockSize );
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:TAGGER_CALIBRATION", taggerCalibration );
+	gPARMS->GetParameter( "TAC:TAGGER_CALIBRATION" )->GetValue( taggerCalibration );
+	gPARMS->SetDefaultParameter<string,string>( "TAC:TAGGER_CALIBRATION_FILE", taggerCalibrationFile );
+	gPARMS->GetParameter( "TAC:TAGGER_CALIBRATION_FILE" )->GetValue( taggerCalibrationFile );
+	unsigned calibrationEntries = 500;
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:TAGGER_CALIBRATION_ENTRIES", calibrationEntries );
+	gPARMS->GetParameter( "TAC:TAGGER_CALIBRATION_ENTRIES" )->GetValue( calibrationEntries );
+	TaggerTimeCalibration::setEntriesPerUpdate( calibrationEntries );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:WAVEFORM_RING_SIZE", waveformRingSize );
+	gPARMS->GetParameter( "TAC:WAVEFORM_RING_SIZE" )->GetValue( waveformRingSize );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:WAVEFORM_DISPLAY_PERIOD", waveformDisplayPeriod );
+	gPARMS->GetParameter( "TAC:WAVEFORM_DISPLAY_PERIOD" )->GetValue( waveformDisplayPeriod );
+	if( waveformDisplayPeriod < 1 ) waveformDisplayPeriod = 1;
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:TEMPLATE_FIT", templateFit );
+	gPARMS->GetParameter( "TAC:TEMPLATE_FIT" )->GetValue( templateFit );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:TEMPLATE_MIN_ENTRIES", templateMinEntries );
+	gPARMS->GetParameter( "TAC:TEMPLATE_MIN_ENTRIES" )->GetValue( templateMinEntries );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:TEMPLATE_UPDATE_PERIOD", templateUpdatePeriod );
+	gPARMS->GetParameter( "TAC:TEMPLATE_UPDATE_PERIOD" )->GetValue( templateUpdatePeriod );
+	if( templateUpdatePeriod < 1 ) templateUpdatePeriod = 1;
+	gPARMS->SetDefaultParameter<string,bool>( "TAC:ANOMALIES", anomalyOutput );
+	gPARMS->GetParameter( "TAC:ANOMALIES" )->GetValue( anomalyOutput );
+	double anomalyChi2 = WaveformAnomalyDetector::getMaxChi2();
+	gPARMS->SetDefaultParameter<string,double>( "TAC:ANOMALY_CHI2", anomalyChi2 );
+	gPARMS->GetParameter( "TAC:ANOMALY_CHI2" )->GetValue( anomalyChi2 );
+	WaveformAnomalyDetector::setMaxChi2( anomalyChi2 );
+	double anomalyPeakThreshold = WaveformAnomalyDetector::getPeakThreshold();
+	gPARMS->SetDefaultParameter<string,double>( "TAC:ANOMALY_PEAK_THRESHOLD", anomalyPeakThreshold );
+	gPARMS->GetParameter( "TAC:ANOMALY_PEAK_THRESHOLD" )->GetValue( anomalyPeakThreshold );
+	WaveformAnomalyDetector::setPeakThreshold( anomalyPeakThreshold );
+	WaveformAnomalyDetector::setSaturationValue( maxPulseValue );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:ATOMIC_FLUSH_PERIOD", atomicFlushPeriod );
+	gPARMS->GetParameter( "TAC:ATOMIC_FLUSH_PERIOD" )->GetValue( atomicFlushPeriod );
+	if( atomicFlushPeriod < 1 ) atomicFlushPeriod = 1;
+	unsigned rollingSliceSeconds = RollingHistogram::getSliceSeconds();
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:ROLLING_SLICE_SECONDS", rollingSliceSeconds );
+	gPARMS->GetParameter( "TAC:ROLLING_SLICE_SECONDS" )->GetValue( rollingSliceSeconds );
+	RollingHistogram::setSliceSeconds( rollingSliceSeconds );
+	gPARMS->SetDefaultParameter<string,unsigned>( "TAC:ROLLING_WINDOW_SLICES", rollingWindowSlices );
+	gPARMS->GetParameter( "TAC:ROLLING_WINDOW_SLICES" )->GetValue( rollingWindowSlices );
+	rollingWindowSlices = min( max( rollingWindowSlices, 1u ), RollingHistogram::maxSlices );
 
 	cout << "Parameters are created " << endl;
 
-	// Create TAC directory and the histograms
-	TDirectory *mainDir = gDirectory;
+	if( !codecList.empty() ) {
+		vector<string> codecNames;
+		stringstream codecStream( codecList );
+		string codecName;
+		while( getline( codecStream, codecName, ',' ) ) {
+			if( !codecName.empty() ) codecNames.push_back( codecName );
+		}
+		dataCompressor = new CompressionTester( codecNames, codecFiles );
+	}
+
+	// Create TAC directory, the histograms of every run are made in it by brun()
 	rootDir = gDirectory->mkdir("TAC");
-	rootDir->cd();
-	createHistograms();
-	mainDir->cd();
+
+	// runFinisher writes the files while brun() may read one, and the snapshot
+	// threads write into their own in-memory files
+	ROOT::EnableThreadSafety();
+	runFinisher = thread( &JEventProcessor_TAC_Monitor::finishRuns, this );
+	if( !aggregatorAddress.empty() ) {
+		deltaPublisher = new HistogramDeltaPublisher( aggregatorAddress, histogramVersions );
+	}
+	if( !shmName.empty() ) {
+		shmPublisher = new HistogramShmPublisher( shmName, histogramVersions );
+	}
+	if( !metricsFile.empty() || !metricsSocket.empty() ) {
+		// The lock wait is only measured for the metrics
+		TimedWriteLock::setTimingEnabled( true );
+		metricsExporter = new TACMetricsExporter( metricsFile, metricsSocket, metricsPeriod );
+		metricsExporter->start();
+	}
+	if( featureOutput ) {
+		TACFeatureFormat::FileHeader featureHeader = {};
+		featureHeader.hasSamples = featureSamples ? 1 : 0;
+		featureHeader.taghTimeCutValue = timeCutValue_TAGH;
+		featureHeader.tagmTimeCutValue = timeCutValue_TAGM;
+		featureHeader.timeCutWidth = timeCutWidth_TAGH;
+		featureHeader.taggerWindow = featureTaggerWindow;
+		featureHeader.tacThreshold = tacThreshold;
+		featureHeader.fadc250RawTimeScale = fadc250RawTimeScale;
+		featureWriter = new TACFeatureWriter( featureHeader, featureBlockSize );
+	}
+	if( anomalyOutput ) {
+		// Same format as the feature files, always with the samples and all tagger hits
+		TACFeatureFormat::FileHeader anomalyHeader = {};
+		anomalyHeader.hasSamples = 1;
+		anomalyHeader.taghTimeCutValue = timeCutValue_TAGH;
+		anomalyHeader.tagmTimeCutValue = timeCutValue_TAGM;
+		anomalyHeader.timeCutWidth = timeCutWidth_TAGH;
+		anomalyHeader.taggerWindow = 0;
+		anomalyHeader.tacThreshold = tacThreshold;
+		anomalyHeader.fadc250RawTimeScale = fadc250RawTimeScale;
+		anomalyDetector = new WaveformAnomalyDetector();
+		anomalyWriter = new TACFeatureWriter( anomalyHeader, 256 );
+	}
+	if( waveformRingSize > 0 ) {
+		waveformRing = new WaveformRing( waveformRingSize );
+	}
+	if( templateFit ) {
+		pulseFit = new PulseTemplateFit();
+	}
+	if( taggerCalibration ) {
+		// One entry per bin of the ID histograms, which cover all counters
+		taghCalibration = new TaggerTimeCalibration( "TAGH",
+				findTACHistogramDefinition( "TAGH_ID" )->nBinsX, timeCutValue_TAGH, timeCutWidth_TAGH );
+		tagmCalibration = new TaggerTimeCalibration( "TAGM",
+				findTACHistogramDefinition( "TAGM_ID" )->nBinsX, timeCutValue_TAGM, timeCutWidth_TAGM );
+		taghCalibration->read( taggerCalibrationFile );
+		tagmCalibration->read( taggerCalibrationFile );
+	}
 
 	cout << "Done executing JEventProcessor_TAC_Monitor::init()"  << endl;
 	return NOERROR;
@@ -118,11 +345,53 @@ jerror_t JEventProcessor_TAC_Monitor::brun(jana::JEventLoop* eventLoop,
 	stringstream fileNameStream;
 	fileNameStream << "tac_monitor_" << runnumber << ".root" ;
 	rootFileName = fileNameStream.str();
+	runNumber = runnumber;
+	this->startRunHistograms( runnumber );
+
+	if( dataCompressor != nullptr ) {
+		stringstream prefixStram ;
+		prefixStram << "tac_monitor_" << runnumber;
+		dataCompressor->open( prefixStram.str() );
+	}
+
+	if( featureWriter != nullptr ) {
+		stringstream featureNameStream;
+		featureNameStream << "tac_features_" << runnumber << ".bin";
+		if( featureWriter->getFileName() != featureNameStream.str() ) {
+			featureWriter->open( featureNameStream.str() );
+		}
+	}
+
+	if( anomalyWriter != nullptr ) {
+		stringstream anomalyNameStream;
+		anomalyNameStream << "tac_anomalies_" << runnumber << ".bin";
+		if( anomalyWriter->getFileName() != anomalyNameStream.str() ) {
+			anomalyWriter->open( anomalyNameStream.str() );
+		}
+	}
 
-	stringstream prefixStram ;
-	prefixStram << "tac_monitor_" << runnumber;
-//	dataCompressor = new CompressionTester( prefixStram.str() );
+	// Move the histogram bins into the file of this run, or resume from it. A
+	// set taken back from the ended ones is still attached.
+	if( histogramMmap && currentRun->mmapStore == nullptr ) {
+		stringstream mmapNameStream;
+		mmapNameStream << "tac_monitor_" << runnumber << ".hist";
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		HistogramMmapStore* mmapStore = new HistogramMmapStore();
+		currentRun->mmapStore = mmapStore;
+		// The restored counts have to reach the snapshots and the publishers
+		if( mmapStore->attach( mmapNameStream.str(), runnumber, currentRun->histograms )
+				&& mmapStore->wasResumed() ) {
+			for( TH1* histo : currentRun->histograms )
+				histogramVersions.touch( histo );
+			this->restoreEfficiencies( *currentRun );
+		}
+	}
 
+	// A new segment per run, the readers notice that the old one is closed
+	if( shmPublisher != nullptr ) {
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		shmPublisher->create( runnumber, currentRun->histograms );
+	}
 
 	return NOERROR;
 }
@@ -147,6 +416,9 @@ jerror_t JEventProcessor_TAC_Monitor::evnt(jana::JEventLoop* eventLoop,
 	if (dynamic_cast<DApplication*>(japp) == nullptr)
 		return NOERROR;
 
+	TACMetrics::ThreadCounters& metrics = TACMetrics::getThreadCounters();
+	metrics.add(TACMetrics::EVENTS_SEEN);
+
 	// Get First Trigger Type
 	const DL1Trigger *trigWords = nullptr;
 	try {
@@ -157,398 +429,787 @@ jerror_t JEventProcessor_TAC_Monitor::evnt(jana::JEventLoop* eventLoop,
 	// Decide if to continue considering this event based on the trigger bit pattern
 	if (!triggerIsUseful(trigWords))
 		return NOERROR;
-	uint32_t usefulTriggerBits = triggerMask & trigWords->trig_mask;
+	metrics.add(TACMetrics::EVENTS_ACCEPTED);
+
+	// Copy what the monitor needs out of the JANA objects and fill the histograms.
+	// The per-event containers are kept by the thread from event to event.
+	TACEventArena& arena = TACEventArena::getThreadArena();
+	TACEventData& eventData = arena.eventData;
+	eventData.runNumber = eventLoop->GetJEvent().GetRunNumber();
+	eventData.eventNumber = eventNumber;
+	eventData.triggerMask = trigWords->trig_mask;
+	// Events of a run that is already written are not counted anywhere
+	shared_ptr<RunHistograms> run = this->acquireRunHistograms(eventData.runNumber);
+	if( run == nullptr ) {
+		metrics.add(TACMetrics::EVENTS_LATE);
+		return NOERROR;
+	}
+	this->collectEventData(eventLoop, arena);
+	this->analyzeEvent(*run, arena);
+	this->releaseRunHistograms(*run);
 
-	// Here we fill the raw waveforms
-	for (unsigned trigBit = 0; trigBit < numberOfTriggerBits; trigBit++) {
-		unsigned singleBit = 1 << trigBit;
-		if ((singleBit & usefulTriggerBits) != 0) {
-			this->fillRawDataHistograms(eventLoop, trigBit);
-			this->fillPulseDataHitograms(eventLoop, trigBit);
-			this->fillTDCHistograms(eventLoop, trigBit);
+	return NOERROR;
+}
+
+// Everything evnt() does with an accepted event once its data are collected,
+// tac_bench calls this with generated events
+void JEventProcessor_TAC_Monitor::analyzeEvent(RunHistograms& run,
+		TACEventArena& arena) {
+	TACEventData& eventData = arena.eventData;
+	this->processEvent(run, eventData);
+	this->countEventMetrics(eventData);
+	if( dataCompressor != nullptr && eventData.nWaveforms == 1 ) {
+		this->testCompression(run, eventData.samples);
+	}
+	if( featureWriter != nullptr || waveformRing != nullptr || anomalyDetector != nullptr ) {
+		TACEventSummary summary;
+		this->computeEventSummary(eventData, summary);
+		if( featureWriter != nullptr ) {
+			featureWriter->append(eventData, summary);
+		}
+		if( summary.anomalyFlags != 0 ) {
+			this->recordAnomaly(run, eventData, summary);
+		}
+		if( waveformRing != nullptr && eventData.nWaveforms == 1 ) {
+			waveformRing->push(eventData, summary);
 		}
 	}
+	uint64_t eventNumber = eventData.eventNumber;
+	arena.reset();
+
 	// Write histograms into ROOT file once in a while
 	if( eventNumber % 200000 == 0 ) {
-		this->writeHistograms();
+		this->requestSnapshot(run);
+	}
+	// Push the histogram changes to the aggregator once in a while
+	uint64_t eventCount = ++eventCounter;
+	if( waveformRing != nullptr && eventCount % waveformDisplayPeriod == 0 ) {
+		this->refreshWaveformDisplay(run);
+	}
+	if( eventCount % atomicFlushPeriod == 0 ) {
+		this->moveAtomicHistograms(run);
+		this->refreshRollingHistograms(run);
+	}
+	if( ( pulseFit != nullptr || anomalyDetector != nullptr )
+			&& eventCount % templateUpdatePeriod == 0 ) {
+		this->updatePulseTemplate(run);
+	}
+	if( deltaPublisher != nullptr && eventCount % aggregatorPeriod == 0 ) {
+		this->publishHistogramDeltas(run, false);
+	}
+	if( shmPublisher != nullptr && eventCount % shmPeriod == 0 ) {
+		this->publishSharedHistograms(run);
 	}
-
-	return NOERROR;
 }
 
-// Handle histograms with FADC250 raw data
-jerror_t JEventProcessor_TAC_Monitor::fillRawDataHistograms(
-		jana::JEventLoop* eventLoop, uint32_t trigBit) {
-	vector<const Df250WindowRawData*> rawDataVector;
-	eventLoop->Get(rawDataVector);
-
+// Get the TAC waveform, pulses, TDC hits and the tagger hits for the event
+jerror_t JEventProcessor_TAC_Monitor::collectEventData(
+		jana::JEventLoop* eventLoop, TACEventArena& arena) {
+	TACEventData& eventData = arena.eventData;
 	// Get rebuild vector and pull out the raw FADC hit from it
-	vector<const DTACHit*> tacRebuildHitVector;
+	vector<const DTACHit*>& tacRebuildHitVector = arena.tacRebuildHits;
 	eventLoop->Get( tacRebuildHitVector, "REBUILD" );
 
-	if( tacRebuildHitVector.size() < 1  ) {
-//		cout << "Could not find rebuild TAC hits: " << endl;
-		return NOERROR;
-	}
-	set<const Df250WindowRawData*> rawDataSet;
-	set<const JObject*> alreadyChecked;
-	int maxDepth = 3;
-	tacRebuildHitVector[0]->GetAssociatedAncestors(alreadyChecked, maxDepth, rawDataSet);
-
-	unsigned tacDataCounter = rawDataSet.size();
-//	cout << "Found " << rawDataSet.size() << " waveforms " << endl;
-	const Df250WindowRawData* tacRawData = nullptr;
-	if( rawDataSet.size() > 0 ) {
-		tacRawData = *(rawDataSet.begin());
-	} else {
-		return NOERROR;
+	eventData.nWaveforms = 0;
+	if( tacRebuildHitVector.size() > 0 ) {
+		vector<const Df250WindowRawData*>& rawData = arena.rawData;
+		int maxDepth = 3;
+		arena.findAncestors(tacRebuildHitVector[0], maxDepth, rawData);
+		eventData.nWaveforms = rawData.size();
+		// Only events with a single waveform are analyzed
+		if( rawData.size() == 1 ) {
+			eventData.samples = rawData[0]->samples;
+		}
 	}
 
-//	unsigned tacDataCounter = 0;
-//	// Pick the TAC raw data
-//	const Df250WindowRawData* tacRawData = nullptr;
-//	for (auto& rawData : rawDataVector) {
-//		if (rawData) {
-//			// Hard-coded the location of the TAC FADC signal, pick the TAC raw data
-//			if (rawData->rocid == 14 && rawData->slot == 20
-//					&& rawData->channel == 0) {
-//				tacRawData = rawData;
-//				tacDataCounter++;
-//			}
-//		}
-//	}
+	vector<const DTACDigiHit*>& tacDigiHitVector = arena.tacDigiHits;
+	eventLoop->Get(tacDigiHitVector);
+	for (auto tacDigiHit : tacDigiHitVector) {
+		if (tacDigiHit) {
+			TACEventData::Pulse pulse;
+			pulse.peak = double(tacDigiHit->getPulsePeak());
+			pulse.time = double(tacDigiHit->getPulseTime()) * fadc250DigiTimeScale;
+			pulse.integral = double(tacDigiHit->getPulseIntegral());
+			eventData.pulses.push_back(pulse);
+		}
+	}
 
-	unsigned tacTDCDataCounter = 0;
-	vector<const DCAEN1290TDCHit*> rawTDCDataVector;
-	eventLoop->Get(rawTDCDataVector);
-
-	const DDAQAddress* tacTDCRawData = nullptr;
-	for (auto& rawTDCData : rawTDCDataVector) {
-		if (rawTDCData) {
-//			cout << rawTDCData->rocid << " , " << rawTDCData->slot << "  , " << rawTDCData->channel << endl;
-			// Hard-coded the location of the TAC FADC signal, pick the TAC raw data
-			if (rawTDCData->rocid == 78 && rawTDCData->slot == 8
-					&& rawTDCData->channel == 18) {
-				tacTDCRawData = rawTDCData;
-				tacTDCDataCounter++;
-//				cout << "Found TAC TDC" << endl;
+	vector<const DTACTDCDigiHit*>& tacTDCDigiHits = arena.tacTDCDigiHits;
+	eventLoop->Get(tacTDCDigiHits);
+	eventData.nTDCHits = tacTDCDigiHits.size();
+	if( tacTDCDigiHits.size() > 0 ) {
+		const DTTabUtilities* ttabUtilities = nullptr;
+		eventLoop->GetSingle(ttabUtilities);
+		for (auto& tacTDCDigiHit : tacTDCDigiHits) {
+			if (tacTDCDigiHit) {
+				const DCAEN1290TDCHit* tacCaenRawHit = nullptr;
+				tacTDCDigiHit->GetSingleT(tacCaenRawHit);
+				if (tacCaenRawHit) {
+					eventData.tdcTimes.push_back(
+							ttabUtilities->Convert_DigiTimeToNs_CAEN1290TDC(
+									tacCaenRawHit));
+				}
 			}
 		}
 	}
 
+	vector<const DTAGHDigiHit*>& taghDigiHitVector = arena.taghDigiHits;
+	eventLoop->Get(taghDigiHitVector);
+	for (auto digiHit : taghDigiHitVector) {
+		if (digiHit != nullptr) {
+			TACEventData::TaggerHit hit;
+			hit.counter = digiHit->counter_id;
+			hit.time = double(digiHit->pulse_time) * fadc250DigiTimeScale;
+			eventData.taghHits.push_back(hit);
+		}
+	}
+	vector<const DTAGMDigiHit*>& tagmDigiHitVector = arena.tagmDigiHits;
+	eventLoop->Get(tagmDigiHitVector);
+	for (auto digiHit : tagmDigiHitVector) {
+		if (digiHit != nullptr) {
+			TACEventData::TaggerHit hit;
+			hit.counter = digiHit->column;
+			hit.time = double(digiHit->pulse_time) * fadc250DigiTimeScale;
+			eventData.tagmHits.push_back(hit);
+		}
+	}
+	return NOERROR;
+}
+
+// Fill the histograms of all useful trigger bits of the event
+jerror_t JEventProcessor_TAC_Monitor::processEvent(RunHistograms& run,
+		const TACEventData& eventData) {
+	if (taghCalibration != nullptr)
+		this->updateTaggerCalibration(eventData);
+	uint32_t usefulTriggerBits = triggerMask & eventData.triggerMask;
+	for (unsigned trigBit = 0; trigBit < numberOfTriggerBits; trigBit++) {
+		unsigned singleBit = 1u << trigBit;
+		if ((singleBit & usefulTriggerBits) != 0) {
+			this->fillRawDataHistograms(run, eventData, trigBit);
+			this->fillPulseDataHitograms(run, eventData, trigBit);
+			this->fillTDCHistograms(run, eventData, trigBit);
+		}
+	}
+	return NOERROR;
+}
+
+// Handle histograms with FADC250 raw data
+jerror_t JEventProcessor_TAC_Monitor::fillRawDataHistograms(RunHistograms& run,
+		const TACEventData& eventData, uint32_t trigBit) {
+	unsigned tacDataCounter = eventData.nWaveforms;
 
 //	if (tacDataCounter < 1) {
 //		cout << "Too few TAC raw hits: " << tacDataCounter << endl;
 //	}
 
-	if (tacDataCounter > 1) {
-		cout << "Too many TAC raw hits: " << tacDataCounter << endl;
-	}
-	// Only analyze events with a single hit in the FADC
+	// Only analyze events with a single hit in the FADC, the others are counted
+	// in the MULTIPLE_WAVEFORMS metric
 	if (tacDataCounter != 1)
 		return NOERROR;
 
 	// Fill the waveform histograms
 	{
-		volatile WriteLock rootRWLock(
-				*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		// Looked up once per event. Keys over 15 characters would allocate a
+		// string on every lookup, so that one is kept.
+		static const string entriesKey = "TACFADCRAW_ENTRIES";
+		TH1* rawHisto = run.histoMap["TACFADCRAW"][trigBit];
+		TH1* entriesHisto = run.histoMap[entriesKey][trigBit];
+		TH1* sumHisto = run.histoMap["TACFADCRAW_SUM"][trigBit];
 		int binNumber = 0;
-		for (auto& rawDataValue : tacRawData->samples) {
+		for (auto& rawDataValue : eventData.samples) {
 			binNumber++;
-			if (binNumber <= histoMap["TACFADCRAW"][trigBit]->GetNbinsX()) {
-				histoMap["TACFADCRAW"][trigBit]->SetBinContent(binNumber,
-						rawDataValue);
-				histoMap["TACFADCRAW_ENTRIES"][trigBit]->SetBinContent(
-						binNumber,
-						histoMap["TACFADCRAW_ENTRIES"][trigBit]->GetBinContent(
-								binNumber) + 1.0);
-				histoMap["TACFADCRAW_SUM"][trigBit]->SetBinContent(binNumber,
-						histoMap["TACFADCRAW_SUM"][trigBit]->GetBinContent(
-								binNumber) + rawDataValue);
+			if (binNumber <= rawHisto->GetNbinsX()) {
+				// With the rings TACFADCRAW is set by refreshWaveformDisplay()
+				if (waveformRing == nullptr)
+					rawHisto->SetBinContent(binNumber, rawDataValue);
+				entriesHisto->SetBinContent(binNumber,
+						entriesHisto->GetBinContent(binNumber) + 1.0);
+				sumHisto->SetBinContent(binNumber,
+						sumHisto->GetBinContent(binNumber) + rawDataValue);
 			}
 		}
-		histoMap["TACFADCRAW_AVG"][trigBit]->Divide(
-				histoMap["TACFADCRAW_SUM"][trigBit],
-				histoMap["TACFADCRAW_ENTRIES"][trigBit], 1, 1);
+		TH1* averageHisto = run.histoMap["TACFADCRAW_AVG"][trigBit];
+		averageHisto->Divide(sumHisto, entriesHisto, 1, 1);
+		if (waveformRing == nullptr)
+			histogramVersions.touch(rawHisto);
+		histogramVersions.touch(entriesHisto);
+		histogramVersions.touch(sumHisto);
+		histogramVersions.touch(averageHisto);
 	}
 
 	// Find the maximum by going through the raw data and comparing samples
 	pair<unsigned, unsigned> maxInfoPair = this->getPeakLocationAndValue(
-			tacRawData);
+			eventData.samples);
 	double maxValue = maxInfoPair.second;
 	// Find the TAC signal time by finding the bin where the signal is above threshold
-	double tacPeakTime = this->getPulseTime( tacRawData, tacThreshold );
+	double tacPeakTime = this->getPulseTime( eventData.samples, tacThreshold );
 	// Assign a bigger values for cases with overflows
 	if (maxValue >= maxPulseValue)
 		maxValue = overflowPulseValue;
+	// Fit with the average pulse shape once there is a template
+	PulseTemplateFit::Result fitResult;
+	bool fitIsGood = pulseFit != nullptr
+			&& pulseFit->fit(eventData.samples, fitResult);
+	if (fitIsGood && maxInfoPair.second >= maxPulseValue)
+		fitResult.amplitude = overflowPulseValue;
 	{
-		volatile WriteLock rootRWLock(
-				*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
-		histoMap["TACAmpWAVE"][trigBit]->Fill(maxValue);
-		histoMap["TACTimeWAVE"][trigBit]->Fill(tacPeakTime*fadc250RawTimeScale);
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		fillHisto(run.histoMap["TACAmpWAVE"][trigBit], maxValue);
+		fillHisto(run.histoMap["TACTimeWAVE"][trigBit], tacPeakTime*fadc250RawTimeScale);
+		if (fitIsGood) {
+			fillHisto(run.histoMap["TACAmpFIT"][trigBit], fitResult.amplitude);
+			fillHisto(run.histoMap["TACTimeFIT"][trigBit], fitResult.time*fadc250RawTimeScale);
+		}
 	}
 
-//	if (maxValue > (1 * tacThreshold)) {
-//		dataCompressor->writeData(tacRawData->samples);
-//	}
-
 	// Call methods to fill tagger (TAGH and TAGM) related histograms
-	vector<const DTAGHDigiHit*> taghDigiHitVector;
-	eventLoop->Get(taghDigiHitVector);
-	fillTaggerRelatedHistograms(taghDigiHitVector, trigBit, "TAGH", "WAVE", maxValue,
-			tacPeakTime, [&]( const DTAGHDigiHit* hit ) {return hit->counter_id;},
-			[&](const DTAGHDigiHit* hit ) -> bool {return fabs( hit->pulse_time*fadc250DigiTimeScale - timeCutValue_TAGH ) < timeCutWidth_TAGH;});
-	vector<const DTAGMDigiHit*> tagmDigiHitVector;
-	eventLoop->Get(tagmDigiHitVector);
-	fillTaggerRelatedHistograms(tagmDigiHitVector, trigBit, "TAGM", "WAVE", maxValue,
-			tacPeakTime, [&]( const DTAGMDigiHit* hit ) {return hit->column;},
-			[&](const DTAGMDigiHit* hit ) -> bool {return fabs( hit->pulse_time*fadc250DigiTimeScale - timeCutValue_TAGM ) < timeCutWidth_TAGM;});
+	fillTaggerRelatedHistograms(run, eventData.taghHits, trigBit, "TAGH", "WAVE",
+			maxValue, tacPeakTime, timeCutValue_TAGH, timeCutWidth_TAGH, taghCalibration);
+	fillTaggerRelatedHistograms(run, eventData.tagmHits, trigBit, "TAGM", "WAVE",
+			maxValue, tacPeakTime, timeCutValue_TAGM, timeCutWidth_TAGM, tagmCalibration);
 
 	return NOERROR;
 }
 
 // Handle histogram from FADC250 pulse data
-jerror_t JEventProcessor_TAC_Monitor::fillPulseDataHitograms(
-		jana::JEventLoop* eventLoop, uint32_t trigBit) {
-	vector<const DTACDigiHit*> tacDigiHitVector;
-	eventLoop->Get(tacDigiHitVector);
-
+jerror_t JEventProcessor_TAC_Monitor::fillPulseDataHitograms(RunHistograms& run,
+		const TACEventData& eventData, uint32_t trigBit) {
 	// Pick the only peak value from the TACDigiHit object
 	double pulsePeak = 0;
 	double pulseTime = 0;
 	double pulseIntegral = 0;
 	{
-		volatile WriteLock rootRWLock(
-				*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
-		histoMap["TAC_NHITS"][trigBit]->Fill(tacDigiHitVector.size());
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		fillHisto(run.histoMap["TAC_NHITS"][trigBit], eventData.pulses.size());
 	}
 	// Find the digi hit with the largest pulse and use its height and time
-	for (auto tacDigiHit : tacDigiHitVector) {
-		if (tacDigiHit) {
-			double currentPeak = double(tacDigiHit->getPulsePeak());
-			double currentIntegral = double(tacDigiHit->getPulseIntegral());
-			if (currentPeak > pulsePeak) {
-				pulsePeak = currentPeak;
-				pulseTime = double(tacDigiHit->getPulseTime())
-						* fadc250DigiTimeScale;
-			}
-			if( currentIntegral > pulseIntegral ) {
-				pulseIntegral = currentIntegral;
-			}
-		}
-	}
+	this->getLargestPulse(eventData.pulses, pulsePeak, pulseTime, pulseIntegral);
 	// Assign larger value when overflow is detected in FADC
 	if (pulsePeak >= maxPulseValue) {
 		pulsePeak = overflowPulseValue;
 		pulseIntegral = overflowPulseValue * 3.0;
 	}
 	{
-		volatile WriteLock rootRWLock(
-				*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
-		histoMap["TACAmpPULSE"][trigBit]->Fill(pulsePeak);
-		histoMap["TACTimePULSE"][trigBit]->Fill(pulseTime);
-		histoMap["TACIntegral"][trigBit]->Fill(pulseIntegral);
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		fillHisto(run.histoMap["TACAmpPULSE"][trigBit], pulsePeak);
+		fillHisto(run.histoMap["TACTimePULSE"][trigBit], pulseTime);
+		fillHisto(run.histoMap["TACIntegral"][trigBit], pulseIntegral);
 
 	}
-	vector<const DTAGHDigiHit*> taghDigiHitVector;
-	eventLoop->Get(taghDigiHitVector);
-	fillTaggerRelatedHistograms(taghDigiHitVector, trigBit, "TAGH", "PULSE",
-			pulsePeak, pulseTime,
-			[&]( const DTAGHDigiHit* hit ) {return hit->counter_id;},
-			[&](const DTAGHDigiHit* hit ) -> bool {return fabs( hit->pulse_time*fadc250DigiTimeScale - timeCutValue_TAGH ) < timeCutWidth_TAGH;});
-
-	vector<const DTAGMDigiHit*> tagmDigiHitVector;
-	eventLoop->Get(tagmDigiHitVector);
-	fillTaggerRelatedHistograms(tagmDigiHitVector, trigBit, "TAGM", "PULSE",
-			pulsePeak, pulseTime,
-			[&]( const DTAGMDigiHit* hit ) {return hit->column;},
-			[&](const DTAGMDigiHit* hit ) -> bool {return fabs( hit->pulse_time*fadc250DigiTimeScale - timeCutValue_TAGM ) < timeCutWidth_TAGM;});
+	fillRolling(run, "TACAmpPULSE", trigBit, pulsePeak);
+	fillRolling(run, "TACTimePULSE", trigBit, pulseTime);
+	fillTaggerRelatedHistograms(run, eventData.taghHits, trigBit, "TAGH", "PULSE",
+			pulsePeak, pulseTime, timeCutValue_TAGH, timeCutWidth_TAGH, taghCalibration);
+	fillTaggerRelatedHistograms(run, eventData.tagmHits, trigBit, "TAGM", "PULSE",
+			pulsePeak, pulseTime, timeCutValue_TAGM, timeCutWidth_TAGM, tagmCalibration);
 	return NOERROR;
 }
 
 
-jerror_t JEventProcessor_TAC_Monitor::fillTDCHistograms(
-		jana::JEventLoop* eventLoop, uint32_t trigBit) {
-	vector<const DTACTDCDigiHit*> tacTDCDigiHits;
-	eventLoop->Get(tacTDCDigiHits);
+// The TDC histograms have atomic bins and are filled without a lock. Every TDC
+// hit is paired with the time of the largest firmware pulse.
+jerror_t JEventProcessor_TAC_Monitor::fillTDCHistograms(RunHistograms& run,
+		const TACEventData& eventData, uint32_t trigBit) {
+	run.atomicHistoMap["TAC_NTDCHITS"][trigBit]->fill(eventData.nTDCHits);
+	AtomicHistogram* tdcTimeHisto = run.atomicHistoMap["TAC_TDCTIME"][trigBit];
+	for (auto tacTDCTime : eventData.tdcTimes) {
+		tdcTimeHisto->fill(tacTDCTime);
+		fillRolling(run, "TAC_TDCTIME", trigBit, tacTDCTime);
+	}
+	if (eventData.pulses.empty())
+		return NOERROR;
+	double pulsePeak, pulseTime, pulseIntegral;
+	this->getLargestPulse(eventData.pulses, pulsePeak, pulseTime, pulseIntegral);
+	AtomicHistogram* tdcADCTimeHisto = run.atomicHistoMap["TAC_TDCADCTIME"][trigBit];
+	for (auto tacTDCTime : eventData.tdcTimes) {
+		tdcADCTimeHisto->fill(tacTDCTime - pulseTime);
+	}
+	return NOERROR;
+}
 
-	{
-		volatile WriteLock rootRWLock(
-				*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
-		histoMap["TAC_NTDCHITS"][trigBit]->Fill(tacTDCDigiHits.size());
+// The views are rebuilt from the slices, the full-run histograms are not used
+void JEventProcessor_TAC_Monitor::refreshRollingHistograms(RunHistograms& run) {
+	volatile TimedWriteLock rootRWLock(*rootLock);
+	for (auto& histNameIter : run.rollingHistoMap) {
+		for (auto& histTrigIter : histNameIter.second) {
+			TH1* histo = run.histoMap[histNameIter.first + "_ROLLING"][histTrigIter.first];
+			histo->Reset();
+			TArrayD* cellArray = dynamic_cast<TArrayD*>(histo);
+			uint64_t nEntries = histTrigIter.second->addWindow(cellArray->fArray,
+					rollingWindowSlices);
+			histo->SetEntries(nEntries);
+			histogramVersions.touch(histo);
+		}
+	}
+	// Every useful event fills TACAmpPULSE once, the current slice is not complete yet
+	for (auto& histTrigIter : run.rollingHistoMap["TACAmpPULSE"]) {
+		TH1* rateHisto = run.histoMap["TAC_RATE"][histTrigIter.first];
+		rateHisto->Reset();
+		for (unsigned iSlice = 1; iSlice < RollingHistogram::maxSlices; iSlice++) {
+			rateHisto->SetBinContent(iSlice + 1,
+					double(histTrigIter.second->getSliceEntries(iSlice))
+							/ RollingHistogram::getSliceSeconds());
+		}
+		histogramVersions.touch(rateHisto);
 	}
+}
 
+// Only called when the histograms are written or published, the efficiencies
+// are not needed in between
+void JEventProcessor_TAC_Monitor::refreshEfficiencies(RunHistograms& run) {
+	volatile TimedWriteLock rootRWLock(*rootLock);
+	for (auto& detIter : run.efficiencyMap) {
+		for (auto& effTrigIter : detIter.second) {
+			unsigned trigBit = effTrigIter.first;
+			TH1* totalHisto = run.histoMap[detIter.first + "_ID_PULSE"][trigBit];
+			TH1* efficiencyHisto = run.histoMap[detIter.first + "_EFFICIENCY"][trigBit];
+			if (effTrigIter.second->refresh(totalHisto, efficiencyHisto)) {
+				histogramVersions.touch(totalHisto);
+				histogramVersions.touch(efficiencyHisto);
+			}
+		}
+	}
+}
 
-	const DTTabUtilities* ttabUtilities = nullptr;
-	eventLoop->GetSingle(ttabUtilities);
+// Called under the ROOT write lock. Otherwise the first refresh would replace
+// the restored hits with the counts since the restart, while the matched hits
+// keep theirs.
+void JEventProcessor_TAC_Monitor::restoreEfficiencies(RunHistograms& run) {
+	for (auto& detIter : run.efficiencyMap) {
+		for (auto& effTrigIter : detIter.second) {
+			unsigned trigBit = effTrigIter.first;
+			effTrigIter.second->restore(run.histoMap[detIter.first + "_ID_PULSE"][trigBit],
+					run.histoMap[detIter.first + "_ID_MATCHEDPULSE"][trigBit]);
+		}
+	}
+}
 
-	for (auto& tacTDCDigiHit : tacTDCDigiHits) {
-		if (tacTDCDigiHit) {
-			const DCAEN1290TDCHit* tacCaenRawHit = nullptr;
-			tacTDCDigiHit->GetSingleT(tacCaenRawHit);
-			if (tacTDCDigiHit) {
-				double tacTDCTime =
-						ttabUtilities->Convert_DigiTimeToNs_CAEN1290TDC(
-								tacCaenRawHit);
-				histoMap["TAC_TDCTIME"][trigBit]->Fill(double(tacTDCTime));
+void JEventProcessor_TAC_Monitor::moveAtomicHistograms(RunHistograms& run) {
+	volatile TimedWriteLock rootRWLock(*rootLock);
+	for (auto& histNameIter : run.atomicHistoMap) {
+		for (auto& histTrigIter : histNameIter.second) {
+			TH1* histo = run.histoMap[histNameIter.first][histTrigIter.first];
+			TArrayD* cellArray = dynamic_cast<TArrayD*>(histo);
+			uint64_t nMoved = histTrigIter.second->moveTo(cellArray->fArray);
+			if (nMoved > 0) {
+				histo->SetEntries(histo->GetEntries() + nMoved);
+				histogramVersions.touch(histo);
+			}
+		}
+	}
+	for (unsigned quantity = 0; quantity < run.codecAtomicHistoMap.size(); quantity++) {
+		for (unsigned iCodec = 0; iCodec < run.codecAtomicHistoMap[quantity].size(); iCodec++) {
+			TH1* histo = run.codecHistoMap[quantity][iCodec];
+			TArrayD* cellArray = dynamic_cast<TArrayD*>(histo);
+			uint64_t nMoved = run.codecAtomicHistoMap[quantity][iCodec]->moveTo(cellArray->fArray);
+			if (nMoved > 0) {
+				histo->SetEntries(histo->GetEntries() + nMoved);
+				histogramVersions.touch(histo);
 			}
 		}
 	}
-	return NOERROR;
 }
 
 
+// The histograms of the run are written and deleted in the background, the
+// events of the next run go into a new set in the meantime
 jerror_t JEventProcessor_TAC_Monitor::erun(void) {
-	this->writeHistograms();
-//	if( dataCompressor != nullptr ) {
-//		delete dataCompressor;
-//		dataCompressor = nullptr;
-//	}
+	if( currentRun == nullptr )
+		return NOERROR;
+	if( taghCalibration != nullptr ) {
+		this->writeTaggerCalibration( runNumber );
+	}
+	if( featureWriter != nullptr ) {
+		featureWriter->flush();
+	}
+	if( anomalyWriter != nullptr ) {
+		anomalyWriter->flush();
+	}
+	if( deltaPublisher != nullptr ) {
+		this->publishHistogramDeltas( *currentRun, true );
+	}
+	if( shmPublisher != nullptr ) {
+		this->publishSharedHistograms( *currentRun );
+	}
+	if( dataCompressor != nullptr ) {
+		dataCompressor->close();
+		dataCompressor->printStatistics( cout );
+	}
+	this->endRunHistograms();
 	return NOERROR;
 }
 
 jerror_t JEventProcessor_TAC_Monitor::fini(void) {
-//	TDirectory* oldDir = gDirectory;
-//	rootDir->cd();
-//	for (auto& histMapIter : histoMap) {
-//		auto& histMap = histMapIter.second;
-//		for (auto& histIter : histMap) {
-//			auto histPtr = histIter.second;
-////			if (histPtr != 0)
-////				histPtr->Write();
-//		}
-//	}
-//	oldDir->cd();
+	cout << "TAC event arena allocated in " << TACEventArena::getNumberOfAllocatingEvents()
+			<< " of " << TACEventArena::getNumberOfEvents() << " events" << endl;
+	// All events are done, the ended runs are written right away
+	this->endRunHistograms();
+	{
+		lock_guard<mutex> runGuard( runMutex );
+		finishing = true;
+	}
+	runCondition.notify_all();
+	if( runFinisher.joinable() ) {
+		runFinisher.join();
+	}
+	uint64_t nLateEvents = TACMetrics::getTotal( TACMetrics::EVENTS_LATE );
+	if( nLateEvents > 0 ) {
+		cout << "TAC: " << nLateEvents << " events came after the histograms of their run were written" << endl;
+	}
+	// Last export with the counts of the last run
+	if( metricsExporter != nullptr ) {
+		metricsExporter->stop();
+		delete metricsExporter;
+		metricsExporter = nullptr;
+	}
+	if( shmPublisher != nullptr ) {
+		delete shmPublisher;
+		shmPublisher = nullptr;
+	}
+	if( deltaPublisher != nullptr ) {
+		delete deltaPublisher;
+		deltaPublisher = nullptr;
+	}
+	if( featureWriter != nullptr ) {
+		delete featureWriter;
+		featureWriter = nullptr;
+	}
+	if( dataCompressor != nullptr ) {
+		delete dataCompressor;
+		dataCompressor = nullptr;
+	}
+	if( waveformRing != nullptr ) {
+		delete waveformRing;
+		waveformRing = nullptr;
+	}
+	if( pulseFit != nullptr ) {
+		delete pulseFit;
+		pulseFit = nullptr;
+	}
+	if( anomalyDetector != nullptr ) {
+		delete anomalyWriter;
+		delete anomalyDetector;
+		anomalyWriter = nullptr;
+		anomalyDetector = nullptr;
+	}
+	if( taghCalibration != nullptr ) {
+		delete taghCalibration;
+		delete tagmCalibration;
+		taghCalibration = nullptr;
+		tagmCalibration = nullptr;
+	}
 	return NOERROR;
 }
 
-void JEventProcessor_TAC_Monitor::createHistograms() {
+void JEventProcessor_TAC_Monitor::startRunHistograms(int32_t runNumber) {
+	// brun() may come again for the same run, with or without erun()
+	if (currentRun != nullptr && currentRun->runNumber == runNumber)
+		return;
+	this->endRunHistograms();
+	{
+		// An ended set that runFinisher has not taken yet goes on being filled
+		lock_guard<mutex> runGuard(runMutex);
+		auto runIter = runHistograms.find(runNumber);
+		if (runIter != runHistograms.end()) {
+			auto endedIter = find(endedRuns.begin(), endedRuns.end(), runIter->second);
+			if (endedIter != endedRuns.end()) {
+				endedRuns.erase(endedIter);
+				currentRun = runIter->second;
+				currentRun->ended = false;
+				return;
+			}
+		}
+	}
+	shared_ptr<RunHistograms> run = make_shared<RunHistograms>();
+	run->runNumber = runNumber;
+	run->snapshotWriter = new HistogramSnapshotWriter(snapshotThreads, histogramVersions);
+	// The file of a set already written is updated, not recreated
+	bool isWritten = startedRuns.count(runNumber) > 0;
+	run->snapshotWriter->setFileName(rootFileName, isWritten);
+	startedRuns.insert(runNumber);
+	{
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		TDirectory* mainDir = gDirectory;
+		if (rootDir != nullptr)
+			rootDir->cd();
+		createHistograms(*run);
+		if (dataCompressor != nullptr)
+			createCodecHistograms(*run);
+		mainDir->cd();
+		for (auto& histNameIter : run->histoMap) {
+			for (auto& histTrigIter : histNameIter.second)
+				run->histograms.push_back(histTrigIter.second);
+		}
+		for (auto& codecHistos : run->codecHistoMap)
+			run->histograms.insert(run->histograms.end(), codecHistos.begin(),
+					codecHistos.end());
+		if (isWritten)
+			restoreRunHistograms(*run);
+	}
+	{
+		lock_guard<mutex> runGuard(runMutex);
+		runHistograms[runNumber] = run;
+	}
+	currentRun = run;
+}
+
+// The new histograms are empty, adding the ones of the file restores them
+// whatever their merge mode. Otherwise the next snapshot would overwrite the
+// earlier counts of the run in the file.
+void JEventProcessor_TAC_Monitor::restoreRunHistograms(RunHistograms& run) {
+	const string& fileName = run.snapshotWriter->getFileName();
+	TDirectory::TContext directoryContext;
+	unique_ptr<TFile> inFile(TFile::Open(fileName.c_str(), "READ"));
+	if (!inFile || inFile->IsZombie()) {
+		cerr << "JEventProcessor_TAC_Monitor: cannot read " << fileName
+				<< ", run " << run.runNumber << " starts from empty histograms" << endl;
+		return;
+	}
+	unsigned nRestored = 0;
+	for (TH1* histo : run.histograms) {
+		unique_ptr<TH1> earlier(dynamic_cast<TH1*>(inFile->Get(histo->GetName())));
+		if (earlier == nullptr)
+			continue;
+		earlier->SetDirectory(nullptr);
+		histo->Add(earlier.get());
+		histogramVersions.touch(histo);
+		nRestored++;
+	}
+	this->restoreEfficiencies(run);
+	cout << "TAC: run " << run.runNumber << " goes on from " << nRestored
+			<< " histograms of " << fileName << endl;
+}
+
+void JEventProcessor_TAC_Monitor::endRunHistograms() {
+	shared_ptr<RunHistograms> run;
+	run.swap(currentRun);
+	if (run == nullptr)
+		return;
+	{
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		// The next run makes histograms with the same names in the TAC directory
+		for (TH1* histo : run->histograms)
+			histo->SetDirectory(nullptr);
+	}
+	run->ended = true;
+	{
+		lock_guard<mutex> runGuard(runMutex);
+		run->endTime = chrono::steady_clock::now();
+		endedRuns.push_back(run);
+	}
+	runCondition.notify_all();
+}
+
+// Every thread remembers the set of its last event, runMutex is only taken
+// when the run changes. The reference is weak, so a thread that sits idle
+// does not keep a finished set alive.
+shared_ptr<JEventProcessor_TAC_Monitor::RunHistograms> JEventProcessor_TAC_Monitor::acquireRunHistograms(
+		int32_t runNumber) {
+	static thread_local weak_ptr<RunHistograms> threadRun;
+	shared_ptr<RunHistograms> run = threadRun.lock();
+	if (run == nullptr || run->runNumber != runNumber || run->closed) {
+		lock_guard<mutex> runGuard(runMutex);
+		auto runIter = runHistograms.find(runNumber);
+		if (runIter == runHistograms.end()) {
+			threadRun.reset();
+			return nullptr;
+		}
+		run = runIter->second;
+		threadRun = run;
+	}
+	// finishRunHistograms() sets closed before it waits for nUsers to drop
+	run->nUsers++;
+	if (run->closed) {
+		this->releaseRunHistograms(*run);
+		return nullptr;
+	}
+	return run;
+}
+
+void JEventProcessor_TAC_Monitor::requestSnapshot(RunHistograms& run) {
+	{
+		lock_guard<mutex> runGuard(runMutex);
+		if (find(snapshotRequests.begin(), snapshotRequests.end(), run.runNumber)
+				!= snapshotRequests.end())
+			return;
+		snapshotRequests.push_back(run.runNumber);
+	}
+	runCondition.notify_all();
+}
+
+// All ROOT files are written by this thread, so the snapshots of a run and its
+// last write never overlap
+void JEventProcessor_TAC_Monitor::finishRuns() {
+	unique_lock<mutex> runLock(runMutex);
+	while (true) {
+		// Other threads may still be on events of an ended run
+		auto isDue = [this]() {
+			return finishing || !snapshotRequests.empty() || (!endedRuns.empty()
+					&& chrono::steady_clock::now()
+							>= endedRuns.front()->endTime + chrono::seconds(runEndDelay));
+		};
+		if (endedRuns.empty())
+			runCondition.wait(runLock, isDue);
+		else
+			runCondition.wait_until(runLock,
+					endedRuns.front()->endTime + chrono::seconds(runEndDelay), isDue);
+
+		if (!snapshotRequests.empty()) {
+			auto runIter = runHistograms.find(snapshotRequests.front());
+			snapshotRequests.pop_front();
+			if (runIter == runHistograms.end())
+				continue;
+			shared_ptr<RunHistograms> run = runIter->second;
+			runLock.unlock();
+			this->writeHistograms(*run);
+			runLock.lock();
+			continue;
+		}
+		if (endedRuns.empty()) {
+			if (finishing)
+				return;
+			continue;
+		}
+		if (!isDue())
+			continue;
+		shared_ptr<RunHistograms> run = endedRuns.front();
+		endedRuns.pop_front();
+		runLock.unlock();
+		this->finishRunHistograms(*run);
+		runLock.lock();
+		auto runIter = runHistograms.find(run->runNumber);
+		if (runIter != runHistograms.end() && runIter->second == run)
+			runHistograms.erase(runIter);
+	}
+}
+
+void JEventProcessor_TAC_Monitor::finishRunHistograms(RunHistograms& run) {
+	// The users may be in the middle of the reconstruction of their event
+	run.closed = true;
+	{
+		unique_lock<mutex> userLock(run.userMutex);
+		run.userCondition.wait(userLock, [&run]() {
+			return run.nUsers == 0;
+		});
+	}
+	this->writeHistograms(run);
+	// The events that came after erun() are pushed too
+	if (deltaPublisher != nullptr) {
+		this->publishHistogramDeltas(run, true);
+		deltaPublisher->forgetRun(run.runNumber);
+	}
+
+	volatile TimedWriteLock rootRWLock(*rootLock);
+	// ROOT deletes the bin arrays with the histograms, they have to be its own again
+	if (run.mmapStore != nullptr) {
+		delete run.mmapStore;
+		run.mmapStore = nullptr;
+	}
+	for (TH1* histo : run.histograms) {
+		histogramVersions.remove(histo);
+		delete histo;
+	}
+	run.histograms.clear();
+	run.histoMap.clear();
+	run.codecHistoMap.clear();
+	for (auto& histNameIter : run.atomicHistoMap) {
+		for (auto& histTrigIter : histNameIter.second)
+			delete histTrigIter.second;
+	}
+	run.atomicHistoMap.clear();
+	for (auto& histNameIter : run.rollingHistoMap) {
+		for (auto& histTrigIter : histNameIter.second)
+			delete histTrigIter.second;
+	}
+	run.rollingHistoMap.clear();
+	for (auto& detIter : run.efficiencyMap) {
+		for (auto& effTrigIter : detIter.second)
+			delete effTrigIter.second;
+	}
+	run.efficiencyMap.clear();
+	run.taggerHistoMap.clear();
+	for (auto& codecHistos : run.codecAtomicHistoMap) {
+		for (AtomicHistogram* histo : codecHistos)
+			delete histo;
+	}
+	run.codecAtomicHistoMap.clear();
+	delete run.snapshotWriter;
+	run.snapshotWriter = nullptr;
+	cout << "TAC: histograms of run " << run.runNumber << " written and deleted" << endl;
+}
+
+void JEventProcessor_TAC_Monitor::createHistograms(RunHistograms& run) {
 	cout << "Creating TAC histos" << endl;
 	for (unsigned trigBit = 0; trigBit < numberOfTriggerBits; trigBit++) {
-		unsigned trigPattern = 1 << trigBit;
+		unsigned trigPattern = 1u << trigBit;
 		if (triggerIsUseful(trigPattern)) {
-			// Create TAC FADc raw data
-			createHisto<TH1D>(trigBit, "TACFADCRAW", "Single TAC FADC waveform for Trigger ",
-					"FlashADC sample number [#]", 100, 0., 100.);
-			// Create TAC summed FADc raw data
-			createHisto<TH1D>(trigBit, "TACFADCRAW_SUM",
-					"Summed TAC FADC waveform for Trigger ", "FlashADC sample number [#]",
-					100, 0., 100.);
-			// Create TAC FADc raw data for entries
-			createHisto<TH1D>(trigBit, "TACFADCRAW_ENTRIES",
-					"Entries in TAC FADC waveform for Trigger  ",
-					"FlashADC sample number [#]", 100, 0., 100.);
-			// Create TAC averaged FADc raw data
-			createHisto<TH1D>(trigBit, "TACFADCRAW_AVG",
-					"Averaged TAC FADC waveform", "FlashADC sample number [#]",
-					100, 0., 100.);
-
-			// Create TAC number of ADC hits histogram
-			createHisto<TH1D>(trigBit, "TAC_NHITS",
-					"Number of ADC hits in TAC for Trigger ", "number of hits from FADC FPGA [#]",
-					7, 0., 7.);
-
-			// Create TAC number of TDC hits histogram
-			createHisto<TH1D>(trigBit, "TAC_NTDCHITS",
-					"Number of TDC hits in TAC for Trigger ", "number of TDC hits [#]",
-					7, 0., 7.);
-
-			// Create TAC TDC hit time
-			createHisto<TH1D>(trigBit, "TAC_TDCTIME", "TDC time in TAC for Trigger ",
-					"TDC time [ns]", 500, 0., 500.);
-
-
-			// Create TAC TDC hit time minus ADC time
-			createHisto<TH1D>(trigBit, "TAC_TDCADCTIME", "TDC-ADC time in TAC for Trigger ",
-					"TDC-ADC time [ns]", 1000, -500., 500.);
-
-			// Create TAC amplitude histos
-			createHisto<TH1D>(trigBit, "TACAmpPULSE",
-					"TAC Largest Signal Amplitude for Trigger ", "TAC Amplitude", 500,
-					0., 5000.);
-			// Create TAC amplitude histos for going through the data and picking the highest bin
-			createHisto<TH1D>(trigBit, "TACAmpWAVE",
-					"TAC Signal Maximum from Raw for Trigger ", "TAC Amplitude",
-					500, 0., 5000.);
-			// Create TAC integral histos from firmware
-			createHisto<TH1D>(trigBit, "TACIntegral",
-					"TAC Largest Signal Integral for Trigger ", "TAC Integral", 1000,
-					0., 14000.);
-			// Create TAC signal time histo
-			createHisto<TH1D>(trigBit, "TACTimePULSE",
-					"TAC Signal time from firmware for Trigger ", "FlashADC peak time (ns)",
-					400, 0., 400.);
-			// Create TAC signal time based on raw data histo
-			createHisto<TH1D>(trigBit, "TACTimeWAVE",
-					"TAC Signal based on raw data time for Trigger ", "FlashADC peak time (ns)",
-					400, 0., 400.);
-
-			// Create TAGH Hits detector ID
-			createHisto<TH1D>(trigBit, "TAGH_ID",
-					"TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]",
-					320, 0., 320.);
-			// Create TAGH Hits detector ID
-			createHisto<TH1D>(trigBit, "TAGH_ID_MATCHEDPULSE",
-					"Matched TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]",
-					320, 0., 320.);
-			createHisto<TH1D>(trigBit, "TAGH_ID_MATCHEDWAVE",
-					"Matched TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]",
-					320, 0., 320.);
-			// Create TAGH signal time histo
-			createHisto<TH1D>(trigBit, "TAGHSigTime",
-					"TAGH Signal time for Trigger ", "FlashADC peak time (ns)",
-					400, 0., 400.);
-			// Create TAC time vs TAGH FADC time histo
-			createHisto<TH2D>(trigBit, "TACTIMEPULSEvsTAGHTIME",
-					"TAC time vs TAGH time for Trigger ", "FlashADC peak time for TAGH (ns)", "FlashADC peak time for TAC (ns)",
-					400, 0., 400., 400, 0., 400. );
-			createHisto<TH2D>(trigBit, "TACTIMEWAVEvsTAGHTIME",
-					"TAC time vs TAGH time for Trigger ", "FlashADC peak time for TAGH (ns)", "FlashADC peak time for TAC (ns)",
-					400, 0., 400., 400, 0., 400. );
-			// Create TAC amplitude vs TAGH ID histo
-			createHisto<TH2D>(trigBit, "TACAMPPULSEvsTAGHID",
-					"TAC FADC Amplitude vs TAGH ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "FlashADC peak for TAC",
-					320, 0., 320., 1000, 10., 5000. );
-			createHisto<TH2D>(trigBit, "TACAMPWAVEvsTAGHID",
-					"TAC FADC Amplitude vs TAGH ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "FlashADC peak for TAC",
-					320, 0., 320., 1000, 10., 5000. );
-			// Create TAGH time vs TAGH ID histo
-			createHisto<TH2D>(trigBit, "TAGHTIMEvsTAGHID",
-					"TAGH Time vs TAGH ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "TAGH time",
-					320, 0., 320., 400, 0., 400. );
-
-			// Create TAGM Hits detector ID
-			createHisto<TH1D>(trigBit, "TAGM_ID",
-					"TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]",
-					110, 0., 110.);
-			// Create TAGM Hits detector ID
-			createHisto<TH1D>(trigBit, "TAGM_ID_MATCHEDPULSE",
-					"Matched TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]",
-					110, 0., 110.);
-			createHisto<TH1D>(trigBit, "TAGM_ID_MATCHEDWAVE",
-					"Matched TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]",
-					110, 0., 110.);
-			// Create TAGM signal time histo
-			createHisto<TH1D>(trigBit, "TAGMSigTime",
-					"TAGM Signal time for Trigger ", "FlashADC peak time (ns)",
-					400, 0., 400.);
-			createHisto<TH2D>(trigBit, "TACTIMEPULSEvsTAGMTIME",
-					"TAC time vs TAGM time for Trigger ", "FlashADC peak time for TAGM (ns)", "FlashADC peak time for TAC (ns)",
-					400, 0., 400., 400, 0., 400. );
-			createHisto<TH2D>(trigBit, "TACTIMEWAVEvsTAGMTIME",
-					"TAC time vs TAGM time for Trigger ", "FlashADC peak time for TAGM (ns)", "FlashADC peak time for TAC (ns)",
-					400, 0., 400., 400, 0., 400. );
-			// Create TAC amplitude vs TAGM ID histo
-			createHisto<TH2D>(trigBit, "TACAMPPULSEvsTAGMID",
-					"TAC FADC Amplitude vs TAGM ID for Trigger ", "Tagger Microscope Det. Number [#]", "FlashADC peak for TAC",
-					110, 0., 110., 1000, 10., 5000. );
-			createHisto<TH2D>(trigBit, "TACAMPWAVEvsTAGMID",
-					"TAC FADC Amplitude vs TAGM ID for Trigger ", "Tagger Microscope Det. Number [#]", "FlashADC peak for TAC",
-					110, 0., 110., 1000, 10., 5000. );
-			// Create TAGH time vs TAGH ID histo
-			createHisto<TH2D>(trigBit, "TAGMTIMEvsTAGMID",
-					"TAGM Time vs TAGM ID for Trigger ", "Tagger Microscope Det. Number [#]", "TAGM time",
-					110, 0., 110., 400, 0., 400. );
+			// The list of histograms is kept in TACHistogramDefinitions.h so that
+			// the stand-alone tools know about the same set
+			for (auto& def : getTACHistogramDefinitions()) {
+				if (def.atomic) {
+					run.atomicHistoMap[def.key][trigBit] = new AtomicHistogram(
+							def.nBinsX, def.xMin, def.xMax);
+				}
+				if (def.rolling) {
+					run.rollingHistoMap[def.key][trigBit] = new RollingHistogram(
+							def.nBinsX, def.xMin, def.xMax);
+				}
+				if (def.mergeMode == TACHistogramDefinition::MERGE_EFFICIENCY) {
+					string detComp = def.key.substr(0, def.key.find('_'));
+					run.efficiencyMap[detComp][trigBit] = new TaggerEfficiency(def.nBinsX);
+				}
+				if (def.is2D()) {
+					createHisto<TH2D>(run, trigBit, def.key, def.titlePrefix,
+							def.xTitle, def.yTitle, def.nBinsX, def.xMin,
+							def.xMax, def.nBinsY, def.yMin, def.yMax);
+				} else {
+					createHisto<TH1D>(run, trigBit, def.key, def.titlePrefix,
+							def.xTitle, def.nBinsX, def.xMin, def.xMax);
+				}
+			}
+			mapTaggerHistograms(run, trigBit);
+		}
+	}
+}
+
+// One histogram per codec and quantity
+void JEventProcessor_TAC_Monitor::createCodecHistograms(RunHistograms& run) {
+	unsigned nCodecs = dataCompressor->getNumberOfCodecs();
+	run.codecHistoMap.assign(numberOfCodecQuantities, vector<TH1*>(nCodecs));
+	run.codecAtomicHistoMap.assign(numberOfCodecQuantities, vector<AtomicHistogram*>(nCodecs));
+	for (unsigned quantity = 0; quantity < numberOfCodecQuantities; quantity++) {
+		auto& def = codecQuantities[quantity];
+		for (unsigned iCodec = 0; iCodec < nCodecs; iCodec++) {
+			const string& codecName = dataCompressor->getCodec(iCodec).getName();
+			string histName = string(def.key) + "_" + codecName;
+			TH1* histo = new TH1D(histName.c_str(), (def.title + codecName).c_str(),
+					def.nBins, def.low, def.high);
+			histo->GetXaxis()->SetTitle(def.xTitle);
+			run.codecHistoMap[quantity][iCodec] = histo;
+			run.codecAtomicHistoMap[quantity][iCodec] = new AtomicHistogram(def.nBins,
+					def.low, def.high);
+		}
+	}
+}
+
+void JEventProcessor_TAC_Monitor::mapTaggerHistograms(RunHistograms& run,
+		unsigned trigBit) {
+	for (string detComp : { "TAGH", "TAGM" }) {
+		for (string tacMethod : { "WAVE", "PULSE" }) {
+			TaggerHistograms& histos = run.taggerHistoMap[detComp + tacMethod][trigBit];
+			histos.id = run.histoMap[detComp + "_ID"][trigBit];
+			histos.sigTime = run.histoMap[detComp + "SigTime"][trigBit];
+			histos.tacTimeVsTime = run.histoMap["TACTIME" + tacMethod + "vs" + detComp + "TIME"][trigBit];
+			histos.timeVsId = run.histoMap[detComp + "TIMEvs" + detComp + "ID"][trigBit];
+			histos.matchedId = run.histoMap[detComp + "_ID_MATCHED" + tacMethod][trigBit];
+			histos.tacAmpVsId = run.histoMap["TACAMP" + tacMethod + "vs" + detComp + "ID"][trigBit];
+			auto rollingIter = run.rollingHistoMap.find(detComp + "_ID_MATCHED" + tacMethod);
+			if (rollingIter != run.rollingHistoMap.end())
+				histos.matchedIdRolling = rollingIter->second[trigBit];
+			auto effIter = run.efficiencyMap.find(detComp);
+			if (tacMethod == "PULSE" && effIter != run.efficiencyMap.end())
+				histos.efficiency = effIter->second[trigBit];
 		}
 	}
 }
@@ -556,8 +1217,8 @@ void JEventProcessor_TAC_Monitor::createHistograms() {
 // Create a 1D histogram of type TH1_TYPE and assign it to the histogram map based on the argument valeus
 // provided in the function call.
 template<typename TH1_TYPE>
-jerror_t JEventProcessor_TAC_Monitor::createHisto(unsigned trigBit,
-		string histKey, string titlePrefix, string xTitle, int nBins,
+jerror_t JEventProcessor_TAC_Monitor::createHisto(RunHistograms& run,
+		unsigned trigBit, string histKey, string titlePrefix, string xTitle, int nBins,
 		double xMin, double xMax) {
 	static_assert(std::is_base_of<TH1, TH1_TYPE>::value,
 	              "TH1_TYPE must be derived from TH1");
@@ -565,19 +1226,19 @@ jerror_t JEventProcessor_TAC_Monitor::createHisto(unsigned trigBit,
 	stringstream histTitle;
 	histName << histKey << "_" << trigBit;
 	histTitle << titlePrefix << trigBit;
-	if (histoMap.count(histName.str()) == 0)
-		histoMap[histName.str()] = map<unsigned, TH1*>();
-	histoMap[histKey][trigBit] = new TH1_TYPE(histName.str().c_str(),
+	if (run.histoMap.count(histName.str()) == 0)
+		run.histoMap[histName.str()] = map<unsigned, TH1*>();
+	run.histoMap[histKey][trigBit] = new TH1_TYPE(histName.str().c_str(),
 			histTitle.str().c_str(), nBins, xMin, xMax);
-	histoMap[histKey][trigBit]->GetXaxis()->SetTitle(xTitle.c_str());
+	run.histoMap[histKey][trigBit]->GetXaxis()->SetTitle(xTitle.c_str());
 	return NOERROR;
 }
 
 // Create a 2D histogram of type TH2_TYPE and assign it to the histogram map based on the argument valeus
 // provided in the function call.
 template<typename TH2_TYPE>
-jerror_t JEventProcessor_TAC_Monitor::createHisto(unsigned trigBit,
-		string histKey, string titlePrefix, string xTitle, string yTitle,
+jerror_t JEventProcessor_TAC_Monitor::createHisto(RunHistograms& run,
+		unsigned trigBit, string histKey, string titlePrefix, string xTitle, string yTitle,
 		int nBinsX, double xMin, double xMax, int nBinsY, double yMin,
 		double yMax) {
 	static_assert(std::is_base_of<TH2, TH2_TYPE>::value,
@@ -586,99 +1247,359 @@ jerror_t JEventProcessor_TAC_Monitor::createHisto(unsigned trigBit,
 	stringstream histTitle;
 	histName << histKey << "_" << trigBit;
 	histTitle << titlePrefix << trigBit;
-	if (histoMap.count(histName.str()) == 0)
-		histoMap[histName.str()] = map<unsigned, TH1*>();
-	histoMap[histKey][trigBit] = new TH2_TYPE(histName.str().c_str(),
+	if (run.histoMap.count(histName.str()) == 0)
+		run.histoMap[histName.str()] = map<unsigned, TH1*>();
+	run.histoMap[histKey][trigBit] = new TH2_TYPE(histName.str().c_str(),
 			histTitle.str().c_str(), nBinsX, xMin, xMax, nBinsY, yMin, yMax);
-	histoMap[histKey][trigBit]->GetXaxis()->SetTitle(xTitle.c_str());
-	histoMap[histKey][trigBit]->GetYaxis()->SetTitle(yTitle.c_str());
+	run.histoMap[histKey][trigBit]->GetXaxis()->SetTitle(xTitle.c_str());
+	run.histoMap[histKey][trigBit]->GetYaxis()->SetTitle(yTitle.c_str());
+	return NOERROR;
+}
+
+
+// Only one thread writes a snapshot, the others continue with their events.
+// The changed histograms are cloned under the lock, streamed and written without it.
+jerror_t JEventProcessor_TAC_Monitor::writeHistograms(RunHistograms& run) {
+	unique_lock<mutex> snapshotLock( run.snapshotWriter->getSnapshotMutex(), try_to_lock );
+	if( !snapshotLock.owns_lock() )
+		return NOERROR;
+	// The rings already hold the waveforms of the next run
+	if( !run.ended ) {
+		this->refreshWaveformDisplay(run);
+	}
+	this->moveAtomicHistograms(run);
+	this->refreshRollingHistograms(run);
+	this->refreshEfficiencies(run);
+	// The coincidence windows move on with the snapshots
+	if( taghCalibration != nullptr ) {
+		taghCalibration->fold();
+		tagmCalibration->fold();
+	}
+	auto snapshotStart = chrono::steady_clock::now();
+	{
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		run.snapshotWriter->collect( run.histograms );
+	}
+	run.snapshotWriter->write();
+	TACMetrics::ThreadCounters& metrics = TACMetrics::getThreadCounters();
+	metrics.add( TACMetrics::SNAPSHOTS );
+	metrics.add( TACMetrics::SNAPSHOT_NANOSECONDS, chrono::duration_cast<chrono::nanoseconds>(
+			chrono::steady_clock::now() - snapshotStart ).count() );
+
+	// The mapped bins do not need writing, this only makes them safe from a host crash
+	if( run.mmapStore != nullptr ) {
+		run.mmapStore->sync();
+	}
+
 	return NOERROR;
 }
 
+// Only one thread collects the changes, the others continue with their events.
+// The collection needs the histograms to be stable, the sending is done by the
+// sender thread of the publisher. Every run has its own stream, the sets of
+// ended runs are pushed until they are deleted.
+void JEventProcessor_TAC_Monitor::publishHistogramDeltas(RunHistograms& run,
+		bool wait) {
+	unique_lock<mutex> publishLock( deltaPublisher->getPublishMutex(), defer_lock );
+	if( wait )
+		publishLock.lock();
+	else if( !publishLock.try_lock() )
+		return;
+	this->moveAtomicHistograms(run);
+	this->refreshRollingHistograms(run);
+	this->refreshEfficiencies(run);
+	{
+		volatile ReadLock rootRWLock(*rootLock);
+		deltaPublisher->collect( run.runNumber, run.histograms );
+	}
+	deltaPublisher->send();
+}
+
+// Only one thread publishes, the others continue with their events. The
+// readers of the segment never take the ROOT lock. The segment holds the
+// histograms of the current run only.
+void JEventProcessor_TAC_Monitor::publishSharedHistograms(RunHistograms& run) {
+	if( run.ended )
+		return;
+	unique_lock<mutex> publishLock( shmPublisher->getPublishMutex(), try_to_lock );
+	if( !publishLock.owns_lock() )
+		return;
+	this->moveAtomicHistograms(run);
+	this->refreshRollingHistograms(run);
+	this->refreshEfficiencies(run);
+	volatile ReadLock rootRWLock(*rootLock);
+	shmPublisher->publish();
+}
+
+// The codec histograms are atomic, no lock is needed here
+void JEventProcessor_TAC_Monitor::testCompression(RunHistograms& run,
+		const vector<uint16_t>& samples) {
+	static thread_local vector<CompressionTester::CodecResult> codecResults;
+	dataCompressor->writeData(samples, codecResults);
+	for (unsigned iCodec = 0; iCodec < codecResults.size(); iCodec++) {
+		auto& result = codecResults[iCodec];
+		run.codecAtomicHistoMap[0][iCodec]->fill(result.bytesIn);
+		run.codecAtomicHistoMap[1][iCodec]->fill(result.bytesOut);
+		run.codecAtomicHistoMap[2][iCodec]->fill(result.bytesIn > 0 ? double(result.bytesOut) / result.bytesIn : 0.);
+		run.codecAtomicHistoMap[3][iCodec]->fill(result.encodeNs);
+	}
+}
 
-jerror_t JEventProcessor_TAC_Monitor::writeHistograms() {
-	volatile WriteLock rootRWLock(
-			*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
+// The quantities the histograms are filled from, before the overflow substitution
+// Once per event, the histograms are filled once per trigger bit
+void JEventProcessor_TAC_Monitor::countEventMetrics(const TACEventData& eventData) {
+	TACMetrics::ThreadCounters& metrics = TACMetrics::getThreadCounters();
+	if (eventData.nWaveforms > 1)
+		metrics.add(TACMetrics::MULTIPLE_WAVEFORMS);
+	unsigned nOverflows = 0;
+	for (auto& pulse : eventData.pulses) {
+		if (pulse.peak >= maxPulseValue)
+			nOverflows++;
+	}
+	metrics.add(TACMetrics::PULSES, eventData.pulses.size());
+	metrics.add(TACMetrics::OVERFLOW_PULSES, nOverflows);
+	if (TimedWriteLock::isTimingEnabled()) {
+		const TimedWriteLock::Statistics& lockStatistics = TimedWriteLock::getThreadStatistics();
+		metrics.set(TACMetrics::ROOT_LOCKS, lockStatistics.nLocks);
+		metrics.set(TACMetrics::ROOT_LOCK_WAIT_NANOSECONDS, lockStatistics.waitNanoseconds);
+	}
+}
 
-	TDirectory* oldDir = gDirectory;
-	TFile outFile( rootFileName.c_str(), "RECREATE" );
-	outFile.cd();
-	for( auto& histNameIter : histoMap ) {
-//		auto& histName =  histNameIter.first;
-		auto& histMapTrig = histNameIter.second;
-		for( auto& histTrigIter : histMapTrig ) {
-			auto histPointer = histTrigIter.second;
-			histPointer->Write();
+void JEventProcessor_TAC_Monitor::computeEventSummary(
+		const TACEventData& eventData, TACEventSummary& summary) {
+	if (eventData.nWaveforms == 1) {
+		summary.wavePeak = this->getPeakLocationAndValue(eventData.samples).second;
+		summary.waveTime = this->getPulseTime(eventData.samples, tacThreshold);
+		if (anomalyDetector != nullptr) {
+			WaveformAnomalyDetector::Result anomaly;
+			anomalyDetector->check(eventData.samples, anomaly);
+			summary.anomalyFlags = anomaly.flags;
+			summary.shapeChi2 = anomaly.chi2;
 		}
 	}
-	outFile.Write();
-	outFile.Close();
-	oldDir->cd();
+	this->getLargestPulse(eventData.pulses, summary.pulsePeak,
+			summary.pulseTime, summary.pulseIntegral);
+}
 
-	return NOERROR;
+// The rings are read without stopping the event threads, the ROOT lock is only
+// taken to copy the selected waveforms into the histograms.
+void JEventProcessor_TAC_Monitor::refreshWaveformDisplay(RunHistograms& run) {
+	if (waveformRing == nullptr)
+		return;
+	unique_lock<mutex> displayLock(waveformDisplayMutex, try_to_lock);
+	if (!displayLock.owns_lock())
+		return;
+	vector<WaveformRing::Record> records;
+	if (waveformRing->snapshot(records) == 0)
+		return;
+	// The rings still hold the last waveforms of the previous run
+	records.erase(remove_if(records.begin(), records.end(),
+			[&run](const WaveformRing::Record& record) {
+				return record.runNumber != run.runNumber;
+			}), records.end());
+	if (records.empty())
+		return;
+
+	volatile TimedWriteLock rootRWLock(*rootLock);
+	for (auto& histTrigIter : run.histoMap["TACFADCRAW_RECENT"]) {
+		unsigned trigBit = histTrigIter.first;
+		TH1* recentHisto = histTrigIter.second;
+		TH1* latestHisto = run.histoMap["TACFADCRAW"][trigBit];
+		int nRows = recentHisto->GetNbinsY();
+		int row = 0;
+		recentHisto->Reset();
+		for (auto& record : records) {
+			if ((record.triggerMask & (1u << trigBit)) == 0)
+				continue;
+			if (row == 0) {
+				latestHisto->Reset();
+				for (unsigned iSample = 0; iSample < record.nSamples
+						&& int(iSample) < latestHisto->GetNbinsX(); iSample++) {
+					latestHisto->SetBinContent(iSample + 1, record.samples[iSample]);
+				}
+			}
+			for (unsigned iSample = 0; iSample < record.nSamples
+					&& int(iSample) < recentHisto->GetNbinsX(); iSample++) {
+				recentHisto->SetBinContent(iSample + 1, row + 1,
+						record.samples[iSample]);
+			}
+			if (++row >= nRows)
+				break;
+		}
+		histogramVersions.touch(recentHisto);
+		histogramVersions.touch(latestHisto);
+	}
+}
+
+// Make the pulse template from the averaged waveform of the trigger bit with
+// the most entries
+void JEventProcessor_TAC_Monitor::updatePulseTemplate(RunHistograms& run) {
+	if (pulseFit == nullptr && anomalyDetector == nullptr)
+		return;
+	vector<double> averageWaveform;
+	{
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		TH1* sumHisto = nullptr;
+		TH1* entriesHisto = nullptr;
+		for (auto& histTrigIter : run.histoMap["TACFADCRAW_ENTRIES"]) {
+			if (entriesHisto == nullptr || histTrigIter.second->GetBinContent(1)
+					> entriesHisto->GetBinContent(1)) {
+				entriesHisto = histTrigIter.second;
+				sumHisto = run.histoMap["TACFADCRAW_SUM"][histTrigIter.first];
+			}
+		}
+		if (entriesHisto == nullptr
+				|| entriesHisto->GetBinContent(1) < templateMinEntries)
+			return;
+		for (int iBin = 1; iBin <= entriesHisto->GetNbinsX(); iBin++) {
+			double entries = entriesHisto->GetBinContent(iBin);
+			// Waveforms shorter than the histogram end the template
+			if (entries < 1)
+				break;
+			averageWaveform.push_back(sumHisto->GetBinContent(iBin) / entries);
+		}
+	}
+	// The template is made outside of the lock, the fits keep using the old one
+	if (pulseFit != nullptr)
+		pulseFit->update(averageWaveform);
+	if (anomalyDetector != nullptr)
+		anomalyDetector->setReference(averageWaveform);
+}
+
+// Count the flags of the unusual waveform for every useful trigger bit and
+// keep the event with its samples
+void JEventProcessor_TAC_Monitor::recordAnomaly(RunHistograms& run,
+		const TACEventData& eventData, const TACEventSummary& summary) {
+	uint32_t usefulTriggerBits = triggerMask & eventData.triggerMask;
+	{
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		for (unsigned trigBit = 0; trigBit < numberOfTriggerBits; trigBit++) {
+			if ((usefulTriggerBits & (1u << trigBit)) == 0)
+				continue;
+			for (unsigned iFlag = 0; iFlag < 3; iFlag++) {
+				if ((summary.anomalyFlags & (1u << iFlag)) != 0)
+					fillHisto(run.histoMap["TAC_ANOMALIES"][trigBit], iFlag);
+			}
+		}
+	}
+	if (anomalyWriter != nullptr)
+		anomalyWriter->append(eventData, summary);
+}
+
+// Pick the largest pulse peak with its time and the largest pulse integral
+void JEventProcessor_TAC_Monitor::getLargestPulse(
+		const vector<TACEventData::Pulse>& pulses, double& peak, double& time,
+		double& integral) {
+	peak = 0;
+	time = 0;
+	integral = 0;
+	for (auto& pulse : pulses) {
+		if (pulse.peak > peak) {
+			peak = pulse.peak;
+			time = pulse.time;
+		}
+		if( pulse.integral > integral ) {
+			integral = pulse.integral;
+		}
+	}
 }
 
 // Return a pair giving the peak location (first) and the peak value (second)
-inline pair<unsigned, unsigned> JEventProcessor_TAC_Monitor::getPeakLocationAndValue(
-		const Df250WindowRawData* tacRawData) {
+pair<unsigned, unsigned> JEventProcessor_TAC_Monitor::getPeakLocationAndValue(
+		const vector<uint16_t>& samples) {
 	// Find the maximum by going through the raw data and comparing samples
-	pair<double, double> maxInfo(0, 0);
-	if (tacRawData != nullptr) {
-		auto maxElement = std::max_element(tacRawData->samples.begin(),
-				tacRawData->samples.end());
-		maxInfo.first = std::distance(tacRawData->samples.begin(), maxElement);
+	pair<unsigned, unsigned> maxInfo(0, 0);
+	if (!samples.empty()) {
+		auto maxElement = std::max_element(samples.begin(), samples.end());
+		maxInfo.first = std::distance(samples.begin(), maxElement);
 		maxInfo.second = *maxElement;
 	}
 	return maxInfo;
 }
 
 // Return the time where the signal crosses the threshold
-inline unsigned JEventProcessor_TAC_Monitor::getPulseTime(
-		const Df250WindowRawData* tacRawData, unsigned threshold) {
-	if (tacRawData) {
-		// Find the iterator where the value in the sample is greater than the threshold
-		auto iterFound = std::find_if(tacRawData->samples.begin(),
-				tacRawData->samples.end(),
-				[&threshold]( const uint16_t& val) {return (val > threshold);});
-		// If the iterator found was meaningful then return the sample number
-		if (iterFound != tacRawData->samples.end()) {
-			return distance(tacRawData->samples.begin(), iterFound);
-		}
+unsigned JEventProcessor_TAC_Monitor::getPulseTime(
+		const vector<uint16_t>& samples, unsigned threshold) {
+	// Find the iterator where the value in the sample is greater than the threshold
+	auto iterFound = std::find_if(samples.begin(), samples.end(),
+			[&threshold]( const uint16_t& val) {return (val > threshold);});
+	// If the iterator found was meaningful then return the sample number
+	if (iterFound != samples.end()) {
+		return distance(samples.begin(), iterFound);
 	}
 	return 0;
 }
 
-// Fill Tagger-related histograms
-template<typename TAG_TYPE, typename CounterID, typename TIME_CUT>
-jerror_t JEventProcessor_TAC_Monitor::fillTaggerRelatedHistograms(
-		vector<const TAG_TYPE*>& digiHitVector, uint32_t trigBit,
+// Fill Tagger-related histograms. A tagger hit is matched to the TAC if its time
+// is within timeCutWidth of timeCutValue, or within the window of its counter
+// when the windows are calibrated.
+jerror_t JEventProcessor_TAC_Monitor::fillTaggerRelatedHistograms(RunHistograms& run,
+		const vector<TACEventData::TaggerHit>& taggerHits, uint32_t trigBit,
 		string detComp, string tacMethod, double tacPeak, double tacTime,
-		CounterID idFunctor, TIME_CUT timeCut) {
-	for (auto digiHit : digiHitVector) {
-		if (digiHit != nullptr) {
-			double tagTime = double(digiHit->pulse_time) * fadc250DigiTimeScale;
-			double detID = idFunctor(digiHit);
-			bool match = timeCut(digiHit);
-
-			volatile WriteLock rootRWLock(
-					*dynamic_cast<DApplication*>(japp)->GetRootReadWriteLock());
-			histoMap[detComp + "_ID"][trigBit]->Fill(detID);
-			histoMap[detComp + "SigTime"][trigBit]->Fill(tagTime);
-			histoMap["TACTIME" + tacMethod + "vs" + detComp + "TIME"][trigBit]->Fill(
-					tagTime, tacTime);
-			histoMap[detComp + "TIMEvs" + detComp + "ID"][trigBit]->Fill(detID,
-					tagTime);
-			if (match) {
-				histoMap[detComp + "_ID_MATCHED" + tacMethod][trigBit]->Fill(
-						detID);
-				histoMap["TACAMP" + tacMethod + "vs" + detComp + "ID"][trigBit]->Fill(
-						detID, tacPeak);
-			}
+		double timeCutValue, double timeCutWidth,
+		const TaggerTimeCalibration* calibration) {
+	if (taggerHits.empty())
+		return NOERROR;
+	// The key is short enough for the string not to allocate
+	const TaggerHistograms& histos = run.taggerHistoMap[detComp + tacMethod][trigBit];
+	unsigned nMatches = 0;
+	for (auto& taggerHit : taggerHits) {
+		double tagTime = taggerHit.time;
+		double detID = taggerHit.counter;
+		// The windows of the calibration are atomic, the match needs no lock
+		bool match = calibration != nullptr ?
+				calibration->isMatched( taggerHit.counter, tagTime ) :
+				fabs( tagTime - timeCutValue ) < timeCutWidth;
+
+		volatile TimedWriteLock rootRWLock(*rootLock);
+		fillHisto(histos.id, detID);
+		if (histos.efficiency != nullptr)
+			histos.efficiency->count(taggerHit.counter, match);
+		fillHisto(histos.sigTime, tagTime);
+		fillHisto(histos.tacTimeVsTime, tagTime, tacTime);
+		fillHisto(histos.timeVsId, detID, tagTime);
+		if (match) {
+			nMatches++;
+			fillHisto(histos.matchedId, detID);
+			if (histos.matchedIdRolling != nullptr)
+				histos.matchedIdRolling->fill(detID);
+			fillHisto(histos.tacAmpVsId, detID, tacPeak);
 		}
 	}
+	// The match rates follow the firmware pulses only
+	if (tacMethod == "PULSE") {
+		bool isTAGH = detComp == "TAGH";
+		TACMetrics::ThreadCounters& metrics = TACMetrics::getThreadCounters();
+		metrics.add(isTAGH ? TACMetrics::TAGH_HITS : TACMetrics::TAGM_HITS, taggerHits.size());
+		metrics.add(isTAGH ? TACMetrics::TAGH_MATCHES : TACMetrics::TAGM_MATCHES, nMatches);
+	}
 	return NOERROR;
 }
 
+// All tagger hits of the event go into the estimators, once per event. Every
+// thread fills its own histograms, they are added up by writeHistograms().
+void JEventProcessor_TAC_Monitor::updateTaggerCalibration(
+		const TACEventData& eventData) {
+	for (auto& taggerHit : eventData.taghHits) {
+		taghCalibration->update(taggerHit.counter, taggerHit.time);
+	}
+	for (auto& taggerHit : eventData.tagmHits) {
+		tagmCalibration->update(taggerHit.counter, taggerHit.time);
+	}
+}
+
+// The calibration file is the starting point for the next job, a copy is kept per run
+void JEventProcessor_TAC_Monitor::writeTaggerCalibration(int32_t runNumber) {
+	stringstream runFileStream;
+	runFileStream << "tac_tagger_calib_" << runNumber << ".txt";
+	taghCalibration->fold();
+	tagmCalibration->fold();
+	for (auto& fileName : { taggerCalibrationFile, runFileStream.str() }) {
+		taghCalibration->write(fileName);
+		tagmCalibration->write(fileName, true);
+	}
+}
+
 jerror_t JEventProcessor_TAC_Monitor::writeRawData( const Df250WindowRawData* tacRawData ) {
 
 	return NOERROR;
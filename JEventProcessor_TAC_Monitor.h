@@ -13,6 +13,15 @@
 #include <vector>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <deque>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <pthread.h>
 
 #include <TH1.h>
 
@@ -22,22 +31,154 @@
 #include <DAQ/Df250WindowRawData.h>
 
 #include "CompressionTester.h"
+#include "TACEventData.h"
+#include "TACEventArena.h"
+#include "TimedWriteLock.h"
+#include "HistogramDeltaPublisher.h"
+#include "HistogramMmapStore.h"
+#include "HistogramShmPublisher.h"
+#include "HistogramSnapshotWriter.h"
+#include "HistogramVersions.h"
+#include "TACFeatureWriter.h"
+#include "TaggerTimeCalibration.h"
+#include "WaveformRing.h"
+#include "PulseTemplateFit.h"
+#include "WaveformAnomalyDetector.h"
+#include "AtomicHistogram.h"
+#include "RollingHistogram.h"
+#include "TaggerEfficiency.h"
+#include "TACMetrics.h"
+#include "TACMetricsExporter.h"
 
 class JEventProcessor_TAC_Monitor: public jana::JEventProcessor {
 protected:
 
-	// Map of all histograms for this monitoring plugin. the first index identifies the
-	// name of the histogram, the second index (inner) identifies the trigger bit.
-	std::map<std::string, std::map<unsigned,TH1*> > histoMap;
+	// Histograms filled for every tagger hit, so that the names are not built per hit
+	struct TaggerHistograms {
+		TH1* id = nullptr;
+		TH1* sigTime = nullptr;
+		TH1* tacTimeVsTime = nullptr;
+		TH1* timeVsId = nullptr;
+		TH1* matchedId = nullptr;
+		TH1* tacAmpVsId = nullptr;
+		RollingHistogram* matchedIdRolling = nullptr;
+		// Only for the PULSE method
+		TaggerEfficiency* efficiency = nullptr;
+	};
+
+	// Histograms of one run. Every event is filled into the set of its own
+	// run, so that the runs are not mixed. Once the next run has started, the
+	// set is written and deleted in the background.
+	struct RunHistograms {
+		int32_t runNumber = 0;
+
+		// Map of all histograms for this monitoring plugin. the first index identifies the
+		// name of the histogram, the second index (inner) identifies the trigger bit.
+		std::map<std::string, std::map<unsigned,TH1*> > histoMap;
+
+		// Histograms filled without the ROOT lock, same indices as histoMap. Their
+		// counts are moved into the histograms of histoMap by moveAtomicHistograms().
+		std::map<std::string, std::map<unsigned,AtomicHistogram*> > atomicHistoMap;
+		// Time slices of the histograms marked rolling, shown in <key>_ROLLING
+		std::map<std::string, std::map<unsigned,RollingHistogram*> > rollingHistoMap;
+		// TAC efficiency counters of TAGH and TAGM, shown in <det>_EFFICIENCY
+		std::map<std::string, std::map<unsigned,TaggerEfficiency*> > efficiencyMap;
+		// Key is the detector followed by the method, like TAGHPULSE
+		std::map<std::string, std::map<unsigned,TaggerHistograms> > taggerHistoMap;
+		// Histograms of the compression test, [quantity][codec]. They are kept
+		// apart from histoMap, whose inner index is always a trigger bit.
+		std::vector<std::vector<TH1*> > codecHistoMap;
+		// Filled by testCompression() without the ROOT lock, same indices
+		std::vector<std::vector<AtomicHistogram*> > codecAtomicHistoMap;
+
+		// Every histogram of histoMap and codecHistoMap. This is what is written,
+		// published and kept in the memory-mapped file.
+		std::vector<TH1*> histograms;
+
+		// Writer of the changed histograms into the ROOT file of the run
+		HistogramSnapshotWriter* snapshotWriter = nullptr;
+		// Memory-mapped file holding the bins until the set is deleted, nullptr
+		// if disabled. The late events of an ended set still go into it.
+		HistogramMmapStore* mmapStore = nullptr;
+
+		// Number of threads filling the set at the moment
+		std::atomic<unsigned> nUsers{0};
+		// Signalled when the last user of a closed set releases it
+		std::mutex userMutex;
+		std::condition_variable userCondition;
+		// Set by erun(), the set is no longer published
+		std::atomic<bool> ended{false};
+		// Set before the set is written for the last time, nothing is filled after
+		std::atomic<bool> closed{false};
+		std::chrono::steady_clock::time_point endTime;
+	};
+
+	// Sets of the runs that are not written yet, by run number
+	std::map<int32_t, std::shared_ptr<RunHistograms> > runHistograms;
+	// Set of the run between brun() and erun()
+	std::shared_ptr<RunHistograms> currentRun;
+	// Protects runHistograms, endedRuns, snapshotRequests and finishing
+	std::mutex runMutex;
+	std::condition_variable runCondition;
+	// Ended sets waiting to be written and deleted by runFinisher
+	std::deque<std::shared_ptr<RunHistograms> > endedRuns;
+	// Runs whose periodic snapshot runFinisher is to write
+	std::deque<int32_t> snapshotRequests;
+	// Runs that had a set in this job, a new set of one of them continues its file
+	std::set<int32_t> startedRuns;
+	std::thread runFinisher;
+	// Set by fini(), the ended sets are written without waiting
+	bool finishing = false;
 
 	// ROOT file name
 	std::string rootFileName = "tac_monitor.root";
 
+	// Current run number
+	int32_t runNumber = 0;
+
 	// ROOT directory pointer
 	TDirectory* rootDir = nullptr;
 
+	// ROOT read-write lock of the application, protects the histograms
+	pthread_rwlock_t* rootLock = nullptr;
+	// Change counters of all histograms of all sets, protected by rootLock
+	HistogramVersions histogramVersions;
+
+	// Codecs compared on the waveforms, nullptr if the compression test is disabled
 	CompressionTester* dataCompressor = nullptr;
 
+	// Publisher of the histogram changes to the tac_aggregator daemon, nullptr if disabled
+	HistogramDeltaPublisher* deltaPublisher = nullptr;
+
+	// Shared-memory segment the histograms are published in, nullptr if disabled
+	HistogramShmPublisher* shmPublisher = nullptr;
+
+	// Thread exporting the TACMetrics counters, nullptr if disabled
+	TACMetricsExporter* metricsExporter = nullptr;
+
+	// Writer of the per-event features, nullptr if disabled
+	TACFeatureWriter* featureWriter = nullptr;
+
+	// Per-counter coincidence windows, nullptr if the calibration is disabled
+	TaggerTimeCalibration* taghCalibration = nullptr;
+	TaggerTimeCalibration* tagmCalibration = nullptr;
+
+	// Recent waveforms of every event thread, nullptr if disabled
+	WaveformRing* waveformRing = nullptr;
+	// Only one thread at a time refreshes the waveform histograms
+	std::mutex waveformDisplayMutex;
+
+	// Fit of the waveforms with the average pulse shape, nullptr if disabled
+	PulseTemplateFit* pulseFit = nullptr;
+
+	// Finds the unusual waveforms, nullptr if disabled
+	WaveformAnomalyDetector* anomalyDetector = nullptr;
+	// Writer of the events with unusual waveforms
+	TACFeatureWriter* anomalyWriter = nullptr;
+
+	// Number of events with useful trigger bits seen so far
+	std::atomic<uint64_t> eventCounter{0};
+
 	// Mask indicating which trigger bits this class cares for.
 	static uint32_t triggerMask;
 //	// Mask that specifies the TAC trigger bit
@@ -69,6 +210,71 @@ protected:
 	// Time units for the timing from raw FADC
 	static double fadc250RawTimeScale;
 
+	// Socket path or host:port of the tac_aggregator daemon, empty to disable
+	static std::string aggregatorAddress;
+	// Number of useful events between pushes to the aggregator
+	static unsigned aggregatorPeriod;
+
+	// Keep the histogram bins in a memory-mapped file per run
+	static bool histogramMmap;
+
+	// Name of the shared-memory segment for local display clients, empty to disable
+	static std::string shmName;
+	// Number of useful events between publications into the segment
+	static unsigned shmPeriod;
+
+	// Threads compressing the histograms of a snapshot of the ROOT file
+	static unsigned snapshotThreads;
+	// Seconds the histograms of an ended run wait for its last events before
+	// they are written and deleted
+	static unsigned runEndDelay;
+
+	// Prometheus text file and Unix socket of the metrics exporter, empty to disable
+	static std::string metricsFile;
+	static std::string metricsSocket;
+	// Seconds between metrics exports
+	static unsigned metricsPeriod;
+
+	// Comma-separated codecs of the compression test, "all" for all, empty to disable
+	static std::string codecList;
+	// Write the waveforms encoded by each codec into tac_monitor_<run>_<codec>.bin
+	static bool codecFiles;
+
+	// Write the per-event features into tac_features_<run>.bin
+	static bool featureOutput;
+	// Store the waveform samples with the features
+	static bool featureSamples;
+	// Store the tagger hits within this distance from the cut value, all if 0
+	static double featureTaggerWindow;
+	// Number of events in a block of the feature file
+	static unsigned featureBlockSize;
+
+	// Calibrate the coincidence window of every tagger counter while running
+	static bool taggerCalibration;
+	// File the calibration starts from and is written to at the end of a run
+	static std::string taggerCalibrationFile;
+
+	// Number of waveforms kept per event thread, 0 to fill TACFADCRAW every event
+	static unsigned waveformRingSize;
+	// Number of useful events between refreshes of the waveform histograms
+	static unsigned waveformDisplayPeriod;
+
+	// Fit the waveforms with the average pulse shape
+	static bool templateFit;
+	// Number of waveforms averaged before the template is made
+	static unsigned templateMinEntries;
+	// Number of useful events between updates of the template
+	static unsigned templateUpdatePeriod;
+
+	// Write the events with unusual waveforms into tac_anomalies_<run>.bin
+	static bool anomalyOutput;
+
+	// Number of useful events between moves of the atomic histograms
+	static unsigned atomicFlushPeriod;
+
+	// Number of time slices summed in the <key>_ROLLING histograms
+	static unsigned rollingWindowSlices;
+
 	virtual jerror_t init(void);          ///< Called once at program start.
 	virtual jerror_t brun(jana::JEventLoop *eventLoop, int32_t runNumber);          ///< Called everytime a new run number is detected.
 	virtual jerror_t evnt(jana::JEventLoop *eventLoop, uint64_t eventNumber);          ///< Called every event.
@@ -76,41 +282,129 @@ protected:
 	virtual jerror_t fini(void);          ///< Called after last event of last event source has been processed.
 
 	// Method where the histograms are created
-	virtual void createHistograms();
+	virtual void createHistograms(RunHistograms& run);
+	// Histograms of the compression test, TACCODEC_<quantity>_<codec>. The codec
+	// names are never numbers, so the tools do not take them for trigger bits.
+	virtual void createCodecHistograms(RunHistograms& run);
+
+	// Make the set of a new run in the TAC directory, it becomes currentRun. The
+	// set of the same run is kept if it is not written yet, a run already
+	// written starts from the histograms in its file.
+	virtual void startRunHistograms(int32_t runNumber);
+	// Take currentRun out of the TAC directory and queue it to be written
+	virtual void endRunHistograms();
+	// Add the histograms of a run already written and deleted to its new set
+	virtual void restoreRunHistograms(RunHistograms& run);
+	// The set of the run, counted as in use until releaseRunHistograms(). The
+	// caller holds on to it until then. nullptr if the set of the run was
+	// written already.
+	virtual std::shared_ptr<RunHistograms> acquireRunHistograms(int32_t runNumber);
+	void releaseRunHistograms(RunHistograms& run) {
+		if (--run.nUsers == 0 && run.closed) {
+			std::lock_guard<std::mutex> userGuard(run.userMutex);
+			run.userCondition.notify_all();
+		}
+	}
+	// Have runFinisher write a snapshot of the set, the event threads go on
+	virtual void requestSnapshot(RunHistograms& run);
+	// Body of runFinisher, writes the snapshots and writes and deletes the ended sets
+	virtual void finishRuns();
+	// Wait for the last events of the set, write it and delete its histograms
+	virtual void finishRunHistograms(RunHistograms& run);
+
+	// Copy the data used by the monitor out of the JANA objects into the
+	// eventData of the arena, using its containers for the JANA objects
+	virtual jerror_t collectEventData(jana::JEventLoop* eventLoop,
+			TACEventArena& arena);
+	// Fill the histograms, summarize, compress and keep the collected event of
+	// the arena, reset the arena and run the periodic tasks
+	virtual void analyzeEvent(RunHistograms& run, TACEventArena& arena);
+	// Fill the histograms for all useful trigger bits of the event
+	virtual jerror_t processEvent(RunHistograms& run, const TACEventData& eventData);
 	// Fill raw data histograms (the ones related to waveforms
-	virtual jerror_t fillRawDataHistograms(jana::JEventLoop* eventLoop,
-			uint32_t trigBit);
+	virtual jerror_t fillRawDataHistograms(RunHistograms& run,
+			const TACEventData& eventData, uint32_t trigBit);
 	// Fill pulse data histograms
-	virtual jerror_t fillPulseDataHitograms(jana::JEventLoop* eventLoop,
-			uint32_t trigBit);
+	virtual jerror_t fillPulseDataHitograms(RunHistograms& run,
+			const TACEventData& eventData, uint32_t trigBit);
 
 	// Fill F1TDC related histograms
-	virtual jerror_t fillTDCHistograms( jana::JEventLoop* eventLoop, uint32_t trigBit );
+	virtual jerror_t fillTDCHistograms(RunHistograms& run,
+			const TACEventData& eventData, uint32_t trigBit);
 
-	// Fill tagger related histos
-	template<typename DATA_TYPE, typename CounterID, typename TIME_CUT>
-	jerror_t fillTaggerRelatedHistograms(
-			std::vector<const DATA_TYPE*>& digiHitVector, uint32_t trigBit,
-			std::string detComp, std::string tacMethod, double tacPeak,
-			double tacTime, CounterID idFunctor, TIME_CUT timeCut);
+	// Look up the histograms of taggerHistoMap once they are all created
+	virtual void mapTaggerHistograms(RunHistograms& run, unsigned trigBit);
 
+	// Fill tagger related histos
+	virtual jerror_t fillTaggerRelatedHistograms(RunHistograms& run,
+			const std::vector<TACEventData::TaggerHit>& taggerHits,
+			uint32_t trigBit, std::string detComp, std::string tacMethod,
+			double tacPeak, double tacTime, double timeCutValue,
+			double timeCutWidth, const TaggerTimeCalibration* calibration);
+
+	// Update the per-counter windows with the tagger hits of the event
+	virtual void updateTaggerCalibration(const TACEventData& eventData);
+	// Write the per-counter windows into the calibration file
+	virtual void writeTaggerCalibration(int32_t runNumber);
+
+	// Count the event in the TACMetrics counters of the thread
+	virtual void countEventMetrics(const TACEventData& eventData);
+	// Compute the WAVE and PULSE quantities stored with the event
+	virtual void computeEventSummary(const TACEventData& eventData,
+			TACEventSummary& summary);
+	// Set TACFADCRAW and TACFADCRAW_RECENT from the waveform rings
+	virtual void refreshWaveformDisplay(RunHistograms& run);
+	// Make a new pulse template from the averaged waveform
+	virtual void updatePulseTemplate(RunHistograms& run);
+	// Count the unusual waveform and write the event out
+	virtual void recordAnomaly(RunHistograms& run, const TACEventData& eventData,
+			const TACEventSummary& summary);
+
+	// Find the largest pulse peak with its time and the largest integral
+	virtual void getLargestPulse(const std::vector<TACEventData::Pulse>& pulses,
+			double& peak, double& time, double& integral);
 	// Return a pair giving the peak location (first) and the peak value (second)
-	virtual std::pair<unsigned,unsigned> getPeakLocationAndValue( const Df250WindowRawData* data );
+	virtual std::pair<unsigned,unsigned> getPeakLocationAndValue( const std::vector<uint16_t>& samples );
 	// Return the time where the signal crosses the threshold
-	virtual unsigned getPulseTime( const Df250WindowRawData* data, unsigned threshold );
+	virtual unsigned getPulseTime( const std::vector<uint16_t>& samples, unsigned threshold );
 
 	template<typename TH1_TYPE>
-	jerror_t createHisto(unsigned trigBit, std::string key,
+	jerror_t createHisto(RunHistograms& run, unsigned trigBit, std::string key,
 			std::string titlePrefix, std::string xTitle, int nBins, double xMin,
 			double xMax);
 	template<typename TH2_TYPE>
-	jerror_t createHisto(unsigned trigBit,
+	jerror_t createHisto(RunHistograms& run, unsigned trigBit,
 			std::string histKey, std::string xTitlePrefix, std::string xTitle,
 			std::string yTitle, int nBinsX, double xMin, double xMax,
 			int nBinsY, double yMin, double yMax);
 
 	// Write histograms into the file
-	virtual jerror_t writeHistograms();
+	virtual jerror_t writeHistograms(RunHistograms& run);
+
+	// Add the counts of the atomic histograms to the ROOT histograms
+	virtual void moveAtomicHistograms(RunHistograms& run);
+	// Set the <key>_ROLLING histograms and TAC_RATE from the time slices
+	virtual void refreshRollingHistograms(RunHistograms& run);
+	// Set <det>_ID_PULSE and <det>_EFFICIENCY from the efficiency counters
+	virtual void refreshEfficiencies(RunHistograms& run);
+	// Set the efficiency counters from the restored <det>_ID_PULSE and
+	// <det>_ID_MATCHEDPULSE histograms
+	virtual void restoreEfficiencies(RunHistograms& run);
+	// Encode the waveform with every codec and fill the codec histograms
+	virtual void testCompression(RunHistograms& run, const std::vector<uint16_t>& samples);
+	// Copy the changed histograms into the shared-memory segment
+	virtual void publishSharedHistograms(RunHistograms& run);
+	// Fill the rolling histogram of the key if there is one
+	void fillRolling(RunHistograms& run, const std::string& key, uint32_t trigBit,
+			double value) {
+		auto rollingIter = run.rollingHistoMap.find(key);
+		if (rollingIter != run.rollingHistoMap.end())
+			rollingIter->second[trigBit]->fill(value);
+	}
+
+	// Send the histogram changes since the last push to the aggregator. With
+	// wait the push is never skipped because another thread is pushing.
+	virtual void publishHistogramDeltas(RunHistograms& run, bool wait);
 
 	// Check the file compression by writing out some files.
 	static jerror_t writeRawData( const Df250WindowRawData* tacRawData );
@@ -130,6 +424,17 @@ protected:
 		return true;
 	}
 
+	// Fill under the ROOT write lock and mark the histogram as changed for the
+	// snapshots and the publishers
+	void fillHisto(TH1* histo, double x) {
+		histo->Fill(x);
+		histogramVersions.touch(histo);
+	}
+	void fillHisto(TH1* histo, double x, double y) {
+		histo->Fill(x, y);
+		histogramVersions.touch(histo);
+	}
+
 public:
 
 	JEventProcessor_TAC_Monitor(){}
@@ -0,0 +1,307 @@
+/*
+ * PredictiveWaveformCodec.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "PredictiveWaveformCodec.h"
+#include "WaveformCodec.h"
+#include "TACFeatureFormat.h"
+#include "RiceCoding.h"
+
+using namespace std;
+using namespace PredictiveWaveformFormat;
+using TACFeatureFormat::putVarint;
+using TACFeatureFormat::getVarint;
+
+namespace {
+
+int32_t getPedestal(const vector<uint16_t>& samples) {
+	unsigned nSamples = min<size_t>(nPedestalSamples, samples.size());
+	int32_t sum = 0;
+	for (unsigned iSample = 0; iSample < nSamples; iSample++)
+		sum += samples[iSample];
+	return nSamples == 0 ? 0 : (sum + int32_t(nSamples) / 2) / int32_t(nSamples);
+}
+
+// Rice parameter following the residuals of the last samples, so that the
+// pulse and the baseline get their own. Starts from the waveform average.
+class AdaptiveParameter {
+protected:
+	uint32_t sum;
+	uint32_t count;
+	static const uint32_t maxCount = 8;
+public:
+	AdaptiveParameter(unsigned k) :
+			sum(maxCount << k), count(maxCount) {
+	}
+	unsigned get() const {
+		unsigned k = 0;
+		while (k < 15 && (count << (k + 1)) <= sum)
+			k++;
+		return k;
+	}
+	void update(uint32_t residual) {
+		sum += min<uint32_t>(residual, 1u << 20);
+		if (++count > maxCount * 2) {
+			sum /= 2;
+			count /= 2;
+		}
+	}
+};
+
+void putSigned(vector<char>& out, int32_t value) {
+	putVarint(out, RiceCoding::zigzag(value));
+}
+
+bool getSigned(const char*& current, const char* end, int32_t& value) {
+	uint64_t coded;
+	if (!getVarint(current, end, coded))
+		return false;
+	value = RiceCoding::unzigzag(uint32_t(coded));
+	return true;
+}
+
+}
+
+void PredictiveWaveformEncoder::startKeyframe(ChannelState& state,
+		const vector<uint16_t>& samples, int32_t pedestal) {
+	Keyframe& keyframe = state.keyframe;
+	if (state.started)
+		keyframe.generation++;
+	keyframe.pedestal = pedestal;
+	if (!state.started || state.average.size() != samples.size()) {
+		// Nothing to average yet, the waveform itself is the template
+		state.average.resize(samples.size());
+		for (unsigned iSample = 0; iSample < samples.size(); iSample++)
+			state.average[iSample] = int32_t(samples[iSample]) - pedestal;
+	}
+	keyframe.shape.resize(samples.size());
+	for (unsigned iSample = 0; iSample < samples.size(); iSample++)
+		keyframe.shape[iSample] = int32_t(lround(state.average[iSample]));
+	prepareShifts(keyframe);
+	state.started = true;
+	state.nSinceKeyframe = 0;
+}
+
+void PredictiveWaveformEncoder::encode(unsigned channel,
+		const vector<uint16_t>& samples, vector<char>& dest) {
+	static thread_local vector<char> payload;
+	static thread_local vector<uint32_t> residuals;
+	// There is no template for an empty waveform
+	if (samples.empty() || samples.size() > maxSamples) {
+		dest.clear();
+		return;
+	}
+	payload.clear();
+	int32_t pedestal = getPedestal(samples);
+
+	lock_guard<mutex> guard(encoderMutex);
+	ChannelState& state = channels[channel];
+	bool isKeyframe = !state.started || state.nSinceKeyframe >= keyframeInterval
+			|| state.keyframe.shape.size() != samples.size();
+	if (isKeyframe)
+		startKeyframe(state, samples, pedestal);
+	const Keyframe& keyframe = state.keyframe;
+
+	putVarint(payload, channel);
+	payload.push_back(char(keyframe.generation));
+	if (isKeyframe) {
+		putVarint(payload, samples.size());
+		payload.push_back(char(keyframe.pedestal & 0xFF));
+		payload.push_back(char((keyframe.pedestal >> 8) & 0xFF));
+		int32_t previous = 0;
+		for (auto value : keyframe.shape) {
+			putSigned(payload, value - previous);
+			previous = value;
+		}
+	}
+
+	// Shift with the best least-squares fit, in steps of half a sample and
+	// then around the best one, and its amplitude
+	static thread_local vector<double> signal;
+	signal.resize(samples.size());
+	double signalNorm = 0.;
+	for (unsigned iSample = 0; iSample < samples.size(); iSample++) {
+		signal[iSample] = int32_t(samples[iSample]) - pedestal;
+		signalNorm += signal[iSample] * signal[iSample];
+	}
+	int32_t bestShift = 0;
+	double bestScore = -1., bestProduct = 0., bestNorm = 0.;
+	auto tryShift = [&](int32_t shift) {
+		const int32_t* shifted = getShifted(keyframe, shift);
+		double product = 0., norm = 0.;
+		for (unsigned iSample = 0; iSample < samples.size(); iSample++) {
+			product += signal[iSample] * shifted[iSample];
+			norm += double(shifted[iSample]) * shifted[iSample];
+		}
+		double score = norm > 0. ? product * product / norm : 0.;
+		if (score > bestScore) {
+			bestScore = score;
+			bestShift = shift;
+			bestProduct = product;
+			bestNorm = norm;
+		}
+	};
+	for (int32_t shift = -maxShift; shift <= maxShift; shift += shiftSteps / 2)
+		tryShift(shift);
+	int32_t coarseShift = bestShift;
+	for (int32_t shift = max(coarseShift - shiftSteps / 2 + 1, -maxShift);
+			shift <= min(coarseShift + shiftSteps / 2 - 1, maxShift); shift++)
+		if (shift != coarseShift)
+			tryShift(shift);
+	// A flat waveform needs no shift
+	if (bestScore <= 0. || signalNorm <= 0.)
+		bestShift = 0;
+	int32_t amplitude = bestNorm > 0. ?
+			int32_t(lround(amplitudeScale * shiftSteps * bestProduct / bestNorm)) : 0;
+	putSigned(payload, pedestal - keyframe.pedestal);
+	putSigned(payload, bestShift);
+	putSigned(payload, amplitude);
+
+	const int32_t* shifted = getShifted(keyframe, bestShift);
+	residuals.resize(samples.size());
+	uint64_t sum = 0;
+	for (unsigned iSample = 0; iSample < samples.size(); iSample++) {
+		residuals[iSample] = RiceCoding::zigzag(int32_t(samples[iSample])
+				- predict(shifted, pedestal, amplitude, iSample));
+		sum += residuals[iSample];
+	}
+	unsigned k = RiceCoding::getParameter(sum, residuals.size());
+	payload.push_back(char(k));
+	RiceCoding::BitWriter writer(payload);
+	AdaptiveParameter parameter(k);
+	for (auto residual : residuals) {
+		writer.putRice(residual, parameter.get());
+		parameter.update(residual);
+	}
+	writer.flush();
+
+	// The template follows the pulses moved back by their shift, so that it
+	// is not smeared by the jitter. The shift is taken from the mean shift,
+	// otherwise the template would wander in time. The keyframes carry it.
+	// Waveforms with no pulse have no time to align with.
+	int32_t nSamples = samples.size();
+	bool hasPulse = amplitude > amplitudeScale / 4;
+	if (hasPulse)
+		state.meanShift += averageWeight * (bestShift - state.meanShift);
+	for (int32_t iSample = 0; hasPulse && iSample < nSamples; iSample++) {
+		double position = iSample + (bestShift - state.meanShift) / shiftSteps;
+		int32_t base = int32_t(floor(position));
+		double fraction = position - base;
+		double aligned = (1. - fraction) * signal[min(max(base, 0), nSamples - 1)]
+				+ fraction * signal[min(max(base + 1, 0), nSamples - 1)];
+		state.average[iSample] += averageWeight * (aligned - state.average[iSample]);
+	}
+	state.nSinceKeyframe++;
+
+	dest.clear();
+	dest.push_back(isKeyframe ? keyframeRecord : predictedRecord);
+	putVarint(dest, payload.size());
+	dest.insert(dest.end(), payload.begin(), payload.end());
+}
+
+PredictiveWaveformDecoder::Status PredictiveWaveformDecoder::decode(
+		const char*& current, const char* end, unsigned& channel,
+		vector<uint16_t>& samples) {
+	if (current >= end)
+		return END;
+	char type = *current++;
+	uint64_t length;
+	if ((type != keyframeRecord && type != predictedRecord)
+			|| !getVarint(current, end, length) || uint64_t(end - current) < length)
+		return CORRUPT;
+	const char* recordEnd = current + length;
+	const char* position = current;
+	current = recordEnd;
+
+	uint64_t channelNumber;
+	if (!getVarint(position, recordEnd, channelNumber) || position >= recordEnd)
+		return CORRUPT;
+	channel = unsigned(channelNumber);
+	uint8_t generation = uint8_t(*position++);
+	ChannelState& state = channels[channel];
+
+	const Keyframe* keyframe = nullptr;
+	if (type == keyframeRecord) {
+		Keyframe newKeyframe;
+		newKeyframe.generation = generation;
+		// Every value of the template takes at least one byte
+		uint64_t nSamples;
+		if (!getVarint(position, recordEnd, nSamples) || recordEnd - position < 2
+				|| nSamples == 0 || nSamples > maxSamples
+				|| nSamples > uint64_t(recordEnd - position - 2))
+			return CORRUPT;
+		newKeyframe.pedestal = uint8_t(position[0]) | (uint8_t(position[1]) << 8);
+		position += 2;
+		newKeyframe.shape.resize(nSamples);
+		int32_t previous = 0;
+		for (auto& value : newKeyframe.shape) {
+			int32_t delta;
+			if (!getSigned(position, recordEnd, delta))
+				return CORRUPT;
+			value = previous + delta;
+			previous = value;
+		}
+		if (state.hasCurrent) {
+			swap(state.previous, state.current);
+			state.hasPrevious = true;
+		}
+		prepareShifts(newKeyframe);
+		state.current = move(newKeyframe);
+		state.hasCurrent = true;
+		keyframe = &state.current;
+	} else if (state.hasCurrent && state.current.generation == generation) {
+		keyframe = &state.current;
+	} else if (state.hasPrevious && state.previous.generation == generation) {
+		keyframe = &state.previous;
+	} else {
+		return SKIPPED;
+	}
+
+	int32_t pedestalOffset, shift, amplitude;
+	if (!getSigned(position, recordEnd, pedestalOffset)
+			|| !getSigned(position, recordEnd, shift)
+			|| !getSigned(position, recordEnd, amplitude) || position >= recordEnd
+			|| shift < -maxShift || shift > maxShift)
+		return CORRUPT;
+	const int32_t* shifted = getShifted(*keyframe, shift);
+	int32_t pedestal = keyframe->pedestal + pedestalOffset;
+	unsigned k = uint8_t(*position++);
+	RiceCoding::BitReader reader(position, recordEnd);
+	AdaptiveParameter parameter(k);
+	samples.resize(keyframe->shape.size());
+	for (unsigned iSample = 0; iSample < samples.size(); iSample++) {
+		uint32_t residual;
+		if (!reader.getRice(parameter.get(), residual))
+			return CORRUPT;
+		parameter.update(residual);
+		samples[iSample] = uint16_t(predict(shifted, pedestal, amplitude, iSample)
+				+ RiceCoding::unzigzag(residual));
+	}
+	return DECODED;
+}
+
+namespace {
+
+// The TAC waveforms through the registry, all as channel 0
+class PredictiveCodec: public WaveformCodec {
+protected:
+	mutable PredictiveWaveformEncoder encoder;
+
+public:
+	PredictiveCodec() :
+			WaveformCodec("predictive") {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		encoder.encode(0, samples, dest);
+	}
+};
+
+WaveformCodec::Registrar predictiveRegistrar("predictive", []() {return new PredictiveCodec();});
+
+}
@@ -0,0 +1,169 @@
+/*
+ * PredictiveWaveformCodec.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Lossless coding of the waveforms of a channel relative to the waveforms
+ *  before them. Every channel keeps a running average of its pedestal
+ *  subtracted waveforms. A keyframe record freezes it as the template and
+ *  carries it, and the following waveforms are coded as their pedestal
+ *  offset, a time shift and an amplitude relative to the template and the
+ *  Rice-coded residuals from the shifted and scaled template.
+ *
+ *  A keyframe is written for the first waveform of a channel, every
+ *  keyframeInterval waveforms and when the number of samples changes. Every
+ *  record starts with its type and length, so a decoder can start at any
+ *  record: it skips the waveforms of a channel until its next keyframe.
+ *
+ *  Record: type ('K' or 'P'), varint length of the rest, varint channel,
+ *  keyframe generation byte, for 'K' varint number of samples, 2-byte pedestal
+ *  and the template as zigzag differences in varints, then the zigzag
+ *  pedestal offset, shift (1/8 sample) and amplitude (1/256 of the template)
+ *  in varints, the Rice parameter byte and the Rice-coded zigzag residuals.
+ */
+
+#ifndef PREDICTIVEWAVEFORMCODEC_H_
+#define PREDICTIVEWAVEFORMCODEC_H_
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <stdint.h>
+
+namespace PredictiveWaveformFormat {
+
+const char keyframeRecord = 'K';
+const char predictedRecord = 'P';
+
+// Amplitudes are stored in 1/amplitudeScale of the template
+const int32_t amplitudeScale = 256;
+// Time shifts are in 1/shiftSteps of a sample, up to maxShift either way
+const int32_t shiftSteps = 8;
+const int32_t maxShift = 16;
+// Samples at the start of the window averaged for the pedestal
+const unsigned nPedestalSamples = 4;
+// Longest waveform that is coded, far more than the readout window of a fADC250
+const unsigned maxSamples = 4096;
+
+// Template of one keyframe generation of a channel
+struct Keyframe {
+	uint8_t generation = 0;
+	int32_t pedestal = 0;
+	std::vector<int32_t> shape;
+	// shiftSteps times the shape linearly interpolated at every shift,
+	// shift s at [(s + maxShift) * shape.size()]
+	std::vector<int32_t> shifted;
+};
+
+inline int32_t floorDivide(int64_t numerator, int64_t denominator) {
+	int64_t quotient = numerator / denominator;
+	if (numerator % denominator < 0)
+		quotient--;
+	return int32_t(quotient);
+}
+
+// Fill the shifted templates from the shape
+inline void prepareShifts(Keyframe& keyframe) {
+	int32_t nSamples = keyframe.shape.size();
+	keyframe.shifted.resize((2 * maxShift + 1) * nSamples);
+	for (int32_t shift = -maxShift; shift <= maxShift; shift++) {
+		int32_t* shifted = &keyframe.shifted[(shift + maxShift) * nSamples];
+		for (int32_t iSample = 0; iSample < nSamples; iSample++) {
+			// The template at iSample - shift / shiftSteps
+			int32_t position = iSample * shiftSteps - shift;
+			int32_t base = floorDivide(position, shiftSteps);
+			int32_t fraction = position - base * shiftSteps;
+			int32_t low = std::min(std::max(base, 0), nSamples - 1);
+			int32_t high = std::min(std::max(base + 1, 0), nSamples - 1);
+			shifted[iSample] = (shiftSteps - fraction) * keyframe.shape[low]
+					+ fraction * keyframe.shape[high];
+		}
+	}
+}
+
+inline const int32_t* getShifted(const Keyframe& keyframe, int32_t shift) {
+	return &keyframe.shifted[(shift + maxShift) * keyframe.shape.size()];
+}
+
+// Prediction of sample i of a waveform with that pedestal and amplitude from
+// the shifted template, in integers so that the encoder and the decoder agree
+inline int32_t predict(const int32_t* shifted, int32_t pedestal,
+		int32_t amplitude, unsigned i) {
+	const int64_t scale = int64_t(amplitudeScale) * shiftSteps;
+	return pedestal + floorDivide(int64_t(amplitude) * shifted[i] + scale / 2, scale);
+}
+
+}
+
+class PredictiveWaveformEncoder {
+protected:
+	struct ChannelState {
+		PredictiveWaveformFormat::Keyframe keyframe;
+		bool started = false;
+		// Waveforms coded since the last keyframe
+		unsigned nSinceKeyframe = 0;
+		// Running average of the pedestal-subtracted waveforms
+		std::vector<double> average;
+		// Running average of the shifts of the pulses
+		double meanShift = 0.;
+	};
+
+	unsigned keyframeInterval;
+	// Weight of a new waveform in the running average
+	double averageWeight;
+
+	std::map<unsigned, ChannelState> channels;
+	std::mutex encoderMutex;
+
+	void startKeyframe(ChannelState& state, const std::vector<uint16_t>& samples,
+			int32_t pedestal);
+
+public:
+	PredictiveWaveformEncoder(unsigned interval = 1000, double weight = 1. / 64.) :
+			keyframeInterval(interval < 1 ? 1 : interval), averageWeight(weight) {
+	}
+	virtual ~PredictiveWaveformEncoder() {
+	}
+
+	PredictiveWaveformEncoder(const PredictiveWaveformEncoder&) = delete;
+	PredictiveWaveformEncoder& operator=(const PredictiveWaveformEncoder&) = delete;
+
+	// Replace dest with the record of the waveform. Records of one channel
+	// have to be decoded in the order they were encoded, at least across
+	// keyframes: the decoder keeps the previous generation for records that
+	// were written late. An empty waveform or one longer than maxSamples is
+	// not coded, dest is left empty.
+	virtual void encode(unsigned channel, const std::vector<uint16_t>& samples,
+			std::vector<char>& dest);
+};
+
+class PredictiveWaveformDecoder {
+public:
+	enum Status {
+		DECODED, SKIPPED, END, CORRUPT
+	};
+
+protected:
+	struct ChannelState {
+		PredictiveWaveformFormat::Keyframe current;
+		PredictiveWaveformFormat::Keyframe previous;
+		bool hasCurrent = false;
+		bool hasPrevious = false;
+	};
+	std::map<unsigned, ChannelState> channels;
+
+public:
+	PredictiveWaveformDecoder() {
+	}
+	virtual ~PredictiveWaveformDecoder() {
+	}
+
+	// Decode the record at current and move past it. SKIPPED for a waveform
+	// of a channel with no keyframe yet, END at the end of the data.
+	virtual Status decode(const char*& current, const char* end,
+			unsigned& channel, std::vector<uint16_t>& samples);
+};
+
+#endif /* PREDICTIVEWAVEFORMCODEC_H_ */
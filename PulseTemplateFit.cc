@@ -0,0 +1,153 @@
+/*
+ * PulseTemplateFit.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "PulseTemplateFit.h"
+
+using namespace std;
+
+// Shift steps per sample
+const unsigned PulseTemplateFit::nSteps;
+const unsigned PulseTemplateFit::maxWindow;
+// Fit window in samples before and after the highest sample
+int PulseTemplateFit::samplesBefore = 6;
+int PulseTemplateFit::samplesAfter = 14;
+
+double PulseTemplateFit::templateValue(const Template& pulseTemplate, int j,
+		unsigned iShift) {
+	// The shift goes from -1 to +1 sample, the template is evaluated at j - shift
+	return pulseTemplate.fineShape[pulseTemplate.finePeak + j * int(nSteps)
+			+ int(nSteps) - int(iShift)];
+}
+
+bool PulseTemplateFit::update(const vector<double>& averageWaveform) {
+	int nSamples = averageWaveform.size();
+	if (nSamples < samplesBefore + samplesAfter + 1)
+		return false;
+	int peakSample = distance(averageWaveform.begin(),
+			max_element(averageWaveform.begin(), averageWaveform.end()));
+	// The pedestal is taken well before the pulse
+	int pedestalEnd = max(1, peakSample - samplesBefore - 2);
+	double pedestal = 0;
+	for (int iSample = 0; iSample < pedestalEnd; iSample++)
+		pedestal += averageWaveform[iSample];
+	pedestal /= pedestalEnd;
+	double height = averageWaveform[peakSample] - pedestal;
+	if (height < 5.0)
+		return false;
+
+	shared_ptr<Template> pulseTemplate = make_shared<Template>();
+	int fineSize = (samplesBefore + samplesAfter + 2) * nSteps + 1;
+	pulseTemplate->finePeak = (samplesBefore + 1) * nSteps;
+	pulseTemplate->fineShape.resize(fineSize);
+	for (int iFine = 0; iFine < fineSize; iFine++) {
+		// Linear interpolation of the normalized average, constant past the ends
+		double position = peakSample
+				+ double(iFine - pulseTemplate->finePeak) / nSteps;
+		position = min(max(position, 0.0), double(nSamples - 1));
+		int lowSample = min(int(position), nSamples - 2);
+		double fraction = position - lowSample;
+		double value = (1.0 - fraction) * averageWaveform[lowSample]
+				+ fraction * averageWaveform[lowSample + 1];
+		pulseTemplate->fineShape[iFine] = (value - pedestal) / height;
+	}
+
+	unsigned nShifts = 2 * nSteps + 1;
+	pulseTemplate->shapes.resize(nShifts);
+	pulseTemplate->sumT.assign(nShifts, 0);
+	pulseTemplate->sumTT.assign(nShifts, 0);
+	for (unsigned iShift = 0; iShift < nShifts; iShift++) {
+		auto& shape = pulseTemplate->shapes[iShift];
+		for (int j = -samplesBefore; j <= samplesAfter; j++) {
+			double value = templateValue(*pulseTemplate, j, iShift);
+			shape.push_back(value);
+			pulseTemplate->sumT[iShift] += value;
+			pulseTemplate->sumTT[iShift] += value * value;
+		}
+	}
+	atomic_store(&currentTemplate,
+			shared_ptr<const Template>(std::move(pulseTemplate)));
+	return true;
+}
+
+bool PulseTemplateFit::fit(const vector<uint16_t>& samples, Result& result) const {
+	shared_ptr<const Template> pulseTemplate = atomic_load(&currentTemplate);
+	if (!pulseTemplate || samples.empty())
+		return false;
+	int nSamples = samples.size();
+	int peakSample = distance(samples.begin(),
+			max_element(samples.begin(), samples.end()));
+	int jFirst = max(-samplesBefore, -peakSample);
+	int jLast = min(samplesAfter, nSamples - 1 - peakSample);
+	int nPoints = jLast - jFirst + 1;
+	if (nPoints < 3 || nPoints > int(maxWindow))
+		return false;
+	bool fullWindow = (jFirst == -samplesBefore && jLast == samplesAfter);
+
+	// Window converted once, every shift reuses it
+	double window[maxWindow];
+	double* y = window - jFirst;
+	double sumY = 0, sumYY = 0;
+	for (int j = jFirst; j <= jLast; j++) {
+		y[j] = samples[peakSample + j];
+		sumY += y[j];
+		sumYY += y[j] * y[j];
+	}
+
+	// Solve for amplitude and pedestal at every shift
+	const unsigned nShifts = 2 * nSteps + 1;
+	double chi2[nShifts], amplitude[nShifts], pedestal[nShifts];
+	unsigned bestShift = 0;
+	for (unsigned iShift = 0; iShift < nShifts; iShift++) {
+		const double* shape = pulseTemplate->shapes[iShift].data() + samplesBefore;
+		double sumYT = 0, sumT, sumTT;
+		if (fullWindow) {
+			for (int j = jFirst; j <= jLast; j++)
+				sumYT += y[j] * shape[j];
+			sumT = pulseTemplate->sumT[iShift];
+			sumTT = pulseTemplate->sumTT[iShift];
+		} else {
+			sumT = 0;
+			sumTT = 0;
+			for (int j = jFirst; j <= jLast; j++) {
+				sumYT += y[j] * shape[j];
+				sumT += shape[j];
+				sumTT += shape[j] * shape[j];
+			}
+		}
+		double determinant = nPoints * sumTT - sumT * sumT;
+		if (determinant <= 0) {
+			chi2[iShift] = HUGE_VAL;
+			amplitude[iShift] = 0;
+			pedestal[iShift] = 0;
+			continue;
+		}
+		amplitude[iShift] = (nPoints * sumYT - sumT * sumY) / determinant;
+		pedestal[iShift] = (sumY - amplitude[iShift] * sumT) / nPoints;
+		chi2[iShift] = sumYY - amplitude[iShift] * sumYT - pedestal[iShift] * sumY;
+		if (chi2[iShift] < chi2[bestShift])
+			bestShift = iShift;
+	}
+	if (std::isinf(chi2[bestShift]))
+		return false;
+
+	// Parabola through the chi2 of the neighbouring shifts
+	double stepOffset = 0;
+	if (bestShift > 0 && bestShift + 1 < nShifts) {
+		double curvature = chi2[bestShift - 1] - 2 * chi2[bestShift]
+				+ chi2[bestShift + 1];
+		if (curvature > 0)
+			stepOffset = 0.5 * (chi2[bestShift - 1] - chi2[bestShift + 1]) / curvature;
+	}
+	result.amplitude = amplitude[bestShift];
+	result.pedestal = pedestal[bestShift];
+	result.chi2 = chi2[bestShift];
+	result.time = peakSample - 1.0 + (bestShift + stepOffset) / nSteps;
+	return true;
+}
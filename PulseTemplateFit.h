@@ -0,0 +1,87 @@
+/*
+ * PulseTemplateFit.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Fast fit of the TAC waveform with the average pulse shape. The template is
+ *  made from the accumulated average waveform (TACFADCRAW_AVG): the pedestal
+ *  is subtracted and the peak is normalized to 1. Copies of the template
+ *  shifted by fractions of a sample are precomputed over a window around the
+ *  peak together with their sums. A waveform is fitted as
+ *
+ *     sample[i] = amplitude * template(i - time) + pedestal
+ *
+ *  by solving the 2x2 linear least squares problem for every shift within one
+ *  sample of the highest sample, picking the shift with the lowest chi2 and
+ *  refining it with a parabola through the neighbouring chi2 values.
+ *
+ *  The template is replaced atomically, so fits in the event threads and
+ *  template updates do not need a lock.
+ */
+
+#ifndef PULSETEMPLATEFIT_H_
+#define PULSETEMPLATEFIT_H_
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <stdint.h>
+
+class PulseTemplateFit {
+public:
+	struct Result {
+		// Peak height above the pedestal
+		double amplitude = 0;
+		// Peak position in samples
+		double time = 0;
+		double pedestal = 0;
+		double chi2 = 0;
+	};
+
+protected:
+	struct Template {
+		// Shifted copies, shapes[iShift][j] for j = -samplesBefore .. samplesAfter
+		std::vector<std::vector<double> > shapes;
+		// Sums of every shifted copy over the full window
+		std::vector<double> sumT;
+		std::vector<double> sumTT;
+		// Template sampled finely, used when the window has to be cut at the edges
+		std::vector<double> fineShape;
+		// Index of the template peak in fineShape
+		int finePeak = 0;
+	};
+
+	// Shift steps per sample
+	static const unsigned nSteps = 8;
+	// Longest fit window in samples
+	static const unsigned maxWindow = 64;
+	// Fit window around the highest sample
+	static int samplesBefore;
+	static int samplesAfter;
+
+	std::shared_ptr<const Template> currentTemplate;
+
+	// Shifted template value at offset j from the highest sample for a shift
+	// of iShift steps from -1 sample
+	static double templateValue(const Template& pulseTemplate, int j, unsigned iShift);
+
+public:
+	PulseTemplateFit() {
+	}
+	virtual ~PulseTemplateFit() {
+	}
+
+	// Make a new template from the average waveform. Returns false and keeps
+	// the old template if the average has no clear pulse.
+	virtual bool update(const std::vector<double>& averageWaveform);
+
+	// Fit the waveform, false if there is no template yet
+	virtual bool fit(const std::vector<uint16_t>& samples, Result& result) const;
+
+	bool hasTemplate() const {
+		return std::atomic_load(&currentTemplate) != nullptr;
+	}
+};
+
+#endif /* PULSETEMPLATEFIT_H_ */
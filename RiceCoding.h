@@ -0,0 +1,138 @@
+/*
+ * RiceCoding.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Golomb-Rice coding of small unsigned values, used by the waveform codecs
+ *  for zigzag differences and residuals. A value v with parameter k is the
+ *  quotient v >> k in unary (ones closed by a zero) followed by the k low
+ *  bits. Quotients of maxUnary and more are an escape of maxUnary ones
+ *  followed by the value in 32 bits. Bits are filled from the lowest bit of
+ *  each byte.
+ */
+
+#ifndef RICECODING_H_
+#define RICECODING_H_
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace RiceCoding {
+
+const unsigned maxUnary = 24;
+
+inline uint32_t zigzag(int32_t value) {
+	return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value) {
+	return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+// Parameter for values with that mean, optimal for a geometric distribution
+inline unsigned getParameter(uint64_t sum, size_t nValues) {
+	uint64_t mean = nValues == 0 ? 0 : sum / nValues;
+	unsigned k = 0;
+	while (k < 15 && (uint64_t(1) << (k + 1)) <= mean)
+		k++;
+	return k;
+}
+
+class BitWriter {
+protected:
+	std::vector<char>& dest;
+	uint64_t buffer = 0;
+	unsigned nBits = 0;
+
+public:
+	BitWriter(std::vector<char>& out) :
+			dest(out) {
+	}
+
+	void put(uint32_t value, unsigned length) {
+		buffer |= uint64_t(value) << nBits;
+		nBits += length;
+		while (nBits >= 8) {
+			dest.push_back(char(buffer & 0xFF));
+			buffer >>= 8;
+			nBits -= 8;
+		}
+	}
+
+	void putRice(uint32_t value, unsigned k) {
+		uint32_t quotient = value >> k;
+		if (quotient >= maxUnary) {
+			put((1u << maxUnary) - 1, maxUnary);
+			put(value, 32);
+			return;
+		}
+		put((1u << quotient) - 1, quotient + 1);
+		if (k > 0)
+			put(value & ((1u << k) - 1), k);
+	}
+
+	// Write the last partial byte
+	void flush() {
+		if (nBits > 0)
+			dest.push_back(char(buffer & 0xFF));
+		buffer = 0;
+		nBits = 0;
+	}
+};
+
+class BitReader {
+protected:
+	const char* current;
+	const char* end;
+	uint64_t buffer = 0;
+	unsigned nBits = 0;
+
+	bool fill(unsigned length) {
+		while (nBits < length) {
+			if (current >= end)
+				return false;
+			buffer |= uint64_t(uint8_t(*current++)) << nBits;
+			nBits += 8;
+		}
+		return true;
+	}
+
+public:
+	BitReader(const char* begin, const char* stop) :
+			current(begin), end(stop) {
+	}
+
+	bool get(unsigned length, uint32_t& value) {
+		if (!fill(length))
+			return false;
+		value = length == 32 ? uint32_t(buffer) : uint32_t(buffer & ((uint64_t(1) << length) - 1));
+		buffer >>= length;
+		nBits -= length;
+		return true;
+	}
+
+	bool getRice(unsigned k, uint32_t& value) {
+		uint32_t quotient = 0;
+		uint32_t bit;
+		while (quotient < maxUnary) {
+			if (!get(1, bit))
+				return false;
+			if (bit == 0)
+				break;
+			quotient++;
+		}
+		if (quotient == maxUnary)
+			return get(32, value);
+		uint32_t remainder = 0;
+		if (k > 0 && !get(k, remainder))
+			return false;
+		value = (quotient << k) | remainder;
+		return true;
+	}
+};
+
+}
+
+#endif /* RICECODING_H_ */
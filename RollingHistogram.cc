@@ -0,0 +1,109 @@
+/*
+ * RollingHistogram.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <chrono>
+#include <algorithm>
+
+#include "RollingHistogram.h"
+
+using namespace std;
+
+const unsigned RollingHistogram::maxSlices;
+const unsigned RollingHistogram::nSlots;
+// Length of a time slice in seconds
+unsigned RollingHistogram::sliceSeconds = 10;
+
+RollingHistogram::RollingHistogram(unsigned nBinsX, double xLow, double xHigh) :
+		nBins(nBinsX), low(xLow), high(xHigh), binsPerUnit(nBinsX / (xHigh - xLow)),
+		bins(new atomic<uint32_t>[nSlots * (nBinsX + 2)]) {
+	for (unsigned iCell = 0; iCell < nSlots * (nBins + 2); iCell++)
+		bins[iCell].store(0, memory_order_relaxed);
+	for (unsigned slot = 0; slot < nSlots; slot++)
+		slotSlices[slot].store(-1, memory_order_relaxed);
+	int64_t slice = getSliceNow();
+	clearSlot(slice % nSlots, slice);
+	clearSlot((slice + 1) % nSlots, slice + 1);
+	currentSlice.store(slice, memory_order_release);
+}
+
+int64_t RollingHistogram::getSliceNow() {
+	auto now = chrono::steady_clock::now().time_since_epoch();
+	return chrono::duration_cast<chrono::seconds>(now).count() / sliceSeconds;
+}
+
+void RollingHistogram::clearSlot(unsigned slot, int64_t slice) {
+	atomic<uint32_t>* cells = bins.get() + size_t(slot) * (nBins + 2);
+	for (unsigned iBin = 0; iBin < nBins + 2; iBin++)
+		cells[iBin].store(0, memory_order_relaxed);
+	slotSlices[slot].store(slice, memory_order_release);
+}
+
+void RollingHistogram::advance(int64_t slice) {
+	int64_t current = currentSlice.load(memory_order_acquire);
+	while (slice > current) {
+		if (!currentSlice.compare_exchange_weak(current, slice))
+			continue;
+		// Normally the slot of the new slice was cleared when the previous one
+		// started. After a pause with no fills the skipped slots are cleared too.
+		int64_t first = max(current + 1, slice - int64_t(maxSlices) + 1);
+		for (int64_t skipped = first; skipped <= slice; skipped++) {
+			unsigned slot = skipped % nSlots;
+			if (slotSlices[slot].load(memory_order_acquire) != skipped)
+				clearSlot(slot, skipped);
+		}
+		// The oldest slot is cleared ahead for the next slice
+		clearSlot((slice + 1) % nSlots, slice + 1);
+		return;
+	}
+}
+
+void RollingHistogram::fill(double value, int64_t slice) {
+	if (slice > currentSlice.load(memory_order_acquire))
+		advance(slice);
+	unsigned slot = slice % nSlots;
+	// Too old, or a slot another thread is still clearing
+	if (slotSlices[slot].load(memory_order_acquire) != slice)
+		return;
+	unsigned bin;
+	if (value < low)
+		bin = 0;
+	else if (value >= high)
+		bin = nBins + 1;
+	else
+		bin = min<unsigned>(unsigned((value - low) * binsPerUnit), nBins - 1) + 1;
+	bins[size_t(slot) * (nBins + 2) + bin].fetch_add(1, memory_order_relaxed);
+}
+
+uint64_t RollingHistogram::addWindow(double* histogramBins, unsigned nSlices) const {
+	int64_t now = getSliceNow();
+	uint64_t nEntries = 0;
+	for (unsigned iSlice = 0; iSlice < min(nSlices, maxSlices); iSlice++) {
+		int64_t slice = now - iSlice;
+		unsigned slot = slice % nSlots;
+		if (slotSlices[slot].load(memory_order_acquire) != slice)
+			continue;
+		const atomic<uint32_t>* cells = bins.get() + size_t(slot) * (nBins + 2);
+		for (unsigned iBin = 0; iBin < nBins + 2; iBin++) {
+			uint32_t count = cells[iBin].load(memory_order_relaxed);
+			histogramBins[iBin] += count;
+			nEntries += count;
+		}
+	}
+	return nEntries;
+}
+
+uint64_t RollingHistogram::getSliceEntries(unsigned iSlice) const {
+	int64_t slice = getSliceNow() - iSlice;
+	unsigned slot = slice % nSlots;
+	if (iSlice >= maxSlices || slotSlices[slot].load(memory_order_acquire) != slice)
+		return 0;
+	const atomic<uint32_t>* cells = bins.get() + size_t(slot) * (nBins + 2);
+	uint64_t nEntries = 0;
+	for (unsigned iBin = 0; iBin < nBins + 2; iBin++)
+		nEntries += cells[iBin].load(memory_order_relaxed);
+	return nEntries;
+}
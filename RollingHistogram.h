@@ -0,0 +1,79 @@
+/*
+ * RollingHistogram.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  1D histogram of the recent past, kept as a ring of time slices. Every
+ *  slice covers sliceSeconds of wall time and has atomic bins, so it is
+ *  filled without a lock. When a new slice starts, the ring moves on by one
+ *  and the slot after it, the oldest one, is cleared for the next slice. A
+ *  fill therefore never waits for a clear and the full-run histograms are
+ *  never rescanned: the view of the last N slices is the sum of N slots.
+ */
+
+#ifndef ROLLINGHISTOGRAM_H_
+#define ROLLINGHISTOGRAM_H_
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+class RollingHistogram {
+public:
+	// Number of slices that can be looked at
+	static const unsigned maxSlices = 60;
+
+protected:
+	unsigned nBins;
+	double low;
+	double high;
+	double binsPerUnit;
+
+	// One more slot than maxSlices, the extra one is cleared ahead of use
+	static const unsigned nSlots = maxSlices + 1;
+	// Cells of slot s are bins[s * (nBins + 2) .. ], underflow and overflow included
+	std::unique_ptr<std::atomic<uint32_t>[]> bins;
+	// Slice number each slot holds, -1 for an empty slot
+	std::atomic<int64_t> slotSlices[nSlots];
+	// Latest slice filled
+	std::atomic<int64_t> currentSlice;
+
+	// Length of a slice in seconds, the same for all histograms
+	static unsigned sliceSeconds;
+
+	// Make the slot of the slice current, clearing what it held before
+	void clearSlot(unsigned slot, int64_t slice);
+	// Move the ring on to the slice, called by the first thread that sees it
+	void advance(int64_t slice);
+
+public:
+	RollingHistogram(unsigned nBinsX, double xLow, double xHigh);
+	virtual ~RollingHistogram() {
+	}
+
+	RollingHistogram(const RollingHistogram&) = delete;
+	RollingHistogram& operator=(const RollingHistogram&) = delete;
+
+	// Slice number of the current time
+	static int64_t getSliceNow();
+
+	void fill(double value, int64_t slice = getSliceNow());
+
+	// Sum of the last nSlices slices including the current one, added to the
+	// bin array of a histogram with the same binning. Returns the entries.
+	uint64_t addWindow(double* histogramBins, unsigned nSlices) const;
+
+	// Entries of the slice that started iSlice slices before the current one
+	uint64_t getSliceEntries(unsigned iSlice) const;
+
+	static unsigned getSliceSeconds() {
+		return sliceSeconds;
+	}
+
+	static void setSliceSeconds(unsigned seconds) {
+		sliceSeconds = seconds < 1 ? 1 : seconds;
+	}
+};
+
+#endif /* ROLLINGHISTOGRAM_H_ */
@@ -0,0 +1,52 @@
+/*
+ * TACEventArena.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include "TACEventArena.h"
+
+using namespace std;
+
+// Events reset by all threads
+atomic<uint64_t> TACEventArena::nEvents(0);
+// Events in which a container of an arena allocated
+atomic<uint64_t> TACEventArena::nAllocatingEvents(0);
+
+static thread_local TACEventArena threadArena;
+
+TACEventArena& TACEventArena::getThreadArena() {
+	return threadArena;
+}
+
+size_t TACEventArena::getCapacity() const {
+	return eventData.samples.capacity() * sizeof(uint16_t)
+			+ eventData.pulses.capacity() * sizeof(TACEventData::Pulse)
+			+ eventData.tdcTimes.capacity() * sizeof(double)
+			+ (eventData.taghHits.capacity() + eventData.tagmHits.capacity())
+					* sizeof(TACEventData::TaggerHit)
+			+ (tacRebuildHits.capacity() + rawData.capacity()
+					+ tacDigiHits.capacity() + tacTDCDigiHits.capacity()
+					+ taghDigiHits.capacity() + tagmDigiHits.capacity()
+					+ checkedObjects.capacity() + ancestorLevel.capacity()
+					+ nextLevel.capacity() + associatedObjects.capacity())
+					* sizeof(void*);
+}
+
+void TACEventArena::reset() {
+	size_t newCapacity = getCapacity();
+	if (newCapacity > capacity) {
+		nAllocatingEvents.fetch_add(1, memory_order_relaxed);
+		capacity = newCapacity;
+	}
+	nEvents.fetch_add(1, memory_order_relaxed);
+
+	eventData.clear();
+	tacRebuildHits.clear();
+	rawData.clear();
+	tacDigiHits.clear();
+	tacTDCDigiHits.clear();
+	taghDigiHits.clear();
+	tagmDigiHits.clear();
+}
@@ -0,0 +1,113 @@
+/*
+ * TACEventArena.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Per-thread storage of the temporaries evnt() needs for an event: the
+ *  TACEventData and the vectors the JANA objects are collected in. The
+ *  containers are cleared with reset() at the end of every event and keep
+ *  their memory, so once they have grown to the largest event a thread has
+ *  seen nothing is allocated for them any more. The ancestors of the TAC hit
+ *  are searched in vectors of the arena too (findAncestors()), the std::set
+ *  arguments of JObject::GetAssociatedAncestors() would allocate a node for
+ *  every object in every event.
+ *
+ *  reset() counts the events in which any container of an arena allocated.
+ *  A vector only allocates when its capacity grows, clear() keeps the
+ *  capacity and swap() only exchanges it, so the containers allocated in an
+ *  event if and only if their total capacity grew. The count stays at zero in
+ *  the steady state.
+ */
+
+#ifndef TACEVENTARENA_H_
+#define TACEVENTARENA_H_
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
+
+#include <JANA/JObject.h>
+
+#include "TACEventData.h"
+
+class DTACHit;
+class DTACDigiHit;
+class DTACTDCDigiHit;
+class DTAGHDigiHit;
+class DTAGMDigiHit;
+class Df250WindowRawData;
+
+struct TACEventArena {
+	TACEventData eventData;
+
+	std::vector<const DTACHit*> tacRebuildHits;
+	std::vector<const Df250WindowRawData*> rawData;
+	std::vector<const DTACDigiHit*> tacDigiHits;
+	std::vector<const DTACTDCDigiHit*> tacTDCDigiHits;
+	std::vector<const DTAGHDigiHit*> taghDigiHits;
+	std::vector<const DTAGMDigiHit*> tagmDigiHits;
+
+	// Objects of type T among the ancestors of object up to maxDepth levels
+	// up, each once, like JObject::GetAssociatedAncestors()
+	template<typename T>
+	void findAncestors(const jana::JObject* object, int maxDepth,
+			std::vector<const T*>& found) {
+		checkedObjects.clear();
+		ancestorLevel.assign(1, object);
+		for (int depth = 0; depth < maxDepth && !ancestorLevel.empty(); depth++) {
+			nextLevel.clear();
+			for (auto levelObject : ancestorLevel) {
+				associatedObjects.clear();
+				levelObject->GetT(associatedObjects);
+				for (auto associated : associatedObjects) {
+					// Kept sorted, an object reached on two paths is taken once
+					auto checkedIter = std::lower_bound(checkedObjects.begin(),
+							checkedObjects.end(), associated);
+					if (checkedIter != checkedObjects.end() && *checkedIter == associated)
+						continue;
+					checkedObjects.insert(checkedIter, associated);
+					nextLevel.push_back(associated);
+					const T* ancestor = dynamic_cast<const T*>(associated);
+					if (ancestor != nullptr)
+						found.push_back(ancestor);
+				}
+			}
+			// Exchanges the memory of the two levels, nothing is allocated
+			ancestorLevel.swap(nextLevel);
+		}
+	}
+
+	// Clear everything for the next event and count it
+	void reset();
+
+	// Arena of the calling thread
+	static TACEventArena& getThreadArena();
+
+	// Events reset by all threads and the number of them an arena allocated in
+	static uint64_t getNumberOfEvents() {
+		return nEvents.load(std::memory_order_relaxed);
+	}
+	static uint64_t getNumberOfAllocatingEvents() {
+		return nAllocatingEvents.load(std::memory_order_relaxed);
+	}
+
+protected:
+	// Scratch space of findAncestors()
+	std::vector<const jana::JObject*> checkedObjects;
+	std::vector<const jana::JObject*> ancestorLevel;
+	std::vector<const jana::JObject*> nextLevel;
+	std::vector<const jana::JObject*> associatedObjects;
+
+	// Bytes held by all containers after the previous event
+	size_t capacity = 0;
+
+	size_t getCapacity() const;
+
+	static std::atomic<uint64_t> nEvents;
+	static std::atomic<uint64_t> nAllocatingEvents;
+};
+
+#endif /* TACEVENTARENA_H_ */
@@ -0,0 +1,83 @@
+/*
+ * TACEventData.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Everything the TAC monitor uses from an event, copied out of the JANA
+ *  objects by JEventProcessor_TAC_Monitor::collectEventData(). The histograms
+ *  are filled from this structure only, which lets the benchmark tools drive
+ *  the monitor with generated events.
+ */
+
+#ifndef TACEVENTDATA_H_
+#define TACEVENTDATA_H_
+
+#include <vector>
+#include <stdint.h>
+
+struct TACEventData {
+	// Pulse found by the FADC250 firmware (DTACDigiHit)
+	struct Pulse {
+		double peak;
+		// Pulse time in ns
+		double time;
+		double integral;
+	};
+
+	// Tagger hit, counter_id for TAGH and column for TAGM
+	struct TaggerHit {
+		unsigned counter;
+		// Pulse time in ns
+		double time;
+	};
+
+	int32_t runNumber = 0;
+	uint64_t eventNumber = 0;
+	uint32_t triggerMask = 0;
+
+	// Number of TAC waveforms associated with the rebuilt TAC hit
+	unsigned nWaveforms = 0;
+	// Samples of the TAC waveform, only set if there is exactly one waveform
+	std::vector<uint16_t> samples;
+
+	// Firmware pulses of the TAC
+	std::vector<Pulse> pulses;
+
+	// Number of TAC TDC digi hits and the times of those with a CAEN TDC hit in ns
+	unsigned nTDCHits = 0;
+	std::vector<double> tdcTimes;
+
+	std::vector<TaggerHit> taghHits;
+	std::vector<TaggerHit> tagmHits;
+
+	// Clear the event but keep the allocated memory
+	void clear() {
+		runNumber = 0;
+		eventNumber = 0;
+		triggerMask = 0;
+		nWaveforms = 0;
+		samples.clear();
+		pulses.clear();
+		nTDCHits = 0;
+		tdcTimes.clear();
+		taghHits.clear();
+		tagmHits.clear();
+	}
+};
+
+// Quantities the monitor derives from the event data
+struct TACEventSummary {
+	// Maximum sample and the sample where the threshold is crossed
+	unsigned wavePeak = 0;
+	unsigned waveTime = 0;
+	// Largest firmware pulse and the largest integral
+	double pulsePeak = 0;
+	double pulseTime = 0;
+	double pulseIntegral = 0;
+	// WaveformAnomalyDetector flags and chi2 per sample of the waveform
+	uint32_t anomalyFlags = 0;
+	double shapeChi2 = 0;
+};
+
+#endif /* TACEVENTDATA_H_ */
@@ -0,0 +1,442 @@
+/*
+ * TACFeatureFormat.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Format of the per-event TAC feature files (tac_features_<run>.bin) written
+ *  by TACFeatureWriter and read back by the tools. The file is a FileHeader
+ *  followed by independent blocks of events:
+ *
+ *     BlockHeader | ColumnHeader for every column | column data
+ *
+ *  Inside a block every quantity is stored as one column. Variable length
+ *  quantities (samples, TDC times, tagger hits) have a count column with one
+ *  value per event and a value column with all values of the block.
+ *  Integer columns are varints, optionally as zigzag deltas from the previous
+ *  value. Double columns are XORed with the previous value and only the
+ *  non-zero bytes are kept, which is lossless.
+ */
+
+#ifndef TACFEATUREFORMAT_H_
+#define TACFEATUREFORMAT_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace TACFeatureFormat {
+
+static const char fileMagic[8] = { 'T', 'A', 'C', 'F', 'E', 'A', 'T', '\0' };
+static const uint32_t fileVersion = 1;
+static const uint32_t blockMagic = 0x42434154; // "TACB"
+
+enum ColumnId : uint8_t {
+	EVENT_NUMBER,
+	TRIGGER_MASK,
+	// Number of waveforms, the maximum sample and the threshold crossing sample
+	N_WAVEFORMS,
+	WAVE_PEAK,
+	WAVE_TIME,
+	// Waveform samples, only stored for events with a single waveform
+	N_SAMPLES,
+	SAMPLES,
+	// Number of firmware pulses, the largest peak with its time and the largest integral
+	N_PULSES,
+	PULSE_PEAK,
+	PULSE_TIME,
+	PULSE_INTEGRAL,
+	// Number of TDC digi hits and the converted times
+	N_TDC_HITS,
+	N_TDC_TIMES,
+	TDC_TIMES,
+	// Tagger hits within the stored window
+	N_TAGH_HITS,
+	TAGH_COUNTER,
+	TAGH_TIME,
+	N_TAGM_HITS,
+	TAGM_COUNTER,
+	TAGM_TIME,
+	// Waveform anomaly flags and the chi2 per sample of the shape
+	ANOMALY_FLAGS,
+	SHAPE_CHI2,
+	NUMBER_OF_COLUMNS
+};
+
+enum Encoding : uint8_t {
+	ENC_VARINT = 0,
+	ENC_DELTA = 1,
+	ENC_XOR_DOUBLE = 2
+};
+
+// Encoding used for every column
+inline Encoding getColumnEncoding(unsigned columnId) {
+	switch (columnId) {
+	case EVENT_NUMBER:
+	case SAMPLES:
+		return ENC_DELTA;
+	case PULSE_PEAK:
+	case PULSE_TIME:
+	case PULSE_INTEGRAL:
+	case TDC_TIMES:
+	case TAGH_TIME:
+	case TAGM_TIME:
+	case SHAPE_CHI2:
+		return ENC_XOR_DOUBLE;
+	default:
+		return ENC_VARINT;
+	}
+}
+
+// Count column holding the number of values of every event for a value
+// column, NUMBER_OF_COLUMNS for the columns with one value per event
+inline unsigned getCountColumn(unsigned columnId) {
+	switch (columnId) {
+	case SAMPLES:
+		return N_SAMPLES;
+	case TDC_TIMES:
+		return N_TDC_TIMES;
+	case TAGH_COUNTER:
+	case TAGH_TIME:
+		return N_TAGH_HITS;
+	case TAGM_COUNTER:
+	case TAGM_TIME:
+		return N_TAGM_HITS;
+	default:
+		return NUMBER_OF_COLUMNS;
+	}
+}
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	// 1 if the waveform samples are stored
+	uint32_t hasSamples;
+	// Plugin settings the features were written with
+	double taghTimeCutValue;
+	double tagmTimeCutValue;
+	double timeCutWidth;
+	// Tagger hits are stored if they are within this distance from the cut
+	// value, 0 if all hits are stored
+	double taggerWindow;
+	uint32_t tacThreshold;
+	uint32_t reserved;
+	double fadc250RawTimeScale;
+};
+
+struct BlockHeader {
+	uint32_t magic;
+	int32_t runNumber;
+	uint32_t nEvents;
+	uint32_t nColumns;
+	// Size of the column headers and data that follow
+	uint64_t payloadSize;
+};
+
+struct ColumnHeader {
+	uint8_t id;
+	uint8_t encoding;
+	uint16_t reserved;
+	uint32_t nValues;
+	uint32_t size;
+};
+
+// One column of a block, integer columns use ints and double columns use reals
+struct Column {
+	std::vector<uint64_t> ints;
+	std::vector<double> reals;
+
+	void clear() {
+		ints.clear();
+		reals.clear();
+	}
+	size_t size() const {
+		return ints.size() + reals.size();
+	}
+};
+
+// Decoded block
+struct Block {
+	int32_t runNumber = 0;
+	uint32_t nEvents = 0;
+	Column columns[NUMBER_OF_COLUMNS];
+
+	void clear() {
+		runNumber = 0;
+		nEvents = 0;
+		for (auto& column : columns)
+			column.clear();
+	}
+};
+
+inline void putVarint(std::vector<char>& out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(char((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(char(value));
+}
+
+inline bool getVarint(const char*& current, const char* end, uint64_t& value) {
+	value = 0;
+	for (unsigned shift = 0; shift < 64 && current < end; shift += 7) {
+		uint8_t byte = uint8_t(*current++);
+		value |= uint64_t(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Append the encoded column to out
+inline void encodeColumn(unsigned columnId, const Column& column,
+		std::vector<char>& out) {
+	switch (getColumnEncoding(columnId)) {
+	case ENC_VARINT:
+		for (auto value : column.ints)
+			putVarint(out, value);
+		break;
+	case ENC_DELTA: {
+		uint64_t previous = 0;
+		for (auto value : column.ints) {
+			int64_t delta = int64_t(value - previous);
+			putVarint(out, (uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+			previous = value;
+		}
+		break;
+	}
+	case ENC_XOR_DOUBLE: {
+		// Control byte: number of zero bytes on top (high nibble) and the
+		// number of bytes kept (low nibble), then the kept bytes
+		uint64_t previous = 0;
+		for (auto value : column.reals) {
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			uint64_t diff = bits ^ previous;
+			previous = bits;
+			unsigned leading = 0, trailing = 0;
+			if (diff != 0) {
+				while ((diff >> (56 - 8 * leading)) == 0)
+					leading++;
+				while (((diff >> (8 * trailing)) & 0xFF) == 0)
+					trailing++;
+			} else {
+				leading = 8;
+			}
+			unsigned length = 8 - leading - trailing;
+			out.push_back(char((leading << 4) | length));
+			for (unsigned iByte = 0; iByte < length; iByte++)
+				out.push_back(char((diff >> (8 * (trailing + iByte))) & 0xFF));
+		}
+		break;
+	}
+	}
+}
+
+// Decode nValues values of the column, false if the data is corrupt
+inline bool decodeColumn(unsigned columnId, unsigned encoding, uint32_t nValues,
+		const char* data, uint32_t size, Column& column) {
+	const char* current = data;
+	const char* end = data + size;
+	column.clear();
+	// Every value takes at least one byte, whatever the encoding
+	if (nValues > size)
+		return false;
+	switch (encoding) {
+	case ENC_VARINT:
+	case ENC_DELTA: {
+		column.ints.resize(nValues);
+		uint64_t previous = 0;
+		for (uint32_t iValue = 0; iValue < nValues; iValue++) {
+			uint64_t value;
+			if (!getVarint(current, end, value))
+				return false;
+			if (encoding == ENC_DELTA) {
+				int64_t delta = int64_t(value >> 1) ^ -int64_t(value & 1);
+				value = previous + uint64_t(delta);
+				previous = value;
+			}
+			column.ints[iValue] = value;
+		}
+		break;
+	}
+	case ENC_XOR_DOUBLE: {
+		column.reals.resize(nValues);
+		uint64_t previous = 0;
+		for (uint32_t iValue = 0; iValue < nValues; iValue++) {
+			if (current >= end)
+				return false;
+			uint8_t control = uint8_t(*current++);
+			unsigned leading = control >> 4;
+			unsigned length = control & 0x0F;
+			if (leading + length > 8 || end - current < std::ptrdiff_t(length))
+				return false;
+			unsigned trailing = 8 - leading - length;
+			uint64_t diff = 0;
+			for (unsigned iByte = 0; iByte < length; iByte++)
+				diff |= uint64_t(uint8_t(*current++)) << (8 * (trailing + iByte));
+			previous ^= diff;
+			memcpy(&column.reals[iValue], &previous, sizeof(previous));
+		}
+		break;
+	}
+	default:
+		return false;
+	}
+	return current == end;
+}
+
+// Read-only view of a feature file through a memory mapping. The blocks can
+// be decoded independently, also from several threads.
+class FileReader {
+protected:
+	int fileDescriptor = -1;
+	const char* mappedData = nullptr;
+	size_t mappedSize = 0;
+	FileHeader header;
+	// Start of every block in the mapping
+	std::vector<const char*> blocks;
+	std::string errorMessage;
+
+	bool fail(const std::string& message) {
+		errorMessage = message;
+		close();
+		return false;
+	}
+
+public:
+	FileReader() {
+		memset(&header, 0, sizeof(header));
+	}
+	~FileReader() {
+		close();
+	}
+
+	FileReader(const FileReader&) = delete;
+	FileReader& operator=(const FileReader&) = delete;
+
+	// Map the file and find the blocks. A block cut short at the end of the
+	// file (a writer that crashed) is ignored.
+	bool open(const std::string& fileName) {
+		close();
+		fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+		if (fileDescriptor < 0)
+			return fail("cannot open " + fileName);
+		struct stat fileStat;
+		if (fstat(fileDescriptor, &fileStat) != 0
+				|| size_t(fileStat.st_size) < sizeof(FileHeader))
+			return fail(fileName + " is too short");
+		mappedSize = fileStat.st_size;
+		void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE,
+				fileDescriptor, 0);
+		if (mapping == MAP_FAILED) {
+			mappedSize = 0;
+			return fail("cannot map " + fileName);
+		}
+		mappedData = static_cast<const char*>(mapping);
+		madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+		memcpy(&header, mappedData, sizeof(header));
+		if (memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0
+				|| header.version != fileVersion)
+			return fail(fileName + " is not a TAC feature file");
+		size_t offset = sizeof(FileHeader);
+		while (offset + sizeof(BlockHeader) <= mappedSize) {
+			BlockHeader blockHeader;
+			memcpy(&blockHeader, mappedData + offset, sizeof(blockHeader));
+			if (blockHeader.magic != blockMagic
+					|| blockHeader.payloadSize > mappedSize - offset - sizeof(BlockHeader))
+				break;
+			blocks.push_back(mappedData + offset);
+			offset += sizeof(BlockHeader) + blockHeader.payloadSize;
+		}
+		return true;
+	}
+
+	void close() {
+		if (mappedData != nullptr)
+			munmap(const_cast<char*>(mappedData), mappedSize);
+		mappedData = nullptr;
+		mappedSize = 0;
+		if (fileDescriptor >= 0)
+			::close(fileDescriptor);
+		fileDescriptor = -1;
+		blocks.clear();
+	}
+
+	// Decode one block, false if it is corrupt. A column with one value per
+	// event has a value for every event, only N_SAMPLES may be missing when the
+	// samples are not stored. A value column has as many values as its count
+	// column adds up to.
+	bool decodeBlock(size_t iBlock, Block& block) const {
+		block.clear();
+		const char* blockStart = blocks.at(iBlock);
+		BlockHeader blockHeader;
+		memcpy(&blockHeader, blockStart, sizeof(blockHeader));
+		block.runNumber = blockHeader.runNumber;
+		block.nEvents = blockHeader.nEvents;
+		const char* payload = blockStart + sizeof(BlockHeader);
+		size_t directorySize = size_t(blockHeader.nColumns) * sizeof(ColumnHeader);
+		if (directorySize > blockHeader.payloadSize)
+			return false;
+		size_t dataOffset = directorySize;
+		for (uint32_t iColumn = 0; iColumn < blockHeader.nColumns; iColumn++) {
+			ColumnHeader columnHeader;
+			memcpy(&columnHeader, payload + iColumn * sizeof(ColumnHeader),
+					sizeof(columnHeader));
+			if (dataOffset + columnHeader.size > blockHeader.payloadSize)
+				return false;
+			// Columns unknown to this version are skipped
+			if (columnHeader.id < NUMBER_OF_COLUMNS
+					&& (columnHeader.encoding != getColumnEncoding(columnHeader.id)
+							|| !decodeColumn(columnHeader.id, columnHeader.encoding,
+									columnHeader.nValues, payload + dataOffset,
+									columnHeader.size, block.columns[columnHeader.id])))
+				return false;
+			dataOffset += columnHeader.size;
+		}
+		for (unsigned columnId = 0; columnId < NUMBER_OF_COLUMNS; columnId++) {
+			size_t nValues = block.columns[columnId].size();
+			unsigned countColumn = getCountColumn(columnId);
+			if (countColumn == NUMBER_OF_COLUMNS) {
+				if (nValues != block.nEvents && (nValues != 0 || columnId != N_SAMPLES))
+					return false;
+				continue;
+			}
+			uint64_t nCounted = 0;
+			for (auto count : block.columns[countColumn].ints) {
+				if (count > nValues - nCounted)
+					return false;
+				nCounted += count;
+			}
+			if (nCounted != nValues)
+				return false;
+		}
+		return true;
+	}
+
+	const FileHeader& getHeader() const {
+		return header;
+	}
+
+	size_t getNumberOfBlocks() const {
+		return blocks.size();
+	}
+
+	size_t getFileSize() const {
+		return mappedSize;
+	}
+
+	const std::string& getErrorMessage() const {
+		return errorMessage;
+	}
+};
+
+}
+
+#endif /* TACFEATUREFORMAT_H_ */
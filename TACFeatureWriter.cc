@@ -0,0 +1,173 @@
+/*
+ * TACFeatureWriter.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <cmath>
+#include <cstring>
+
+#include "TACFeatureWriter.h"
+
+using namespace std;
+using namespace TACFeatureFormat;
+
+TACFeatureWriter::TACFeatureWriter(const FileHeader& header,
+		unsigned nEventsInBlock) :
+		fileHeader(header), blockSize(nEventsInBlock) {
+	memcpy(fileHeader.magic, fileMagic, sizeof(fileHeader.magic));
+	fileHeader.version = fileVersion;
+	if (blockSize < 1)
+		blockSize = 1;
+}
+
+TACFeatureWriter::~TACFeatureWriter() {
+	close();
+}
+
+bool TACFeatureWriter::open(const string& name) {
+	close();
+	lock_guard<mutex> fileGuard(fileMutex);
+	fileStream.open(name, ios::out | ios::binary | ios::trunc);
+	if (!fileStream) {
+		cerr << "TACFeatureWriter: cannot open " << name << endl;
+		return false;
+	}
+	fileName = name;
+	fileStream.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+	totalBytes += sizeof(fileHeader);
+	return true;
+}
+
+void TACFeatureWriter::close() {
+	flush();
+	lock_guard<mutex> fileGuard(fileMutex);
+	if (fileStream.is_open()) {
+		fileStream.close();
+		cout << "TACFeatureWriter: " << totalEvents << " events, "
+				<< totalBytes << " bytes written" << endl;
+	}
+}
+
+void TACFeatureWriter::flush() {
+	Block block;
+	if (takeBlock(block))
+		writeBlock(block);
+	lock_guard<mutex> fileGuard(fileMutex);
+	if (fileStream.is_open())
+		fileStream.flush();
+}
+
+bool TACFeatureWriter::takeBlock(Block& block) {
+	lock_guard<mutex> blockGuard(blockMutex);
+	if (currentBlock.nEvents == 0)
+		return false;
+	swap(block, currentBlock);
+	currentBlock.clear();
+	return true;
+}
+
+void TACFeatureWriter::append(const TACEventData& eventData,
+		const TACEventSummary& summary) {
+	Block fullBlock;
+	bool blockIsFull = false;
+	{
+		lock_guard<mutex> blockGuard(blockMutex);
+		// Every block belongs to a single run
+		if (currentBlock.nEvents > 0 && currentBlock.runNumber != eventData.runNumber) {
+			swap(fullBlock, currentBlock);
+			currentBlock.clear();
+			blockIsFull = true;
+		}
+		Block& block = currentBlock;
+		block.runNumber = eventData.runNumber;
+		block.nEvents++;
+		block.columns[EVENT_NUMBER].ints.push_back(eventData.eventNumber);
+		block.columns[TRIGGER_MASK].ints.push_back(eventData.triggerMask);
+		block.columns[N_WAVEFORMS].ints.push_back(eventData.nWaveforms);
+		block.columns[WAVE_PEAK].ints.push_back(summary.wavePeak);
+		block.columns[WAVE_TIME].ints.push_back(summary.waveTime);
+		if (fileHeader.hasSamples) {
+			block.columns[N_SAMPLES].ints.push_back(eventData.samples.size());
+			for (auto sample : eventData.samples)
+				block.columns[SAMPLES].ints.push_back(sample);
+		}
+		block.columns[N_PULSES].ints.push_back(eventData.pulses.size());
+		block.columns[PULSE_PEAK].reals.push_back(summary.pulsePeak);
+		block.columns[PULSE_TIME].reals.push_back(summary.pulseTime);
+		block.columns[PULSE_INTEGRAL].reals.push_back(summary.pulseIntegral);
+		block.columns[N_TDC_HITS].ints.push_back(eventData.nTDCHits);
+		block.columns[N_TDC_TIMES].ints.push_back(eventData.tdcTimes.size());
+		for (auto tdcTime : eventData.tdcTimes)
+			block.columns[TDC_TIMES].reals.push_back(tdcTime);
+		appendTaggerHits(eventData.taghHits, fileHeader.taghTimeCutValue,
+				N_TAGH_HITS, TAGH_COUNTER, TAGH_TIME);
+		appendTaggerHits(eventData.tagmHits, fileHeader.tagmTimeCutValue,
+				N_TAGM_HITS, TAGM_COUNTER, TAGM_TIME);
+		block.columns[ANOMALY_FLAGS].ints.push_back(summary.anomalyFlags);
+		block.columns[SHAPE_CHI2].reals.push_back(summary.shapeChi2);
+		totalEvents++;
+
+		if (!blockIsFull && block.nEvents >= blockSize) {
+			swap(fullBlock, currentBlock);
+			currentBlock.clear();
+			blockIsFull = true;
+		}
+	}
+	if (blockIsFull)
+		writeBlock(fullBlock);
+}
+
+// Called with blockMutex held
+void TACFeatureWriter::appendTaggerHits(
+		const vector<TACEventData::TaggerHit>& hits, double center,
+		ColumnId countColumn, ColumnId counterColumn, ColumnId timeColumn) {
+	Block& block = currentBlock;
+	uint64_t nStored = 0;
+	for (auto& hit : hits) {
+		if (fileHeader.taggerWindow > 0
+				&& fabs(hit.time - center) >= fileHeader.taggerWindow)
+			continue;
+		block.columns[counterColumn].ints.push_back(hit.counter);
+		block.columns[timeColumn].reals.push_back(hit.time);
+		nStored++;
+	}
+	block.columns[countColumn].ints.push_back(nStored);
+}
+
+void TACFeatureWriter::writeBlock(const Block& block) {
+	// Encode outside of the file lock so that several threads can encode at once
+	vector<char> columnData;
+	vector<ColumnHeader> columnHeaders;
+	for (unsigned columnId = 0; columnId < NUMBER_OF_COLUMNS; columnId++) {
+		const Column& column = block.columns[columnId];
+		if (column.size() == 0)
+			continue;
+		size_t start = columnData.size();
+		encodeColumn(columnId, column, columnData);
+		ColumnHeader columnHeader = { };
+		columnHeader.id = columnId;
+		columnHeader.encoding = getColumnEncoding(columnId);
+		columnHeader.nValues = column.size();
+		columnHeader.size = columnData.size() - start;
+		columnHeaders.push_back(columnHeader);
+	}
+	BlockHeader blockHeader = { };
+	blockHeader.magic = blockMagic;
+	blockHeader.runNumber = block.runNumber;
+	blockHeader.nEvents = block.nEvents;
+	blockHeader.nColumns = columnHeaders.size();
+	blockHeader.payloadSize = columnHeaders.size() * sizeof(ColumnHeader)
+			+ columnData.size();
+
+	lock_guard<mutex> fileGuard(fileMutex);
+	if (!fileStream.is_open())
+		return;
+	fileStream.write(reinterpret_cast<const char*>(&blockHeader), sizeof(blockHeader));
+	fileStream.write(reinterpret_cast<const char*>(columnHeaders.data()),
+			columnHeaders.size() * sizeof(ColumnHeader));
+	fileStream.write(columnData.data(), columnData.size());
+	totalBytes += sizeof(blockHeader) + blockHeader.payloadSize;
+}
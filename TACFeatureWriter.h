@@ -0,0 +1,83 @@
+/*
+ * TACFeatureWriter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Writes one compact record per accepted event into a TAC feature file (see
+ *  TACFeatureFormat.h). The events are collected column-wise in a block and
+ *  the block is encoded and written when it is full, by the thread that
+ *  filled it and without blocking the threads that keep appending.
+ */
+
+#ifndef TACFEATUREWRITER_H_
+#define TACFEATUREWRITER_H_
+
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+
+#include "TACEventData.h"
+#include "TACFeatureFormat.h"
+
+class TACFeatureWriter {
+protected:
+	TACFeatureFormat::FileHeader fileHeader;
+	std::string fileName;
+	std::ofstream fileStream;
+
+	// Number of events in a block
+	unsigned blockSize;
+	TACFeatureFormat::Block currentBlock;
+
+	// Protects currentBlock
+	std::mutex blockMutex;
+	// Protects the file
+	std::mutex fileMutex;
+
+	uint64_t totalEvents = 0;
+	uint64_t totalBytes = 0;
+
+	void appendTaggerHits(const std::vector<TACEventData::TaggerHit>& hits,
+			double center, TACFeatureFormat::ColumnId countColumn,
+			TACFeatureFormat::ColumnId counterColumn,
+			TACFeatureFormat::ColumnId timeColumn);
+	// Take the block out if it has events, returns false if it was empty
+	bool takeBlock(TACFeatureFormat::Block& block);
+	// Encode the block and write it to the file
+	void writeBlock(const TACFeatureFormat::Block& block);
+
+public:
+	// The header tells what is stored and with which plugin settings
+	TACFeatureWriter(const TACFeatureFormat::FileHeader& header,
+			unsigned nEventsInBlock = 4096);
+	virtual ~TACFeatureWriter();
+
+	TACFeatureWriter(const TACFeatureWriter&) = delete;
+	TACFeatureWriter& operator=(const TACFeatureWriter&) = delete;
+
+	// Write what was collected into the current file and start a new one
+	virtual bool open(const std::string& name);
+	virtual void close();
+	// Write the events collected so far
+	virtual void flush();
+
+	// Add an event, thread-safe
+	virtual void append(const TACEventData& eventData,
+			const TACEventSummary& summary);
+
+	const std::string& getFileName() const {
+		return fileName;
+	}
+
+	uint64_t getTotalEvents() const {
+		return totalEvents;
+	}
+
+	uint64_t getTotalBytes() const {
+		return totalBytes;
+	}
+};
+
+#endif /* TACFEATUREWRITER_H_ */
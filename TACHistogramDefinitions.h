@@ -0,0 +1,213 @@
+/*
+ * TACHistogramDefinitions.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Table of the histograms created by the TAC monitor for every useful trigger
+ *  bit. The plugin builds its histograms from this table and the stand-alone
+ *  tools use it to know how each histogram has to be treated.
+ */
+
+#ifndef TACHISTOGRAMDEFINITIONS_H_
+#define TACHISTOGRAMDEFINITIONS_H_
+
+#include <string>
+#include <vector>
+
+struct TACHistogramDefinition {
+	// How histograms from different outputs are combined
+	enum MergeMode {
+		MERGE_ADD,        // bin-by-bin sum
+		MERGE_LATEST,     // snapshot of a single event, keep the latest one
+		MERGE_AVERAGE,    // derived as TACFADCRAW_SUM / TACFADCRAW_ENTRIES
+		MERGE_EFFICIENCY  // derived as <det>_ID_MATCHEDPULSE / <det>_ID_PULSE
+	};
+
+	std::string key;
+	std::string titlePrefix;
+	std::string xTitle;
+	// Empty for 1D histograms
+	std::string yTitle;
+	int nBinsX;
+	double xMin;
+	double xMax;
+	int nBinsY;
+	double yMin;
+	double yMax;
+	MergeMode mergeMode;
+	// Filled without the ROOT lock through an AtomicHistogram, false if omitted
+	bool atomic;
+	// Also kept in time slices, shown in <key>_ROLLING. False if omitted.
+	bool rolling;
+
+	bool is2D() const {
+		return !yTitle.empty();
+	}
+};
+
+// Return the table of all histograms created for a trigger bit. Histogram names
+// are built as <key>_<trigger bit>.
+inline const std::vector<TACHistogramDefinition>& getTACHistogramDefinitions() {
+	typedef TACHistogramDefinition Def;
+	static const std::vector<TACHistogramDefinition> definitions = {
+		// TAC FADC raw data
+		{ "TACFADCRAW", "Single TAC FADC waveform for Trigger ", "FlashADC sample number [#]", "",
+				100, 0., 100., 0, 0., 0., Def::MERGE_LATEST },
+		// TAC summed FADC raw data
+		{ "TACFADCRAW_SUM", "Summed TAC FADC waveform for Trigger ", "FlashADC sample number [#]", "",
+				100, 0., 100., 0, 0., 0., Def::MERGE_ADD },
+		// TAC FADC raw data for entries
+		{ "TACFADCRAW_ENTRIES", "Entries in TAC FADC waveform for Trigger  ", "FlashADC sample number [#]", "",
+				100, 0., 100., 0, 0., 0., Def::MERGE_ADD },
+		// TAC averaged FADC raw data
+		{ "TACFADCRAW_AVG", "Averaged TAC FADC waveform", "FlashADC sample number [#]", "",
+				100, 0., 100., 0, 0., 0., Def::MERGE_AVERAGE },
+		// Most recent TAC FADC waveforms, one per row, the newest at the bottom
+		{ "TACFADCRAW_RECENT", "Recent TAC FADC waveforms for Trigger ", "FlashADC sample number [#]", "Waveform age [#]",
+				100, 0., 100., 16, 0., 16., Def::MERGE_LATEST },
+
+		// Waveforms flagged by the anomaly detector: saturated, pile-up, odd shape
+		{ "TAC_ANOMALIES", "Unusual TAC waveforms for Trigger ", "Saturated / Pile-up / Shape", "",
+				3, 0., 3., 0, 0., 0., Def::MERGE_ADD },
+
+		// TAC number of ADC hits histogram
+		{ "TAC_NHITS", "Number of ADC hits in TAC for Trigger ", "number of hits from FADC FPGA [#]", "",
+				7, 0., 7., 0, 0., 0., Def::MERGE_ADD },
+		// TAC number of TDC hits histogram
+		{ "TAC_NTDCHITS", "Number of TDC hits in TAC for Trigger ", "number of TDC hits [#]", "",
+				7, 0., 7., 0, 0., 0., Def::MERGE_ADD, true },
+		// TAC TDC hit time
+		{ "TAC_TDCTIME", "TDC time in TAC for Trigger ", "TDC time [ns]", "",
+				500, 0., 500., 0, 0., 0., Def::MERGE_ADD, true, true },
+		// TAC TDC hit time minus ADC time
+		{ "TAC_TDCADCTIME", "TDC-ADC time in TAC for Trigger ", "TDC-ADC time [ns]", "",
+				1000, -500., 500., 0, 0., 0., Def::MERGE_ADD, true },
+
+		// TAC amplitude histos
+		{ "TACAmpPULSE", "TAC Largest Signal Amplitude for Trigger ", "TAC Amplitude", "",
+				500, 0., 5000., 0, 0., 0., Def::MERGE_ADD, false, true },
+		// TAC amplitude histos for going through the data and picking the highest bin
+		{ "TACAmpWAVE", "TAC Signal Maximum from Raw for Trigger ", "TAC Amplitude", "",
+				500, 0., 5000., 0, 0., 0., Def::MERGE_ADD },
+		// TAC amplitude from the template fit of the raw data
+		{ "TACAmpFIT", "TAC Signal Amplitude from Template Fit for Trigger ", "TAC Amplitude", "",
+				500, 0., 5000., 0, 0., 0., Def::MERGE_ADD },
+		// TAC integral histos from firmware
+		{ "TACIntegral", "TAC Largest Signal Integral for Trigger ", "TAC Integral", "",
+				1000, 0., 14000., 0, 0., 0., Def::MERGE_ADD },
+		// TAC signal time histo
+		{ "TACTimePULSE", "TAC Signal time from firmware for Trigger ", "FlashADC peak time (ns)", "",
+				400, 0., 400., 0, 0., 0., Def::MERGE_ADD, false, true },
+		// TAC signal time based on raw data histo
+		{ "TACTimeWAVE", "TAC Signal based on raw data time for Trigger ", "FlashADC peak time (ns)", "",
+				400, 0., 400., 0, 0., 0., Def::MERGE_ADD },
+		// TAC signal time from the template fit of the raw data
+		{ "TACTimeFIT", "TAC Signal time from Template Fit for Trigger ", "FlashADC peak time (ns)", "",
+				400, 0., 400., 0, 0., 0., Def::MERGE_ADD },
+
+		// Last TAC:ROLLING_WINDOW_SLICES time slices of the rolling histograms
+		{ "TACAmpPULSE_ROLLING", "Recent TAC Largest Signal Amplitude for Trigger ", "TAC Amplitude", "",
+				500, 0., 5000., 0, 0., 0., Def::MERGE_ADD },
+		{ "TACTimePULSE_ROLLING", "Recent TAC Signal time from firmware for Trigger ", "FlashADC peak time (ns)", "",
+				400, 0., 400., 0, 0., 0., Def::MERGE_ADD },
+		{ "TAC_TDCTIME_ROLLING", "Recent TDC time in TAC for Trigger ", "TDC time [ns]", "",
+				500, 0., 500., 0, 0., 0., Def::MERGE_ADD },
+		{ "TAGH_ID_MATCHEDPULSE_ROLLING", "Recent Matched TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "",
+				320, 0., 320., 0, 0., 0., Def::MERGE_ADD },
+		{ "TAGM_ID_MATCHEDPULSE_ROLLING", "Recent Matched TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]", "",
+				110, 0., 110., 0, 0., 0., Def::MERGE_ADD },
+		// Useful events per second in each of the last time slices
+		{ "TAC_RATE", "Event rate per time slice for Trigger ", "Time slices ago [#]", "",
+				60, 0., 60., 0, 0., 0., Def::MERGE_ADD },
+
+		// TAGH Hits detector ID
+		{ "TAGH_ID", "TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "",
+				320, 0., 320., 0, 0., 0., Def::MERGE_ADD },
+		// Matched TAGH Hits detector ID
+		{ "TAGH_ID_MATCHEDPULSE", "Matched TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "",
+				320, 0., 320., 0, 0., 0., Def::MERGE_ADD, false, true },
+		{ "TAGH_ID_MATCHEDWAVE", "Matched TAGH Hits Detector ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "",
+				320, 0., 320., 0, 0., 0., Def::MERGE_ADD },
+		// TAGH Hits detector ID in events with a TAC pulse, set from the efficiency counters
+		{ "TAGH_ID_PULSE", "TAGH Hits Detector ID with TAC Pulse for Trigger ", "Tagger Hodoscope Det. Number [#]", "",
+				320, 0., 320., 0, 0., 0., Def::MERGE_ADD },
+		// TAC efficiency per TAGH counter
+		{ "TAGH_EFFICIENCY", "TAC Efficiency per TAGH Counter for Trigger ", "Tagger Hodoscope Det. Number [#]", "",
+				320, 0., 320., 0, 0., 0., Def::MERGE_EFFICIENCY },
+		// TAGH signal time histo
+		{ "TAGHSigTime", "TAGH Signal time for Trigger ", "FlashADC peak time (ns)", "",
+				400, 0., 400., 0, 0., 0., Def::MERGE_ADD },
+		// TAC time vs TAGH FADC time histo
+		{ "TACTIMEPULSEvsTAGHTIME", "TAC time vs TAGH time for Trigger ", "FlashADC peak time for TAGH (ns)", "FlashADC peak time for TAC (ns)",
+				400, 0., 400., 400, 0., 400., Def::MERGE_ADD },
+		{ "TACTIMEWAVEvsTAGHTIME", "TAC time vs TAGH time for Trigger ", "FlashADC peak time for TAGH (ns)", "FlashADC peak time for TAC (ns)",
+				400, 0., 400., 400, 0., 400., Def::MERGE_ADD },
+		// TAC amplitude vs TAGH ID histo
+		{ "TACAMPPULSEvsTAGHID", "TAC FADC Amplitude vs TAGH ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "FlashADC peak for TAC",
+				320, 0., 320., 1000, 10., 5000., Def::MERGE_ADD },
+		{ "TACAMPWAVEvsTAGHID", "TAC FADC Amplitude vs TAGH ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "FlashADC peak for TAC",
+				320, 0., 320., 1000, 10., 5000., Def::MERGE_ADD },
+		// TAGH time vs TAGH ID histo
+		{ "TAGHTIMEvsTAGHID", "TAGH Time vs TAGH ID for Trigger ", "Tagger Hodoscope Det. Number [#]", "TAGH time",
+				320, 0., 320., 400, 0., 400., Def::MERGE_ADD },
+
+		// TAGM Hits detector ID
+		{ "TAGM_ID", "TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]", "",
+				110, 0., 110., 0, 0., 0., Def::MERGE_ADD },
+		// Matched TAGM Hits detector ID
+		{ "TAGM_ID_MATCHEDPULSE", "Matched TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]", "",
+				110, 0., 110., 0, 0., 0., Def::MERGE_ADD, false, true },
+		{ "TAGM_ID_MATCHEDWAVE", "Matched TAGM Hits Detector ID for Trigger ", "Tagger Microscope Det. Number [#]", "",
+				110, 0., 110., 0, 0., 0., Def::MERGE_ADD },
+		// TAGM Hits detector ID in events with a TAC pulse, set from the efficiency counters
+		{ "TAGM_ID_PULSE", "TAGM Hits Detector ID with TAC Pulse for Trigger ", "Tagger Microscope Det. Number [#]", "",
+				110, 0., 110., 0, 0., 0., Def::MERGE_ADD },
+		// TAC efficiency per TAGM counter
+		{ "TAGM_EFFICIENCY", "TAC Efficiency per TAGM Counter for Trigger ", "Tagger Microscope Det. Number [#]", "",
+				110, 0., 110., 0, 0., 0., Def::MERGE_EFFICIENCY },
+		// TAGM signal time histo
+		{ "TAGMSigTime", "TAGM Signal time for Trigger ", "FlashADC peak time (ns)", "",
+				400, 0., 400., 0, 0., 0., Def::MERGE_ADD },
+		// TAC time vs TAGM FADC time histo
+		{ "TACTIMEPULSEvsTAGMTIME", "TAC time vs TAGM time for Trigger ", "FlashADC peak time for TAGM (ns)", "FlashADC peak time for TAC (ns)",
+				400, 0., 400., 400, 0., 400., Def::MERGE_ADD },
+		{ "TACTIMEWAVEvsTAGMTIME", "TAC time vs TAGM time for Trigger ", "FlashADC peak time for TAGM (ns)", "FlashADC peak time for TAC (ns)",
+				400, 0., 400., 400, 0., 400., Def::MERGE_ADD },
+		// TAC amplitude vs TAGM ID histo
+		{ "TACAMPPULSEvsTAGMID", "TAC FADC Amplitude vs TAGM ID for Trigger ", "Tagger Microscope Det. Number [#]", "FlashADC peak for TAC",
+				110, 0., 110., 1000, 10., 5000., Def::MERGE_ADD },
+		{ "TACAMPWAVEvsTAGMID", "TAC FADC Amplitude vs TAGM ID for Trigger ", "Tagger Microscope Det. Number [#]", "FlashADC peak for TAC",
+				110, 0., 110., 1000, 10., 5000., Def::MERGE_ADD },
+		// TAGM time vs TAGM ID histo
+		{ "TAGMTIMEvsTAGMID", "TAGM Time vs TAGM ID for Trigger ", "Tagger Microscope Det. Number [#]", "TAGM time",
+				110, 0., 110., 400, 0., 400., Def::MERGE_ADD },
+	};
+	return definitions;
+}
+
+// Return the definition for the histogram key, nullptr if the key is unknown
+inline const TACHistogramDefinition* findTACHistogramDefinition(const std::string& key) {
+	for (auto& definition : getTACHistogramDefinitions()) {
+		if (definition.key == key)
+			return &definition;
+	}
+	return nullptr;
+}
+
+// Split a histogram name <key>_<trigger bit> into the key and the trigger bit.
+// Returns false if the name does not end with a trigger bit number.
+inline bool splitTACHistogramName(const std::string& histName, std::string& key,
+		unsigned& trigBit) {
+	auto underscore = histName.find_last_of('_');
+	if (underscore == std::string::npos || underscore + 1 == histName.size())
+		return false;
+	std::string bitString = histName.substr(underscore + 1);
+	if (bitString.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+	key = histName.substr(0, underscore);
+	trigBit = std::stoul(bitString);
+	return true;
+}
+
+#endif /* TACHISTOGRAMDEFINITIONS_H_ */
@@ -0,0 +1,90 @@
+/*
+ * TACMetrics.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <sstream>
+#include <cstring>
+
+#include "TACMetrics.h"
+
+using namespace std;
+
+mutex TACMetrics::registryMutex;
+vector<TACMetrics::ThreadCounters*> TACMetrics::registry;
+
+namespace {
+
+const TACMetrics::Description descriptions[TACMetrics::nCounters] = {
+	{ "tac_events_seen_total", "", "Events given to the TAC monitor", false },
+	{ "tac_events_accepted_total", "", "Events with a useful trigger bit", false },
+	{ "tac_events_late_total", "", "Events dropped because their run was already written", false },
+	{ "tac_multiple_waveforms_total", "", "Events with more than one TAC waveform", false },
+	{ "tac_pulses_total", "", "TAC firmware pulses", false },
+	{ "tac_overflow_pulses_total", "", "TAC firmware pulses at or above the maximum pulse value", false },
+	{ "tac_tagger_hits_total", "detector=\"TAGH\"", "Tagger hits compared with the TAC firmware pulse, per trigger bit", false },
+	{ "tac_tagger_hits_total", "detector=\"TAGM\"", "", false },
+	{ "tac_tagger_matches_total", "detector=\"TAGH\"", "Tagger hits within the time window of the TAC firmware pulse, per trigger bit", false },
+	{ "tac_tagger_matches_total", "detector=\"TAGM\"", "", false },
+	{ "tac_snapshots_total", "", "ROOT file snapshots written", false },
+	{ "tac_snapshot_seconds_total", "", "Time spent collecting and writing ROOT file snapshots", true },
+	{ "tac_root_locks_total", "", "ROOT write locks taken by the event threads", false },
+	{ "tac_root_lock_wait_seconds_total", "", "Time the event threads waited for the ROOT write lock", true },
+};
+
+}
+
+TACMetrics::ThreadCounters* TACMetrics::registerThread() {
+	ThreadCounters* counters = new ThreadCounters();
+	lock_guard<mutex> guard(registryMutex);
+	registry.push_back(counters);
+	return counters;
+}
+
+uint64_t TACMetrics::getTotal(Counter counter) {
+	uint64_t total = 0;
+	lock_guard<mutex> guard(registryMutex);
+	for (auto counters : registry)
+		total += counters->get(counter);
+	return total;
+}
+
+void TACMetrics::getTotals(vector<uint64_t>& totals) {
+	totals.assign(nCounters, 0);
+	lock_guard<mutex> guard(registryMutex);
+	for (auto counters : registry) {
+		for (unsigned iCounter = 0; iCounter < nCounters; iCounter++)
+			totals[iCounter] += counters->get(Counter(iCounter));
+	}
+}
+
+const TACMetrics::Description& TACMetrics::getDescription(Counter counter) {
+	return descriptions[counter];
+}
+
+void TACMetrics::format(string& text) {
+	static thread_local vector<uint64_t> totals;
+	getTotals(totals);
+	stringstream textStream;
+	// The seconds keep their nanoseconds for a long time
+	textStream.precision(15);
+	const char* family = "";
+	for (unsigned iCounter = 0; iCounter < nCounters; iCounter++) {
+		const Description& description = descriptions[iCounter];
+		if (strcmp(description.family, family) != 0) {
+			family = description.family;
+			textStream << "# HELP " << family << " " << description.help << "\n"
+					<< "# TYPE " << family << " counter\n";
+		}
+		textStream << family;
+		if (description.labels[0] != '\0')
+			textStream << "{" << description.labels << "}";
+		if (description.nanoseconds)
+			textStream << " " << totals[iCounter] * 1e-9 << "\n";
+		else
+			textStream << " " << totals[iCounter] << "\n";
+	}
+	text = textStream.str();
+}
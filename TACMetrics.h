@@ -0,0 +1,105 @@
+/*
+ * TACMetrics.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Health counters of the monitor itself, for alerting on it. Every thread
+ *  counts into its own block, padded to keep it off the cache lines of the
+ *  others, and only that thread writes it. The blocks are summed by whoever
+ *  reads the totals, usually TACMetricsExporter. Blocks are never freed, so
+ *  the totals do not go down when a thread exits.
+ */
+
+#ifndef TACMETRICS_H_
+#define TACMETRICS_H_
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+class TACMetrics {
+public:
+	enum Counter {
+		EVENTS_SEEN,
+		EVENTS_ACCEPTED,
+		// Events whose run was already written
+		EVENTS_LATE,
+		MULTIPLE_WAVEFORMS,
+		PULSES,
+		OVERFLOW_PULSES,
+		TAGH_HITS,
+		TAGH_MATCHES,
+		TAGM_HITS,
+		TAGM_MATCHES,
+		SNAPSHOTS,
+		SNAPSHOT_NANOSECONDS,
+		// Copied from TimedWriteLock, only counted while its timing is enabled
+		ROOT_LOCKS,
+		ROOT_LOCK_WAIT_NANOSECONDS,
+		nCounters
+	};
+
+	// How a counter is exported: metric family, labels and help text. The
+	// counters of one family are next to each other.
+	struct Description {
+		const char* family;
+		const char* labels;
+		const char* help;
+		// Exported in seconds
+		bool nanoseconds;
+	};
+
+	class ThreadCounters {
+	protected:
+		char leadingPadding[64];
+		std::atomic<uint64_t> values[nCounters];
+		char trailingPadding[64];
+
+	public:
+		ThreadCounters() {
+			for (auto& value : values)
+				value.store(0, std::memory_order_relaxed);
+		}
+		ThreadCounters(const ThreadCounters&) = delete;
+		ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+		// Only the owning thread writes, so no read-modify-write is needed
+		void add(Counter counter, uint64_t n = 1) {
+			values[counter].store(values[counter].load(std::memory_order_relaxed) + n,
+					std::memory_order_relaxed);
+		}
+		void set(Counter counter, uint64_t value) {
+			values[counter].store(value, std::memory_order_relaxed);
+		}
+		uint64_t get(Counter counter) const {
+			return values[counter].load(std::memory_order_relaxed);
+		}
+	};
+
+protected:
+	static std::mutex registryMutex;
+	static std::vector<ThreadCounters*> registry;
+
+	static ThreadCounters* registerThread();
+
+public:
+	// Counters of the calling thread
+	static ThreadCounters& getThreadCounters() {
+		static thread_local ThreadCounters* threadCounters = registerThread();
+		return *threadCounters;
+	}
+
+	// Sum of a counter over all threads
+	static uint64_t getTotal(Counter counter);
+	static void getTotals(std::vector<uint64_t>& totals);
+
+	static const Description& getDescription(Counter counter);
+
+	// All counters in the Prometheus text format
+	static void format(std::string& text);
+};
+
+#endif /* TACMETRICS_H_ */
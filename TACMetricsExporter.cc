@@ -0,0 +1,136 @@
+/*
+ * TACMetricsExporter.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "TACMetricsExporter.h"
+#include "TACMetrics.h"
+
+using namespace std;
+
+// How often the thread looks whether it should stop
+static const int pollMilliseconds = 200;
+
+TACMetricsExporter::TACMetricsExporter(string file, string socket, unsigned period) :
+		fileName(file), socketPath(socket), periodSeconds(max(period, 1u)) {
+}
+
+TACMetricsExporter::~TACMetricsExporter() {
+	stop();
+}
+
+bool TACMetricsExporter::openSocket() {
+	listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFD < 0)
+		return false;
+	sockaddr_un unixAddress = { };
+	unixAddress.sun_family = AF_UNIX;
+	socketPath.copy(unixAddress.sun_path, sizeof(unixAddress.sun_path) - 1);
+	unlink(socketPath.c_str());
+	if (bind(listenFD, reinterpret_cast<sockaddr*>(&unixAddress), sizeof(unixAddress)) != 0
+			|| listen(listenFD, 16) != 0) {
+		cerr << "TACMetricsExporter: cannot listen on " << socketPath << endl;
+		closeSocket();
+		return false;
+	}
+	fcntl(listenFD, F_SETFL, fcntl(listenFD, F_GETFL) | O_NONBLOCK);
+	return true;
+}
+
+void TACMetricsExporter::closeSocket() {
+	if (listenFD < 0)
+		return;
+	close(listenFD);
+	listenFD = -1;
+	unlink(socketPath.c_str());
+}
+
+void TACMetricsExporter::start() {
+	if (exportThread.joinable())
+		return;
+	if (!socketPath.empty())
+		openSocket();
+	stopping = false;
+	exportThread = thread(&TACMetricsExporter::run, this);
+}
+
+void TACMetricsExporter::stop() {
+	if (!exportThread.joinable())
+		return;
+	stopping = true;
+	exportThread.join();
+	closeSocket();
+}
+
+void TACMetricsExporter::run() {
+	auto nextUpdate = chrono::steady_clock::now();
+	while (true) {
+		if (stopping || chrono::steady_clock::now() >= nextUpdate) {
+			update();
+			nextUpdate += chrono::seconds(periodSeconds);
+		}
+		if (stopping)
+			return;
+		if (listenFD < 0) {
+			this_thread::sleep_for(chrono::milliseconds(pollMilliseconds));
+			continue;
+		}
+		pollfd pollFD = { listenFD, POLLIN, 0 };
+		if (poll(&pollFD, 1, pollMilliseconds) > 0)
+			serve();
+	}
+}
+
+void TACMetricsExporter::update() {
+	TACMetrics::format(text);
+	if (!fileName.empty())
+		writeFile();
+}
+
+bool TACMetricsExporter::writeFile() {
+	string tmpName = fileName + ".tmp";
+	{
+		ofstream file(tmpName.c_str(), ios::trunc);
+		file << text;
+		if (!file) {
+			cerr << "TACMetricsExporter: cannot write " << tmpName << endl;
+			return false;
+		}
+	}
+	return rename(tmpName.c_str(), fileName.c_str()) == 0;
+}
+
+// The clients read until the connection is closed
+void TACMetricsExporter::serve() {
+	int clientFD = accept(listenFD, nullptr, nullptr);
+	if (clientFD < 0)
+		return;
+	// A client that does not read must not hold up the exports
+	timeval timeout = { 1, 0 };
+	setsockopt(clientFD, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	const char* current = text.data();
+	size_t nLeft = text.size();
+	while (nLeft > 0) {
+		ssize_t nSent = send(clientFD, current, nLeft, MSG_NOSIGNAL);
+		if (nSent <= 0)
+			break;
+		current += nSent;
+		nLeft -= nSent;
+	}
+	close(clientFD);
+}
@@ -0,0 +1,64 @@
+/*
+ * TACMetricsExporter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Exports the TACMetrics counters in the Prometheus text format from its own
+ *  thread, so that neither the event threads nor ROOT are involved. Every
+ *  period the totals are written into a text file, replaced with a rename so
+ *  that a reader like the node_exporter textfile collector never sees half of
+ *  it, and/or kept for clients of a Unix domain socket, which get the text of
+ *  the last period on every connection.
+ */
+
+#ifndef TACMETRICSEXPORTER_H_
+#define TACMETRICSEXPORTER_H_
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+class TACMetricsExporter {
+protected:
+	// Text file and socket path, neither is used if empty
+	std::string fileName;
+	std::string socketPath;
+	unsigned periodSeconds;
+
+	int listenFD = -1;
+	std::string text;
+
+	std::thread exportThread;
+	std::atomic<bool> stopping{false};
+
+	virtual bool openSocket();
+	virtual void closeSocket();
+	virtual void run();
+	// Totals into text and the file
+	virtual void update();
+	virtual bool writeFile();
+	// Send the text to one waiting client
+	virtual void serve();
+
+public:
+	TACMetricsExporter(std::string file, std::string socket, unsigned period);
+	virtual ~TACMetricsExporter();
+
+	TACMetricsExporter(const TACMetricsExporter&) = delete;
+	TACMetricsExporter& operator=(const TACMetricsExporter&) = delete;
+
+	virtual void start();
+	// Exports a last time and stops the thread
+	virtual void stop();
+
+	const std::string& getFileName() const {
+		return fileName;
+	}
+
+	const std::string& getSocketPath() const {
+		return socketPath;
+	}
+};
+
+#endif /* TACMETRICSEXPORTER_H_ */
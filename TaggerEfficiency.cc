@@ -0,0 +1,61 @@
+/*
+ * TaggerEfficiency.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "TH1.h"
+
+#include "TaggerEfficiency.h"
+
+using namespace std;
+
+double TaggerEfficiency::getEfficiency(unsigned counter) const {
+	if (counter >= total.size() || total[counter] == 0)
+		return 0;
+	return double(matched[counter]) / total[counter];
+}
+
+// Same as the "B" option of TH1::Divide for unweighted histograms
+double TaggerEfficiency::getEfficiencyError(unsigned counter) const {
+	if (counter >= total.size() || total[counter] == 0)
+		return 0;
+	double efficiency = getEfficiency(counter);
+	return sqrt(efficiency * (1 - efficiency) / total[counter]);
+}
+
+bool TaggerEfficiency::refresh(TH1* totalHisto, TH1* efficiencyHisto) {
+	if (!changed)
+		return false;
+	totalHisto->Reset();
+	efficiencyHisto->Reset();
+	uint64_t nHits = 0;
+	for (unsigned counter = 0; counter < total.size(); counter++) {
+		if (total[counter] == 0)
+			continue;
+		int bin = totalHisto->FindFixBin(counter);
+		totalHisto->SetBinContent(bin, total[counter]);
+		efficiencyHisto->SetBinContent(bin, getEfficiency(counter));
+		efficiencyHisto->SetBinError(bin, getEfficiencyError(counter));
+		nHits += total[counter];
+	}
+	totalHisto->SetEntries(nHits);
+	efficiencyHisto->SetEntries(nHits);
+	changed = false;
+	return true;
+}
+
+// The matched hits are counted in the same place as the hits, one to one
+void TaggerEfficiency::restore(const TH1* totalHisto, const TH1* matchedHisto) {
+	for (unsigned counter = 0; counter < total.size(); counter++) {
+		int bin = totalHisto->FindFixBin(counter);
+		total[counter] = uint64_t(max(totalHisto->GetBinContent(bin), 0.) + 0.5);
+		matched[counter] = min(total[counter],
+				uint64_t(max(matchedHisto->GetBinContent(bin), 0.) + 0.5));
+	}
+	changed = true;
+}
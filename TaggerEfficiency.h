@@ -0,0 +1,69 @@
+/*
+ * TaggerEfficiency.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  TAC efficiency of every TAGH or TAGM counter: the number of hits of the
+ *  counter in events with a TAC pulse and the number of those matched in
+ *  time, kept in flat arrays indexed by the counter number. The efficiency
+ *  histogram is only recomputed from the arrays when it is written or
+ *  published and something was counted since the last time.
+ *
+ *  Not thread-safe, the monitor calls it under the ROOT lock.
+ */
+
+#ifndef TAGGEREFFICIENCY_H_
+#define TAGGEREFFICIENCY_H_
+
+#include <vector>
+#include <stdint.h>
+
+class TH1;
+
+class TaggerEfficiency {
+protected:
+	std::vector<uint64_t> total;
+	std::vector<uint64_t> matched;
+	// Something was counted since the histograms were last set
+	bool changed = false;
+
+public:
+	TaggerEfficiency(unsigned nCounters) :
+			total(nCounters, 0), matched(nCounters, 0) {
+	}
+	virtual ~TaggerEfficiency() {
+	}
+
+	void count(unsigned counter, bool isMatched) {
+		if (counter >= total.size())
+			return;
+		total[counter]++;
+		if (isMatched)
+			matched[counter]++;
+		changed = true;
+	}
+
+	// Set the hits per counter and the efficiency with its binomial error in
+	// histograms binned by counter number. Does nothing and returns false if
+	// nothing changed.
+	virtual bool refresh(TH1* totalHisto, TH1* efficiencyHisto);
+	// Take the counts back from the hits per counter and the matched hits per
+	// counter of histograms whose counts were restored
+	virtual void restore(const TH1* totalHisto, const TH1* matchedHisto);
+
+	double getEfficiency(unsigned counter) const;
+	double getEfficiencyError(unsigned counter) const;
+
+	uint64_t getTotal(unsigned counter) const {
+		return counter < total.size() ? total[counter] : 0;
+	}
+	uint64_t getMatched(unsigned counter) const {
+		return counter < matched.size() ? matched[counter] : 0;
+	}
+	unsigned getNumberOfCounters() const {
+		return total.size();
+	}
+};
+
+#endif /* TAGGEREFFICIENCY_H_ */
@@ -0,0 +1,184 @@
+/*
+ * TaggerTimeCalibration.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "TaggerTimeCalibration.h"
+
+using namespace std;
+
+// Number of hits in the global window before the window is updated
+unsigned TaggerTimeCalibration::entriesPerUpdate = 500;
+// Half-width of the window in standard deviations
+double TaggerTimeCalibration::nSigma = 3.0;
+// Narrowest half-width allowed in ns
+double TaggerTimeCalibration::minWidth = 2.0;
+// Width of the hit time bins in ns
+double TaggerTimeCalibration::binWidth = 0.5;
+// The window is reset if less of the signal than this is inside it
+double TaggerTimeCalibration::minInWindowFraction = 0.5;
+
+atomic<unsigned> TaggerTimeCalibration::nInstances(0);
+
+// Fewer bins outside the window give no useful background estimate
+static const unsigned minSidebandBins = 4;
+
+TaggerTimeCalibration::TaggerTimeCalibration(string name, unsigned nCounterValue,
+		double centerValue, double widthValue) :
+		detectorName(name), defaultCenter(centerValue), defaultWidth(widthValue),
+		nCounters(nCounterValue), nBins(max(1u, unsigned(ceil(2 * widthValue / binWidth)))),
+		instanceID(nInstances++), center(nCounterValue), width(nCounterValue),
+		hitBins(nCounterValue * nBins, 0), nEntries(nCounterValue, 0),
+		nUpdates(nCounterValue, 0) {
+	for (unsigned counter = 0; counter < nCounters; counter++) {
+		center[counter] = defaultCenter;
+		width[counter] = defaultWidth;
+	}
+}
+
+TaggerTimeCalibration::ThreadHits& TaggerTimeCalibration::registerThread() {
+	ThreadHits* hits = new ThreadHits();
+	hits->bins.reset(new atomic<uint32_t>[nCounters * nBins]);
+	for (unsigned iBin = 0; iBin < nCounters * nBins; iBin++)
+		hits->bins[iBin].store(0, memory_order_relaxed);
+	lock_guard<mutex> guard(foldMutex);
+	threadHits.emplace_back(hits);
+	return *hits;
+}
+
+void TaggerTimeCalibration::fold() {
+	lock_guard<mutex> guard(foldMutex);
+	for (auto& hits : threadHits) {
+		for (unsigned counter = 0; counter < nCounters; counter++) {
+			unsigned firstBin = counter * nBins;
+			for (unsigned bin = firstBin; bin < firstBin + nBins; bin++) {
+				// Plain loads first, most bins stay empty between folds
+				if (hits->bins[bin].load(memory_order_relaxed) == 0)
+					continue;
+				uint32_t nHits = hits->bins[bin].exchange(0, memory_order_relaxed);
+				hitBins[bin] += nHits;
+				nEntries[counter] += nHits;
+			}
+		}
+	}
+	for (unsigned counter = 0; counter < nCounters; counter++) {
+		if (nEntries[counter] >= entriesPerUpdate)
+			updateWindow(counter);
+	}
+}
+
+// Subtract the background found outside the window from the hits inside it,
+// then move the window to their mean and set its width from their spread.
+// The window never gets wider than the global one.
+void TaggerTimeCalibration::updateWindow(unsigned counter) {
+	const uint32_t* bins = &hitBins[counter * nBins];
+	double low = defaultCenter - defaultWidth;
+	double windowCenter = center[counter], windowWidth = width[counter];
+	double nInside = 0, nOutside = 0;
+	unsigned nInsideBins = 0;
+	outsideBins.clear();
+	for (unsigned bin = 0; bin < nBins; bin++) {
+		double time = low + (bin + 0.5) * binWidth;
+		if (fabs(time - windowCenter) < windowWidth) {
+			nInside += bins[bin];
+			nInsideBins++;
+		} else {
+			nOutside += bins[bin];
+			outsideBins.push_back(bins[bin]);
+		}
+	}
+	// Without sidebands, as long as the window is the global one, the median
+	// of all bins is taken, the peak covers less than half of them
+	bool hasSidebands = outsideBins.size() >= minSidebandBins;
+	if (!hasSidebands)
+		outsideBins.assign(bins, bins + nBins);
+	// The median, so that a peak that has moved out of the window does not
+	// count as background
+	auto median = outsideBins.begin() + outsideBins.size() / 2;
+	nth_element(outsideBins.begin(), median, outsideBins.end());
+	double background = *median;
+	double signal = nInside + nOutside - background * nBins;
+	double signalInside = nInside - background * nInsideBins;
+
+	if (signal > 0 && signalInside < minInWindowFraction * signal) {
+		// The peak has left the window, look for it in the global one again
+		center[counter] = defaultCenter;
+		width[counter] = defaultWidth;
+	} else if (signalInside > 0) {
+		double sumWeights = 0, sum = 0, sum2 = 0;
+		for (unsigned bin = 0; bin < nBins; bin++) {
+			double time = low + (bin + 0.5) * binWidth;
+			if (fabs(time - windowCenter) >= windowWidth)
+				continue;
+			double weight = bins[bin] - background;
+			// Over the whole global window the fluctuations of the background
+			// far from the peak would swamp the spread, only the excess counts
+			if (!hasSidebands && weight < 0)
+				continue;
+			sumWeights += weight;
+			sum += weight * (time - windowCenter);
+			sum2 += weight * (time - windowCenter) * (time - windowCenter);
+		}
+		double offset = sum / sumWeights;
+		double variance = sum2 / sumWeights - offset * offset + binWidth * binWidth / 12;
+		if (variance > 0) {
+			center[counter] = windowCenter + offset;
+			width[counter] = min(defaultWidth, max(minWidth, nSigma * sqrt(variance)));
+		}
+	}
+	nUpdates[counter]++;
+	nEntries[counter] = 0;
+	fill(hitBins.begin() + counter * nBins, hitBins.begin() + (counter + 1) * nBins, 0);
+}
+
+bool TaggerTimeCalibration::read(const string& fileName) {
+	ifstream inStream(fileName);
+	if (!inStream)
+		return false;
+	string line;
+	unsigned nRead = 0;
+	while (getline(inStream, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+		stringstream lineStream(line);
+		string name;
+		unsigned counter, updates;
+		double counterCenter, counterWidth;
+		if (!(lineStream >> name >> counter >> counterCenter >> counterWidth >> updates))
+			continue;
+		if (name != detectorName || counter >= nCounters)
+			continue;
+		center[counter] = counterCenter;
+		width[counter] = min(counterWidth, defaultWidth);
+		nUpdates[counter] = updates;
+		nRead++;
+	}
+	cout << "TaggerTimeCalibration: " << nRead << " " << detectorName
+			<< " windows read from " << fileName << endl;
+	return true;
+}
+
+bool TaggerTimeCalibration::write(const string& fileName, bool append) const {
+	lock_guard<mutex> guard(foldMutex);
+	ofstream outStream(fileName, append ? ios::app : ios::trunc);
+	if (!outStream) {
+		cerr << "TaggerTimeCalibration: cannot write " << fileName << endl;
+		return false;
+	}
+	outStream << "# detector counter center[ns] half-width[ns] updates" << endl;
+	for (unsigned counter = 0; counter < nCounters; counter++) {
+		// Counters that never got enough hits keep the global window
+		if (nUpdates[counter] == 0)
+			continue;
+		outStream << detectorName << " " << counter << " " << getCenter(counter)
+				<< " " << getWidth(counter) << " " << nUpdates[counter] << endl;
+	}
+	return true;
+}
@@ -0,0 +1,158 @@
+/*
+ * TaggerTimeCalibration.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Per-counter coincidence windows for TAGH or TAGM, calibrated while the
+ *  monitor runs. Every counter starts with the global window. The hit times
+ *  of every counter are histogrammed over the whole global window, and once
+ *  entriesPerUpdate hits are in it fold() updates the window: the flat
+ *  accidental background is taken from the median bin of the global window
+ *  outside the current one, or of the whole global window while the window is
+ *  still the global one, and subtracted. The window is moved to the mean of
+ *  what is left inside and set to nSigma standard deviations of it. If most of the
+ *  signal is found outside the window, because the timing of the counter has
+ *  moved, the window goes back to the global one and narrows again from there.
+ *  The histogram then restarts. The arrays are indexed by counter_id or column.
+ *
+ *  update() is called by the event threads without a lock, every thread fills
+ *  its own histograms. fold() adds them up, it can be called from any thread.
+ *  The windows are atomic, so isMatched() needs no lock either.
+ */
+
+#ifndef TAGGERTIMECALIBRATION_H_
+#define TAGGERTIMECALIBRATION_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+class TaggerTimeCalibration {
+protected:
+	// Hit time histograms of all counters filled by one thread
+	struct ThreadHits {
+		std::unique_ptr<std::atomic<uint32_t>[]> bins;
+		// Keeps the bins of two threads apart
+		char padding[64];
+	};
+
+	// TAGH or TAGM, used in the calibration file
+	std::string detectorName;
+	double defaultCenter;
+	double defaultWidth;
+	unsigned nCounters;
+	// Bins of the hit time histogram of a counter, over the global window
+	unsigned nBins;
+	// Index of this calibration in the per-thread lists of ThreadHits
+	unsigned instanceID;
+
+	// Current window of every counter
+	std::vector<std::atomic<double> > center;
+	std::vector<std::atomic<double> > width;
+
+	// All below is protected by foldMutex
+	mutable std::mutex foldMutex;
+	std::vector<std::unique_ptr<ThreadHits> > threadHits;
+	// Hit time histograms since the last update of every counter
+	std::vector<uint32_t> hitBins;
+	std::vector<uint32_t> nEntries;
+	// Number of times the window of the counter was updated
+	std::vector<uint32_t> nUpdates;
+	// Scratch space for the background estimate
+	std::vector<uint32_t> outsideBins;
+
+	// Number of hits in the global window before the window is updated
+	static unsigned entriesPerUpdate;
+	// Half-width of the window in standard deviations
+	static double nSigma;
+	// Narrowest half-width allowed in ns
+	static double minWidth;
+	// Width of the hit time bins in ns
+	static double binWidth;
+	// The window is reset if less of the signal than this is inside it
+	static double minInWindowFraction;
+
+	static std::atomic<unsigned> nInstances;
+
+	ThreadHits& getThreadHits() {
+		static thread_local std::vector<ThreadHits*> threadHitsByInstance;
+		if (instanceID < threadHitsByInstance.size()
+				&& threadHitsByInstance[instanceID] != nullptr)
+			return *threadHitsByInstance[instanceID];
+		ThreadHits& hits = registerThread();
+		threadHitsByInstance.resize(std::max<size_t>(threadHitsByInstance.size(),
+				instanceID + 1), nullptr);
+		threadHitsByInstance[instanceID] = &hits;
+		return hits;
+	}
+	virtual ThreadHits& registerThread();
+	virtual void updateWindow(unsigned counter);
+
+public:
+	TaggerTimeCalibration(std::string name, unsigned nCounters,
+			double centerValue, double widthValue);
+	virtual ~TaggerTimeCalibration() {
+	}
+
+	TaggerTimeCalibration(const TaggerTimeCalibration&) = delete;
+	TaggerTimeCalibration& operator=(const TaggerTimeCalibration&) = delete;
+
+	// Add a hit of the counter
+	void update(unsigned counter, double time) {
+		double position = time - (defaultCenter - defaultWidth);
+		if (counter >= nCounters || position < 0 || position >= 2 * defaultWidth)
+			return;
+		unsigned bin = std::min(unsigned(position / binWidth), nBins - 1);
+		getThreadHits().bins[counter * nBins + bin].fetch_add(1,
+				std::memory_order_relaxed);
+	}
+
+	// Add up the hits of all threads and update the windows that have enough
+	virtual void fold();
+
+	// True if the hit time is within the window of the counter
+	bool isMatched(unsigned counter, double time) const {
+		if (counter >= nCounters)
+			return std::fabs(time - defaultCenter) < defaultWidth;
+		return std::fabs(time - getCenter(counter)) < getWidth(counter);
+	}
+
+	// Start from the windows in the calibration file, false if it could not be read
+	virtual bool read(const std::string& fileName);
+	// Write the windows to the calibration file, appending if requested
+	virtual bool write(const std::string& fileName, bool append = false) const;
+
+	double getCenter(unsigned counter) const {
+		return counter < nCounters ?
+				center[counter].load(std::memory_order_relaxed) : defaultCenter;
+	}
+
+	double getWidth(unsigned counter) const {
+		return counter < nCounters ?
+				width[counter].load(std::memory_order_relaxed) : defaultWidth;
+	}
+
+	const std::string& getDetectorName() const {
+		return detectorName;
+	}
+
+	static void setEntriesPerUpdate(unsigned entries) {
+		entriesPerUpdate = entries < 2 ? 2 : entries;
+	}
+
+	static void setNSigma(double sigmas) {
+		nSigma = sigmas;
+	}
+
+	static void setMinWidth(double widthValue) {
+		minWidth = widthValue;
+	}
+};
+
+#endif /* TAGGERTIMECALIBRATION_H_ */
@@ -0,0 +1,11 @@
+/*
+ * TimedWriteLock.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include "TimedWriteLock.h"
+
+bool TimedWriteLock::timingEnabled = false;
+thread_local TimedWriteLock::Statistics TimedWriteLock::threadStatistics;
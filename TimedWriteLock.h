@@ -0,0 +1,71 @@
+/*
+ * TimedWriteLock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Scoped write lock on a pthread read-write lock (the ROOT lock of
+ *  DApplication) that can record how long each thread waited for the lock.
+ */
+
+#ifndef TIMEDWRITELOCK_H_
+#define TIMEDWRITELOCK_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <chrono>
+
+class TimedWriteLock {
+public:
+	// Lock statistics, kept separately for every thread
+	struct Statistics {
+		uint64_t nLocks = 0;
+		uint64_t waitNanoseconds = 0;
+	};
+
+protected:
+	pthread_rwlock_t& rwLock;
+
+	// Only measure the wait time if this is set
+	static bool timingEnabled;
+	static thread_local Statistics threadStatistics;
+
+public:
+	TimedWriteLock(pthread_rwlock_t& lock) :
+			rwLock(lock) {
+		if (!timingEnabled) {
+			pthread_rwlock_wrlock(&rwLock);
+			return;
+		}
+		auto start = std::chrono::steady_clock::now();
+		pthread_rwlock_wrlock(&rwLock);
+		threadStatistics.nLocks++;
+		threadStatistics.waitNanoseconds += std::chrono::duration_cast<
+				std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+	~TimedWriteLock() {
+		pthread_rwlock_unlock(&rwLock);
+	}
+
+	TimedWriteLock(const TimedWriteLock&) = delete;
+	TimedWriteLock& operator=(const TimedWriteLock&) = delete;
+
+	static void setTimingEnabled(bool enable) {
+		timingEnabled = enable;
+	}
+
+	static bool isTimingEnabled() {
+		return timingEnabled;
+	}
+
+	// Statistics of the calling thread
+	static const Statistics& getThreadStatistics() {
+		return threadStatistics;
+	}
+
+	static void resetThreadStatistics() {
+		threadStatistics = Statistics();
+	}
+};
+
+#endif /* TIMEDWRITELOCK_H_ */
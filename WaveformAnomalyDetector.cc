@@ -0,0 +1,188 @@
+/*
+ * WaveformAnomalyDetector.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "WaveformAnomalyDetector.h"
+
+using namespace std;
+
+// Number of samples at the start of the window used for the pedestal
+unsigned WaveformAnomalyDetector::nPedestalSamples = 8;
+// FADC250 overflow
+unsigned WaveformAnomalyDetector::saturationValue = 4095;
+// Height above the pedestal in counts for a peak
+double WaveformAnomalyDetector::peakThreshold = 50.0;
+// Chi2 per sample for a shape to be flagged
+double WaveformAnomalyDetector::maxChi2 = 3.0;
+// Noise used if the pedestal samples are quieter, in counts
+double WaveformAnomalyDetector::minNoise = 1.0;
+// Allowed difference from the reference as a fraction of the amplitude. The
+// average is wider than single pulses because of the time jitter.
+double WaveformAnomalyDetector::shapeTolerance = 0.05;
+
+// Number of partial sums kept in the loops below. Separate partial sums let
+// the compiler keep them in one vector register without -ffast-math.
+static const unsigned nLanes = 8;
+
+static float sumOfProducts(const float* a, const float* b, unsigned n) {
+	float lanes[nLanes] = { };
+	unsigned nFull = n - n % nLanes;
+	for (unsigned i = 0; i < nFull; i += nLanes)
+		for (unsigned lane = 0; lane < nLanes; lane++)
+			lanes[lane] += a[i + lane] * b[i + lane];
+	float sum = 0;
+	for (unsigned i = nFull; i < n; i++)
+		sum += a[i] * b[i];
+	for (unsigned lane = 0; lane < nLanes; lane++)
+		sum += lanes[lane];
+	return sum;
+}
+
+static float sumOfSquaredResiduals(const float* y, const float* r, float scale,
+		unsigned n) {
+	float lanes[nLanes] = { };
+	unsigned nFull = n - n % nLanes;
+	for (unsigned i = 0; i < nFull; i += nLanes)
+		for (unsigned lane = 0; lane < nLanes; lane++) {
+			float residual = y[i + lane] - scale * r[i + lane];
+			lanes[lane] += residual * residual;
+		}
+	float sum = 0;
+	for (unsigned i = nFull; i < n; i++) {
+		float residual = y[i] - scale * r[i];
+		sum += residual * residual;
+	}
+	for (unsigned lane = 0; lane < nLanes; lane++)
+		sum += lanes[lane];
+	return sum;
+}
+
+// Position of the peak between samples from a parabola through the highest
+// sample and its neighbours
+template<typename T>
+static double interpolatePeak(const T* values, unsigned nValues, unsigned peak) {
+	if (peak == 0 || peak + 1 >= nValues)
+		return peak;
+	double curvature = double(values[peak - 1]) - 2.0 * values[peak]
+			+ values[peak + 1];
+	if (curvature >= 0)
+		return peak;
+	return peak + 0.5 * (double(values[peak - 1]) - values[peak + 1]) / curvature;
+}
+
+bool WaveformAnomalyDetector::setReference(const vector<double>& averageWaveform) {
+	unsigned nSamples = min<size_t>(averageWaveform.size(), maxSamples);
+	if (nSamples <= nPedestalSamples + 2)
+		return false;
+	double pedestal = 0;
+	for (unsigned iSample = 0; iSample < nPedestalSamples; iSample++)
+		pedestal += averageWaveform[iSample];
+	pedestal /= nPedestalSamples;
+	unsigned peakSample = distance(averageWaveform.begin(),
+			max_element(averageWaveform.begin(), averageWaveform.begin() + nSamples));
+	double height = averageWaveform[peakSample] - pedestal;
+	if (height < peakThreshold)
+		return false;
+
+	shared_ptr<Reference> reference = make_shared<Reference>();
+	reference->peakPosition = interpolatePeak(averageWaveform.data(), nSamples,
+			peakSample);
+	reference->shape.resize(nSamples);
+	for (unsigned iSample = 0; iSample < nSamples; iSample++)
+		reference->shape[iSample] = (averageWaveform[iSample] - pedestal) / height;
+	atomic_store(&currentReference,
+			shared_ptr<const Reference>(std::move(reference)));
+	return true;
+}
+
+bool WaveformAnomalyDetector::check(const vector<uint16_t>& samples,
+		Result& result) const {
+	result = Result();
+	unsigned nSamples = min<size_t>(samples.size(), maxSamples);
+	if (nSamples <= nPedestalSamples + 2)
+		return false;
+
+	// Pedestal and noise from the first samples
+	double pedestal = 0, pedestalSquares = 0;
+	for (unsigned iSample = 0; iSample < nPedestalSamples; iSample++) {
+		pedestal += samples[iSample];
+		pedestalSquares += double(samples[iSample]) * samples[iSample];
+	}
+	pedestal /= nPedestalSamples;
+	double noiseSquared = max(pedestalSquares / nPedestalSamples - pedestal * pedestal,
+			minNoise * minNoise);
+
+	float y[maxSamples];
+	const uint16_t* input = samples.data();
+	float pedestalValue = pedestal;
+	for (unsigned iSample = 0; iSample < nSamples; iSample++)
+		y[iSample] = float(input[iSample]) - pedestalValue;
+	unsigned peakSample = distance(y, max_element(y, y + nSamples));
+	result.amplitude = y[peakSample];
+	if (input[peakSample] >= saturationValue)
+		result.flags |= SATURATED;
+
+	// Count the peaks: a peak starts when the waveform rises by peakThreshold
+	// above the lowest point since the last peak and ends when it drops by
+	// peakThreshold below the highest point of the peak
+	float threshold = peakThreshold;
+	float low = 0, high = 0;
+	bool inPeak = false;
+	for (unsigned iSample = 0; iSample < nSamples; iSample++) {
+		float value = y[iSample];
+		if (!inPeak) {
+			if (value - low >= threshold) {
+				result.nPeaks++;
+				inPeak = true;
+				high = value;
+			} else if (value < low) {
+				low = value;
+			}
+		} else if (value > high) {
+			high = value;
+		} else if (high - value >= threshold) {
+			inPeak = false;
+			low = value;
+		}
+	}
+	if (result.nPeaks > 1)
+		result.flags |= PILEUP;
+
+	// Compare the shape of clean single pulses with the reference
+	shared_ptr<const Reference> reference = atomic_load(&currentReference);
+	if (reference && result.flags == 0 && result.nPeaks == 1) {
+		// Reference moved to the peak of the waveform by linear interpolation
+		double shift = interpolatePeak(y, nSamples, peakSample)
+				- reference->peakPosition;
+		int shiftSamples = int(floor(shift));
+		float fraction = shift - shiftSamples;
+		int nReference = reference->shape.size();
+		int first = max(0, shiftSamples + 1);
+		int last = min<int>(nSamples, nReference + shiftSamples);
+		if (last - first > 2) {
+			const float* shape = reference->shape.data() - shiftSamples;
+			float r[maxSamples];
+			for (int iSample = first; iSample < last; iSample++)
+				r[iSample] = (1.0f - fraction) * shape[iSample]
+						+ fraction * shape[iSample - 1];
+			unsigned nPoints = last - first;
+			float sumYR = sumOfProducts(y + first, r + first, nPoints);
+			float sumRR = sumOfProducts(r + first, r + first, nPoints);
+			float scale = sumRR > 0 ? sumYR / sumRR : 0;
+			float sumResiduals = sumOfSquaredResiduals(y + first, r + first, scale,
+					nPoints);
+			double tolerance = shapeTolerance * result.amplitude;
+			result.chi2 = sumResiduals
+					/ ((noiseSquared + tolerance * tolerance) * nPoints);
+			if (result.chi2 > maxChi2)
+				result.flags |= SHAPE;
+		}
+	}
+	return result.flags != 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * WaveformAnomalyDetector.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Tells the TAC waveforms worth keeping from the ordinary ones. A waveform is
+ *  flagged if it reaches the FADC overflow, if it has more than one peak
+ *  (pile-up) or if its shape is far from the average waveform. For the shape
+ *  check the pedestal-subtracted waveform is scaled to the reference by least
+ *  squares and the chi2 per sample is computed with the noise of the pedestal
+ *  samples plus a tolerance proportional to the amplitude. The sums run over
+ *  plain float arrays in eight partial sums so that the compiler turns them
+ *  into SIMD code.
+ */
+
+#ifndef WAVEFORMANOMALYDETECTOR_H_
+#define WAVEFORMANOMALYDETECTOR_H_
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <stdint.h>
+
+class WaveformAnomalyDetector {
+public:
+	enum Flag : uint32_t {
+		SATURATED = 1 << 0,
+		PILEUP = 1 << 1,
+		SHAPE = 1 << 2
+	};
+
+	struct Result {
+		// Combination of the Flag bits, 0 for an ordinary waveform
+		uint32_t flags = 0;
+		// Chi2 per sample with respect to the reference, 0 if not computed
+		double chi2 = 0;
+		// Peak height above the pedestal
+		double amplitude = 0;
+		// Number of peaks found
+		unsigned nPeaks = 0;
+	};
+
+	// Longest waveform checked, longer ones are cut
+	static const unsigned maxSamples = 256;
+
+protected:
+	struct Reference {
+		// Pedestal-subtracted average waveform normalized to a unit peak
+		std::vector<float> shape;
+		// Peak position between the samples
+		double peakPosition = 0;
+	};
+
+	// Number of samples at the start used for the pedestal and the noise
+	static unsigned nPedestalSamples;
+	// Sample value that means the FADC overflowed
+	static unsigned saturationValue;
+	// Height above the pedestal a peak needs, and the drop between two peaks
+	static double peakThreshold;
+	// Chi2 per sample above which the shape is flagged
+	static double maxChi2;
+	// Lowest noise used for the chi2, in counts
+	static double minNoise;
+	// Difference from the reference allowed on top of the noise, as a
+	// fraction of the amplitude
+	static double shapeTolerance;
+
+	std::shared_ptr<const Reference> currentReference;
+
+public:
+	WaveformAnomalyDetector() {
+	}
+	virtual ~WaveformAnomalyDetector() {
+	}
+
+	// Use the average waveform as the reference shape. Returns false and keeps
+	// the old reference if the average has no clear pulse.
+	virtual bool setReference(const std::vector<double>& averageWaveform);
+
+	// Check the waveform, returns true if it is flagged
+	virtual bool check(const std::vector<uint16_t>& samples, Result& result) const;
+
+	bool hasReference() const {
+		return std::atomic_load(&currentReference) != nullptr;
+	}
+
+	static unsigned getSaturationValue() {
+		return saturationValue;
+	}
+
+	static void setSaturationValue(unsigned value) {
+		saturationValue = value;
+	}
+
+	static double getPeakThreshold() {
+		return peakThreshold;
+	}
+
+	static void setPeakThreshold(double threshold) {
+		peakThreshold = threshold;
+	}
+
+	static double getMaxChi2() {
+		return maxChi2;
+	}
+
+	static void setMaxChi2(double chi2) {
+		maxChi2 = chi2;
+	}
+};
+
+#endif /* WAVEFORMANOMALYDETECTOR_H_ */
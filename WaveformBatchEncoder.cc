@@ -0,0 +1,92 @@
+/*
+ * WaveformBatchEncoder.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <cstring>
+
+#include "WaveformBatchEncoder.h"
+#include "DataKernels.h"
+#include "data.h"
+
+using namespace std;
+
+WaveformBatchEncoder::WaveformBatchEncoder(unsigned size) {
+	setBatchSize(size);
+}
+
+void WaveformBatchEncoder::encode(const vector<const vector<uint16_t>*>& waveforms,
+		vector<vector<char> >& records) {
+	records.resize(waveforms.size());
+	size_t iWaveform = 0;
+	while (iWaveform < waveforms.size()) {
+		size_t nSamples = waveforms[iWaveform]->size();
+		size_t nWaveforms = 1;
+		while (nWaveforms < batchSize && iWaveform + nWaveforms < waveforms.size()
+				&& waveforms[iWaveform + nWaveforms]->size() == nSamples)
+			nWaveforms++;
+		// The indices of the non-zero range are 16-bit
+		if (nSamples == 0 || nSamples >= 0xFFFF || nWaveforms == 1)
+			encodeSingle(*waveforms[iWaveform], records[iWaveform]);
+		else
+			encodeTile(&waveforms[iWaveform], nWaveforms, nSamples, &records[iWaveform]);
+		iWaveform += nSamples == 0 || nSamples >= 0xFFFF ? 1 : nWaveforms;
+	}
+}
+
+void WaveformBatchEncoder::encodeTile(const vector<uint16_t>* const * waveforms,
+		unsigned nWaveforms, size_t nSamples, vector<char>* records) {
+	// Lanes past the last waveform repeat it, they are not used
+	size_t nLanes = batchSize;
+	size_t nPairs = nSamples / 2;
+	samplePointers.resize(nWaveforms);
+	for (unsigned lane = 0; lane < nWaveforms; lane++)
+		samplePointers[lane] = waveforms[lane]->data();
+	tile.resize(nSamples * nLanes);
+	DataKernels::fillTile(samplePointers.data(), nWaveforms, nSamples, nLanes, tile.data());
+	minimums.resize(nLanes);
+	nibbles.resize(nPairs * nLanes);
+	highBytes.resize(nSamples * nLanes);
+	first.resize(nLanes);
+	last.resize(nLanes);
+	DataKernels::packTile(tile.data(), nSamples, nLanes, minimums.data(),
+			nibbles.data(), highBytes.data(), first.data(), last.data());
+	// Back to one row of bytes per waveform
+	waveformNibbles.resize(nPairs * nWaveforms);
+	waveformHighBytes.resize(nSamples * nWaveforms);
+	DataKernels::readTile(nibbles.data(), nPairs, nLanes, nWaveforms, waveformNibbles.data());
+	DataKernels::readTile(highBytes.data(), nSamples, nLanes, nWaveforms, waveformHighBytes.data());
+
+	// The record layout of data::data::encode()
+	size_t header = 2 + nPairs;
+	for (unsigned lane = 0; lane < nWaveforms; lane++) {
+		int startByte = first[lane], endByte = last[lane];
+		if (first[lane] == 0xFFFF) {
+			startByte = 0;
+			endByte = nSamples - 1;
+		}
+		vector<char>& record = records[lane];
+		record.resize(header + 2 + endByte - startByte + 1);
+		memcpy(&record[0], &minimums[lane], sizeof(uint16_t));
+		// A single sample has no nibble pairs
+		if (nPairs > 0)
+			memcpy(&record[2], &waveformNibbles[lane * nPairs], nPairs);
+		record[header] = startByte - 1;
+		record[header + 1] = endByte - startByte + 1;
+		memcpy(&record[header + 2], &waveformHighBytes[lane * nSamples + startByte],
+				endByte - startByte + 1);
+	}
+}
+
+void WaveformBatchEncoder::encodeSingle(const vector<uint16_t>& waveform,
+		vector<char>& record) {
+	record.clear();
+	if (waveform.empty())
+		return;
+	static thread_local vector<int> intSamples;
+	intSamples.assign(waveform.begin(), waveform.end());
+	data::data encoder;
+	encoder.encode(intSamples, record);
+}
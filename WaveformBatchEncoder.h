@@ -0,0 +1,68 @@
+/*
+ * WaveformBatchEncoder.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Batch form of data::data::encode(). Waveforms of the same length are
+ *  transposed, batchSize at a time, into a tile with one waveform per vector
+ *  lane, and DataKernels::packTile() finds the minimums, splits and packs the
+ *  samples of all of them at once. The packed bytes are transposed back with
+ *  DataKernels::readTile(). Every waveform still gets its own record,
+ *  the same bytes as data::data::encode() gives for it.
+ */
+
+#ifndef WAVEFORMBATCHENCODER_H_
+#define WAVEFORMBATCHENCODER_H_
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+class WaveformBatchEncoder {
+protected:
+	// Waveforms per tile, a multiple of 8
+	unsigned batchSize;
+
+	// The tile and the kernel outputs, kept from batch to batch
+	std::vector<const uint16_t*> samplePointers;
+	std::vector<uint16_t> tile;
+	std::vector<uint16_t> minimums;
+	std::vector<uint8_t> nibbles;
+	std::vector<uint8_t> highBytes;
+	std::vector<uint16_t> first;
+	std::vector<uint16_t> last;
+	std::vector<uint8_t> waveformNibbles;
+	std::vector<uint8_t> waveformHighBytes;
+
+	// Encode nWaveforms <= batchSize waveforms of nSamples samples
+	virtual void encodeTile(const std::vector<uint16_t>* const * waveforms,
+			unsigned nWaveforms, size_t nSamples, std::vector<char>* records);
+	// A waveform that does not fit in a tile
+	virtual void encodeSingle(const std::vector<uint16_t>& waveform,
+			std::vector<char>& record);
+
+public:
+	WaveformBatchEncoder(unsigned size = 32);
+	virtual ~WaveformBatchEncoder() {
+	}
+
+	WaveformBatchEncoder(const WaveformBatchEncoder&) = delete;
+	WaveformBatchEncoder& operator=(const WaveformBatchEncoder&) = delete;
+
+	// records[i] becomes the record of waveforms[i]. Consecutive waveforms of
+	// the same length share tiles, the others are encoded one by one.
+	virtual void encode(const std::vector<const std::vector<uint16_t>*>& waveforms,
+			std::vector<std::vector<char> >& records);
+
+	unsigned getBatchSize() const {
+		return batchSize;
+	}
+
+	// Rounded up to a multiple of 8
+	void setBatchSize(unsigned size) {
+		batchSize = size < 8 ? 8 : (size + 7) / 8 * 8;
+	}
+};
+
+#endif /* WAVEFORMBATCHENCODER_H_ */
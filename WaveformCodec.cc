@@ -0,0 +1,178 @@
+/*
+ * WaveformCodec.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  The registry and the codecs that come with the plugin.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "WaveformCodec.h"
+#include "TACFeatureFormat.h"
+#include "RiceCoding.h"
+#include "data.h"
+
+using namespace std;
+
+map<string, WaveformCodec::Factory>& WaveformCodec::getRegistry() {
+	// Built on first use, the registrars of other files may run before this one
+	static map<string, Factory> registry;
+	return registry;
+}
+
+void WaveformCodec::registerCodec(const string& name, Factory factory) {
+	getRegistry()[name] = factory;
+}
+
+WaveformCodec* WaveformCodec::create(const string& name) {
+	auto codecIter = getRegistry().find(name);
+	if (codecIter == getRegistry().end())
+		return nullptr;
+	return codecIter->second();
+}
+
+vector<string> WaveformCodec::getCodecNames() {
+	vector<string> names;
+	for (auto& codecIter : getRegistry())
+		names.push_back(codecIter.first);
+	return names;
+}
+
+namespace {
+
+// The samples as they come, two bytes each
+class RawCodec: public WaveformCodec {
+public:
+	RawCodec() :
+			WaveformCodec("raw") {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		dest.resize(2 * samples.size());
+		if (!samples.empty())
+			memcpy(dest.data(), samples.data(), dest.size());
+	}
+};
+
+// The samples as text, one line per waveform
+class AsciiCodec: public WaveformCodec {
+public:
+	AsciiCodec() :
+			WaveformCodec("ascii") {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		dest.clear();
+		char field[16];
+		for (unsigned iSample = 0; iSample < samples.size(); iSample++) {
+			int length = snprintf(field, sizeof(field),
+					iSample < samples.size() - 1 ? "%5u , " : "%5u",
+					unsigned(samples[iSample]));
+			dest.insert(dest.end(), field, field + length);
+		}
+		dest.push_back('\n');
+	}
+};
+
+// The pedestal and nibble codecs of data::data
+class NibbleCodec: public WaveformCodec {
+protected:
+	bool lossy;
+
+public:
+	NibbleCodec(bool isLossy) :
+			WaveformCodec(isLossy ? "nibble_lossy" : "nibble"), lossy(isLossy) {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		static thread_local vector<int> intSamples;
+		intSamples.assign(samples.begin(), samples.end());
+		data::data encoder;
+		if (lossy)
+			encoder.encodeLossy(intSamples, dest);
+		else
+			encoder.encode(intSamples, dest);
+	}
+};
+
+// The first sample and the zigzag differences of the following ones as varints
+class DeltaVarintCodec: public WaveformCodec {
+public:
+	DeltaVarintCodec() :
+			WaveformCodec("delta_varint") {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		dest.clear();
+		int64_t previous = 0;
+		for (auto sample : samples) {
+			int64_t delta = int64_t(sample) - previous;
+			TACFeatureFormat::putVarint(dest, (uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+			previous = sample;
+		}
+	}
+};
+
+// The zigzag differences Golomb-Rice coded, with the parameter chosen per
+// waveform from the mean difference. The first byte is the parameter, the
+// first sample follows in two bytes.
+class DeltaRiceCodec: public WaveformCodec {
+public:
+	DeltaRiceCodec() :
+			WaveformCodec("delta_rice") {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		dest.clear();
+		if (samples.empty())
+			return;
+		static thread_local vector<uint32_t> zigzag;
+		zigzag.resize(samples.size() - 1);
+		uint64_t sum = 0;
+		for (unsigned iSample = 1; iSample < samples.size(); iSample++) {
+			zigzag[iSample - 1] = RiceCoding::zigzag(
+					int32_t(samples[iSample]) - int32_t(samples[iSample - 1]));
+			sum += zigzag[iSample - 1];
+		}
+		unsigned k = RiceCoding::getParameter(sum, zigzag.size());
+		dest.push_back(char(k));
+		dest.push_back(char(samples[0] & 0xFF));
+		dest.push_back(char(samples[0] >> 8));
+		RiceCoding::BitWriter writer(dest);
+		for (auto value : zigzag)
+			writer.putRice(value, k);
+		writer.flush();
+	}
+};
+
+#ifdef HAVE_ZLIB
+// zlib deflate of the raw samples, for comparison with a general-purpose compressor
+class ZlibCodec: public WaveformCodec {
+public:
+	ZlibCodec() :
+			WaveformCodec("zlib") {
+	}
+	virtual void encode(const vector<uint16_t>& samples, vector<char>& dest) const {
+		uLong rawSize = 2 * samples.size();
+		uLongf encodedSize = compressBound(rawSize);
+		dest.resize(encodedSize);
+		if (compress2(reinterpret_cast<Bytef*>(dest.data()), &encodedSize,
+				reinterpret_cast<const Bytef*>(samples.data()), rawSize, 6) != Z_OK)
+			encodedSize = 0;
+		dest.resize(encodedSize);
+	}
+};
+
+WaveformCodec::Registrar zlibRegistrar("zlib", []() {return new ZlibCodec();});
+#endif
+
+WaveformCodec::Registrar rawRegistrar("raw", []() {return new RawCodec();});
+WaveformCodec::Registrar asciiRegistrar("ascii", []() {return new AsciiCodec();});
+WaveformCodec::Registrar nibbleRegistrar("nibble", []() {return new NibbleCodec(false);});
+WaveformCodec::Registrar nibbleLossyRegistrar("nibble_lossy", []() {return new NibbleCodec(true);});
+WaveformCodec::Registrar deltaVarintRegistrar("delta_varint", []() {return new DeltaVarintCodec();});
+WaveformCodec::Registrar deltaRiceRegistrar("delta_rice", []() {return new DeltaRiceCodec();});
+
+}
@@ -0,0 +1,65 @@
+/*
+ * WaveformCodec.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Interface of the waveform compression codecs compared by
+ *  CompressionTester, and the registry they are created from by name. A codec
+ *  registers itself with a static WaveformCodec::Registrar in its source file,
+ *  so a new one needs no change anywhere else.
+ */
+
+#ifndef WAVEFORMCODEC_H_
+#define WAVEFORMCODEC_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <stdint.h>
+
+class WaveformCodec {
+public:
+	typedef std::function<WaveformCodec*()> Factory;
+
+	// Registers a codec when a static instance of it is constructed
+	class Registrar {
+	public:
+		Registrar(const std::string& name, Factory factory) {
+			WaveformCodec::registerCodec(name, factory);
+		}
+	};
+
+protected:
+	std::string name;
+
+	static std::map<std::string, Factory>& getRegistry();
+
+public:
+	WaveformCodec(const std::string& codecName) :
+			name(codecName) {
+	}
+	virtual ~WaveformCodec() {
+	}
+
+	WaveformCodec(const WaveformCodec&) = delete;
+	WaveformCodec& operator=(const WaveformCodec&) = delete;
+
+	// Replace the content of dest with the encoded samples. Called by any
+	// number of threads at the same time.
+	virtual void encode(const std::vector<uint16_t>& samples,
+			std::vector<char>& dest) const = 0;
+
+	const std::string& getName() const {
+		return name;
+	}
+
+	static void registerCodec(const std::string& name, Factory factory);
+	// New codec of that name, nullptr if there is no such codec
+	static WaveformCodec* create(const std::string& name);
+	// Names of all registered codecs in alphabetical order
+	static std::vector<std::string> getCodecNames();
+};
+
+#endif /* WAVEFORMCODEC_H_ */
@@ -0,0 +1,93 @@
+/*
+ * WaveformRing.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "WaveformRing.h"
+
+using namespace std;
+
+atomic<uint64_t> WaveformRing::nextInstanceId(1);
+
+// Ring of the current thread for the WaveformRing it was created for
+struct ThreadRingCache {
+	uint64_t instanceId = 0;
+	void* ring = nullptr;
+};
+static thread_local ThreadRingCache threadRingCache;
+
+WaveformRing::WaveformRing(unsigned nSlots) :
+		ringSize(nSlots < 1 ? 1 : nSlots), instanceId(nextInstanceId++) {
+}
+
+WaveformRing::ThreadRing* WaveformRing::getThreadRing() {
+	if (threadRingCache.instanceId == instanceId)
+		return static_cast<ThreadRing*>(threadRingCache.ring);
+	// First record from this thread, the rings live as long as this object
+	unique_ptr<ThreadRing> ring(new ThreadRing());
+	ring->slots.reset(new Slot[ringSize]);
+	ThreadRing* ringPointer = ring.get();
+	{
+		lock_guard<mutex> registryGuard(registryMutex);
+		rings.push_back(std::move(ring));
+	}
+	threadRingCache.instanceId = instanceId;
+	threadRingCache.ring = ringPointer;
+	return ringPointer;
+}
+
+void WaveformRing::push(const TACEventData& eventData,
+		const TACEventSummary& summary) {
+	ThreadRing* ring = getThreadRing();
+	uint64_t nWritten = ring->nWritten.load(memory_order_relaxed);
+	Slot& slot = ring->slots[nWritten % ringSize];
+
+	// Odd sequence while the slot is written
+	uint32_t sequence = slot.sequence.load(memory_order_relaxed);
+	slot.sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	Record& record = slot.record;
+	record.runNumber = eventData.runNumber;
+	record.triggerMask = eventData.triggerMask;
+	record.eventNumber = eventData.eventNumber;
+	record.summary = summary;
+	record.nSamples = min<size_t>(eventData.samples.size(), maxSamples);
+	memcpy(record.samples, eventData.samples.data(),
+			record.nSamples * sizeof(uint16_t));
+
+	slot.sequence.store(sequence + 2, memory_order_release);
+	ring->nWritten.store(nWritten + 1, memory_order_release);
+}
+
+size_t WaveformRing::snapshot(vector<Record>& records, size_t maxRecords) const {
+	records.clear();
+	lock_guard<mutex> registryGuard(registryMutex);
+	for (auto& ring : rings) {
+		uint64_t nWritten = ring->nWritten.load(memory_order_acquire);
+		uint64_t first = nWritten > ringSize ? nWritten - ringSize : 0;
+		for (uint64_t iRecord = first; iRecord < nWritten; iRecord++) {
+			const Slot& slot = ring->slots[iRecord % ringSize];
+			uint32_t sequenceBefore = slot.sequence.load(memory_order_acquire);
+			if (sequenceBefore & 1)
+				continue;
+			records.push_back(slot.record);
+			atomic_thread_fence(memory_order_acquire);
+			// The writer came around while the record was copied
+			if (slot.sequence.load(memory_order_relaxed) != sequenceBefore)
+				records.pop_back();
+		}
+	}
+	sort(records.begin(), records.end(),
+			[](const Record& first, const Record& second) {
+				return first.isNewerThan(second);
+			});
+	if (maxRecords > 0 && records.size() > maxRecords)
+		records.resize(maxRecords);
+	return records.size();
+}
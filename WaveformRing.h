@@ -0,0 +1,94 @@
+/*
+ * WaveformRing.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  The last waveforms of the TAC with their features, kept in one ring per
+ *  event thread. Only the owning thread writes to a ring, so writing never
+ *  waits: every slot is guarded by a sequence counter that is odd while the
+ *  slot is written (a seqlock). A reader copies the slots and drops the ones
+ *  whose sequence changed during the copy, which gives a consistent set of
+ *  records without stopping the writers.
+ */
+
+#ifndef WAVEFORMRING_H_
+#define WAVEFORMRING_H_
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+#include "TACEventData.h"
+
+class WaveformRing {
+public:
+	// Longest waveform kept, longer ones are cut
+	static const unsigned maxSamples = 128;
+
+	struct Record {
+		int32_t runNumber = 0;
+		uint32_t triggerMask = 0;
+		uint64_t eventNumber = 0;
+		TACEventSummary summary;
+		uint32_t nSamples = 0;
+		uint16_t samples[maxSamples];
+
+		// Order by run and event number
+		bool isNewerThan(const Record& other) const {
+			if (runNumber != other.runNumber)
+				return runNumber > other.runNumber;
+			return eventNumber > other.eventNumber;
+		}
+	};
+
+protected:
+	// The slots of a thread are in their own allocation, threads do not share them
+	struct Slot {
+		std::atomic<uint32_t> sequence { 0 };
+		Record record;
+	};
+
+	struct ThreadRing {
+		std::unique_ptr<Slot[]> slots;
+		// Number of records written so far
+		std::atomic<uint64_t> nWritten { 0 };
+	};
+
+	// Number of slots in every thread ring
+	unsigned ringSize;
+	// Tells the rings of different WaveformRing objects apart in the thread cache
+	uint64_t instanceId;
+
+	// Protects the list of rings. Writers only take it when they register.
+	mutable std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadRing> > rings;
+
+	static std::atomic<uint64_t> nextInstanceId;
+
+	// Ring of the calling thread, created on the first call
+	ThreadRing* getThreadRing();
+
+public:
+	WaveformRing(unsigned nSlots = 64);
+	virtual ~WaveformRing() {
+	}
+
+	WaveformRing(const WaveformRing&) = delete;
+	WaveformRing& operator=(const WaveformRing&) = delete;
+
+	// Add the waveform of the event to the ring of the calling thread
+	void push(const TACEventData& eventData, const TACEventSummary& summary);
+
+	// Copy the consistent records of all rings, the newest first. At most
+	// maxRecords records are returned if it is not 0.
+	size_t snapshot(std::vector<Record>& records, size_t maxRecords = 0) const;
+
+	unsigned getRingSize() const {
+		return ringSize;
+	}
+};
+
+#endif /* WAVEFORMRING_H_ */
@@ -4,7 +4,10 @@
  * and open the template in the editor.
  */
 
+#include <cstring>
+
 #include "data.h"
+#include "DataKernels.h"
 
 
 namespace data {
@@ -25,11 +28,7 @@ namespace data {
   }
 
   int data::getMinimum(const std::vector<int> &vec){
-    int min = vec[0];
-    for(int i = 1; i < vec.size(); i++){
-      if(vec[i]<min) min = vec[i];
-    }
-    return min;
+    return DataKernels::getMinimum(&vec[0], vec.size());
   }
 
   std::vector<int> data::getSubtracted(const std::vector<int> &vec){
@@ -100,46 +99,25 @@ namespace data {
   }
 
   void data::encode(std::vector<int> &pulse, std::vector<char> &dest){
-
-      std::vector<uint16_t> low;
-      std::vector<uint16_t> high;
-
-      decompose(pulse,low,high);
-
-      int minimum = pulse[0];
-      for(int i = 1; i < pulse.size(); i++){
-        if(pulse[i]<minimum) minimum = pulse[i];
-      }
-      dest.clear();
-      dest.resize(2 + low.size()/2, 0);
-      uint16_t *ped = reinterpret_cast<uint16_t *> (&dest[0]);
-      *ped = minimum;
-      for(int i = 0; i < low.size(); i++){
-         int   index = 2 + i/2;
-         int   order = i%2;
-         char  value = dest[index];
-         char  ibyte = low[i];
-         //printf("value before %X  %d %d\n", (unsigned int) value, order, low[i]);
-         if(order==0){
-           value = (value|(ibyte&0x000F));
-         } else {
-           value = (value|((ibyte&0x000F)<<4));
-         }
-         //printf("value after %X\n", (unsigned int) value);
-         //printf("\n");
-         dest[index] = value;
-      }
-
-      int start_byte = 0;
-      int   end_byte = high.size() - 1;
-      for(int i = 0; i < high.size(); i++) if(high[i]!=0){ start_byte = i; break;};
-      for(int i = high.size()-1; i >= 0; i--) if(high[i]!=0) { end_byte = i; break;};
+      // The bytes of the nibble packing of decompose(), made by the vector
+      // kernels. The high parts are written behind the nibbles and the
+      // range between the first and the last non-zero one is moved down.
+      int n = pulse.size();
+      int minimum = DataKernels::getMinimum(&pulse[0], n);
+      int header = 2 + n/2;
+      dest.resize(header + 2 + n);
+      uint16_t ped = minimum;
+      memcpy(&dest[0], &ped, sizeof(ped));
+      int start_byte, end_byte;
+      DataKernels::pack(&pulse[0], n, minimum, &dest[2], &dest[header + 2],
+          start_byte, end_byte);
+      if(start_byte < 0){ start_byte = 0; end_byte = n - 1; }
       //printf(" array range = %d %d\n",start_byte, end_byte);
-      dest.push_back(start_byte-1);
-      dest.push_back(end_byte - start_byte + 1);
-      for(int i = start_byte; i <= end_byte; i++){
-        dest.push_back(high[i]);
-      }
+      dest[header] = start_byte - 1;
+      dest[header + 1] = end_byte - start_byte + 1;
+      memmove(&dest[header + 2], &dest[header + 2 + start_byte],
+          end_byte - start_byte + 1);
+      dest.resize(header + 2 + end_byte - start_byte + 1);
   }
 
   void data::encodeLossy(std::vector<int> &pulse, std::vector<char> &dest){
@@ -201,33 +179,13 @@ namespace data {
 
   void data::decompose(std::vector<int> &pulse, std::vector<uint16_t> &low,
     std::vector<uint16_t> &high){
-      int minimum = pulse[0];
-      for(int i = 1; i < pulse.size(); i++){
-        if(pulse[i]<minimum) minimum = pulse[i];
-      }
+      // The running sum of the samples minus the minimum, differenced again,
+      // is the samples minus the minimum modulo 2^16: the kernels split
+      // those directly.
+      int minimum = DataKernels::getMinimum(&pulse[0], pulse.size());
       low.resize(pulse.size());
       high.resize(pulse.size());
-      low[0]  = pulse[0] - minimum;
-      //high[0] = pulse[0] - minimum;
-      int integral = 0;
-      for(int i = 1; i < pulse.size(); i++){
-        int value = pulse[i] - minimum;
-        low[i] = low[i-1] + value;
-      }
-      //printf(" REIMAN = ");
-      //print(low);
-      high[0] = low[0];
-      for(int i = 1; i < pulse.size(); i++){
-        high[i] = low[i] - low[i-1];
-      }
-      //printf(" SEQUENCE = ");
-      //print(high);
-
-      for(int i = 0 ; i < pulse.size(); i++){
-        uint16_t value = high[i];
-        high[i] = (value&0x1FF0)>>4;
-        low[i]  = value&0x000F;
-      }
+      DataKernels::split(&pulse[0], pulse.size(), minimum, &low[0], &high[0]);
   }
 
   void data::getVector(std::vector<int> &pulse, std::vector<char> &encoded){
@@ -0,0 +1,220 @@
+/*
+ * TACDisplay.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "TH2.h"
+#include "TList.h"
+#include "TPad.h"
+#include "TROOT.h"
+
+#include "TACDisplay.h"
+
+using namespace std;
+
+TACDisplayPage::~TACDisplayPage() {
+	for (auto& item : padItems) {
+		if (item.display != nullptr)
+			delete item.display;
+	}
+}
+
+// The RootSpy client keeps the TAC directory between refreshes, the lookup is
+// only repeated when the current directory changes or the cached one is gone.
+TDirectory* TACDisplayPage::findDirectory() {
+	if (cachedDir != nullptr && cachedParentDir == gDirectory
+			&& gDirectory->GetList()->FindObject(cachedDir) != nullptr)
+		return cachedDir;
+	cachedParentDir = gDirectory;
+	cachedDir = dynamic_cast<TDirectory*>(gDirectory->FindObjectAny("TAC"));
+	return cachedDir;
+}
+
+// A pointer comparison in the directory list is enough to validate the cached
+// histogram. The name lookup is only done when RootSpy has replaced the object.
+TH1* TACDisplayPage::findSource(TDirectory* dir, PadItem& item) {
+	if (item.source != nullptr && dir->GetList()->FindObject(item.source) != nullptr)
+		return item.source;
+	TObject* object = dir->GetList()->FindObject(item.histName.c_str());
+	if (object == nullptr)
+		object = dir->FindObjectAny(item.histName.c_str());
+	item.source = dynamic_cast<TH1*>(object);
+	return item.source;
+}
+
+static bool sameAxis(const TAxis* first, const TAxis* second) {
+	return first->GetNbins() == second->GetNbins()
+			&& first->GetXmin() == second->GetXmin()
+			&& first->GetXmax() == second->GetXmax();
+}
+
+// Returns true if a new display copy had to be created.
+bool TACDisplayPage::updateDisplay(PadItem& item) {
+	TH1* source = item.source;
+	TH1* display = item.display;
+	if (display != nullptr && display->GetDimension() == source->GetDimension()
+			&& sameAxis(display->GetXaxis(), source->GetXaxis())
+			&& (source->GetDimension() < 2
+					|| sameAxis(display->GetYaxis(), source->GetYaxis()))) {
+		display->Reset();
+		display->Add(source);
+		if (strcmp(display->GetTitle(), source->GetTitle()) != 0)
+			display->SetTitle(source->GetTitle());
+		return false;
+	}
+
+	// Binning changed or this is the first time we see the histogram
+	if (display != nullptr)
+		delete display;
+	Bool_t addStatus = TH1::AddDirectoryStatus();
+	TH1::AddDirectory(false);
+	string displayName = item.histName + "_display";
+	item.display = dynamic_cast<TH1*>(source->Clone(displayName.c_str()));
+	TH1::AddDirectory(addStatus);
+	item.display->SetDirectory(nullptr);
+	applyStyle(item.display);
+	return true;
+}
+
+void TACDisplayPage::applyStyle(TH1* histo) {
+	if (dynamic_cast<TH2*>(histo) == nullptr) {
+		histo->SetBarWidth(0.5);
+		histo->SetBarOffset(0);
+		histo->SetFillColor(kGreen);
+		histo->SetMinimum(0.0);
+	}
+	histo->SetStats(0);
+	histo->SetTitleSize(0.05, "X");
+	histo->GetXaxis()->CenterTitle();
+	histo->SetTitleSize(0.05, "Y");
+	histo->GetYaxis()->CenterTitle();
+}
+
+// Other RootSpy pages share the canvas and clear it, so check that each pad
+// still holds our display copy. The pads are looked up by number because the
+// pad objects themselves are deleted when the canvas is cleared.
+bool TACDisplayPage::layoutIsValid(TCanvas* canvas) {
+	if (canvas != cachedCanvas)
+		return false;
+	for (auto& item : padItems) {
+		if (item.display == nullptr)
+			continue;
+		if (item.padNumber == 0)
+			return false;
+		TVirtualPad* pad = canvas->GetPad(item.padNumber);
+		if (pad == nullptr
+				|| pad->GetListOfPrimitives()->FindObject(item.display) == nullptr)
+			return false;
+	}
+	return true;
+}
+
+void TACDisplayPage::layout(TCanvas* canvas) {
+	canvas->cd(0);
+	canvas->Clear();
+	canvas->Divide(nPadsX, nPadsY, 0.01, 0.01);
+
+	int iPad = 0;
+	for (auto& item : padItems) {
+		item.padNumber = 0;
+		if (item.display == nullptr)
+			continue;
+		item.padNumber = ++iPad;
+		TVirtualPad* pad = canvas->cd(item.padNumber);
+		pad->SetTicks();
+		pad->SetGridx();
+		pad->SetGridy();
+		pad->SetLogz();
+		item.display->Draw(item.drawOption.c_str());
+	}
+	canvas->cd(0);
+	cachedCanvas = canvas;
+}
+
+void TACDisplayPage::Draw() {
+	TDirectory* savedDir = gDirectory;
+	TDirectory* dir = findDirectory();
+	if (dir == nullptr || gPad == nullptr)
+		return;
+	TCanvas* canvas = gPad->GetCanvas();
+	if (canvas == nullptr)
+		return;
+
+	bool needLayout = false;
+	for (auto& item : padItems) {
+		if (findSource(dir, item) == nullptr)
+			continue;
+		if (updateDisplay(item))
+			needLayout = true;
+	}
+	savedDir->cd();
+
+	if (needLayout || !layoutIsValid(canvas)) {
+		layout(canvas);
+	} else {
+		for (auto& item : padItems) {
+			if (item.padNumber > 0)
+				canvas->GetPad(item.padNumber)->Modified();
+		}
+	}
+	canvas->Update();
+}
+
+// The pages correspond to the TAC_*.C macros, the order of the histograms
+// defines the order of the pads.
+TACDisplayPage* TACDisplayPage::getPage(const string& name) {
+	typedef TACDisplayPage::PadItem Item;
+	static map<string, unique_ptr<TACDisplayPage> > pageMap;
+	if (pageMap.empty()) {
+		pageMap["TAC_hits"].reset(
+				new TACDisplayPage("TAC_hits", 4, 2,
+						{ Item("TACFADCRAW_1", "L"), Item("TAC_NHITS_1", "BAR"),
+								Item("TACAmpPULSE_1", "L"), Item("TAC_TDCTIME_1", "BAR"),
+								Item("TACTIMEPULSEvsTAGHTIME_1", "COLZ"),
+								Item("TACTIMEPULSEvsTAGMTIME_1", "COLZ"),
+								Item("TACAMPPULSEvsTAGHID_1", "COLZ"),
+								Item("TACAMPPULSEvsTAGMID_1", "COLZ") }));
+		pageMap["TAC_1D_hits"].reset(
+				new TACDisplayPage("TAC_1D_hits", 4, 3,
+						{ Item("TAC_NHITS_1", "BAR"), Item("TACFADCRAW_1", "L"),
+								Item("TACAmpPULSE_1", "L"), Item("TACIntegral_1", "L"),
+								Item("TACTimePULSE_1", "BAR"), Item("TAC_NTDCHITS_1", "BAR"),
+								Item("TAC_TDCTIME_1", "BAR"), Item("TAC_TDCADCTIME_1", "BAR"),
+								Item("TAGHSigTime_1", "BAR"),
+								Item("TAGH_ID_MATCHEDPULSE_1", "BAR"),
+								Item("TAGMSigTime_1", "BAR"),
+								Item("TAGM_ID_MATCHEDPULSE_1", "BAR") }));
+		pageMap["TAC_2D_hist"].reset(
+				new TACDisplayPage("TAC_2D_hist", 3, 2,
+						{ Item("TACTIMEPULSEvsTAGHTIME_1", "COLZ"),
+								Item("TACAMPPULSEvsTAGHID_1", "COLZ"),
+								Item("TAGHTIMEvsTAGHID_1", "COLZ"),
+								Item("TACTIMEPULSEvsTAGMTIME_1", "COLZ"),
+								Item("TACAMPPULSEvsTAGMID_1", "COLZ"),
+								Item("TAGMTIMEvsTAGMID_1", "COLZ") }));
+		pageMap["TAC_waveforms"].reset(
+				new TACDisplayPage("TAC_waveforms", 2, 2,
+						{ Item("TACFADCRAW_RECENT_1", "COLZ"),
+								Item("TACFADCRAW_1", "L"),
+								Item("TACFADCRAW_AVG_1", "L"),
+								Item("TACTimeWAVE_1", "BAR") }));
+	}
+	auto pageIter = pageMap.find(name);
+	if (pageIter == pageMap.end())
+		return nullptr;
+	return pageIter->second.get();
+}
+
+extern "C" void TACDisplay_DrawPage(const char* pageName) {
+	TACDisplayPage* page = TACDisplayPage::getPage(pageName);
+	if (page == nullptr) {
+		cout << "TACDisplay: unknown page " << pageName << endl;
+		return;
+	}
+	page->Draw();
+}
@@ -0,0 +1,97 @@
+/*
+ * TACDisplay.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Compiled version of the TAC RootSpy display macros. The macros only load
+ *  this library and call TACDisplay_DrawPage() with their page name. Each
+ *  page keeps the histogram lookups, its own styled copy of every histogram
+ *  and the canvas layout between refreshes, so that a refresh only copies the
+ *  bin contents and marks the pads as modified.
+ */
+
+#ifndef TACDISPLAY_H_
+#define TACDISPLAY_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <TH1.h>
+#include <TDirectory.h>
+#include <TCanvas.h>
+
+class TACDisplayPage {
+public:
+	// Description of a single pad on the page
+	struct PadItem {
+		// Name of the histogram in the TAC directory
+		std::string histName;
+		// Draw option for the pad
+		std::string drawOption;
+		// Cached pointer to the histogram provided by RootSpy
+		TH1* source = nullptr;
+		// Styled copy owned by the page, this is what is drawn in the pad
+		TH1* display = nullptr;
+		// Pad number on the canvas, 0 if the item is not drawn
+		int padNumber = 0;
+
+		PadItem(std::string name, std::string option) :
+				histName(name), drawOption(option) {
+		}
+	};
+
+protected:
+	std::string pageName;
+	int nPadsX;
+	int nPadsY;
+	std::vector<PadItem> padItems;
+
+	// Directory where the histograms were found the last time
+	TDirectory* cachedDir = nullptr;
+	// Directory that was current when the TAC directory was looked up
+	TDirectory* cachedParentDir = nullptr;
+	// Canvas the page was laid out on the last time
+	TCanvas* cachedCanvas = nullptr;
+
+	// Find the TAC directory, use the cached pointer if it is still valid
+	virtual TDirectory* findDirectory();
+	// Find the histogram for the item, use the cached pointer if it is still valid
+	virtual TH1* findSource(TDirectory* dir, PadItem& item);
+	// Copy the contents of the source histogram into the display copy
+	virtual bool updateDisplay(PadItem& item);
+	// Check if the canvas still shows the display copies of this page
+	virtual bool layoutIsValid(TCanvas* canvas);
+	// Clear and divide the canvas and draw the display copies in the pads
+	virtual void layout(TCanvas* canvas);
+
+	// Style applied once when the display copy is created
+	static void applyStyle(TH1* histo);
+
+public:
+	TACDisplayPage(std::string name, int nx, int ny,
+			std::vector<PadItem> items) :
+			pageName(name), nPadsX(nx), nPadsY(ny), padItems(items) {
+	}
+	virtual ~TACDisplayPage();
+
+	TACDisplayPage(const TACDisplayPage&) = delete;
+	TACDisplayPage& operator=(const TACDisplayPage&) = delete;
+
+	// Refresh the page in the current pad's canvas
+	virtual void Draw();
+
+	const std::string& getPageName() const {
+		return pageName;
+	}
+
+	// Return the page with the given name, nullptr if there is no such page
+	static TACDisplayPage* getPage(const std::string& name);
+};
+
+// Entry point used by the RootSpy macros through gSystem->DynFindSymbol
+extern "C" void TACDisplay_DrawPage(const char* pageName);
+
+#endif /* TACDISPLAY_H_ */
@@ -0,0 +1,133 @@
+/*
+ * TACEventGenerator.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Generator of synthetic TAC events for the benchmark tools. It produces the
+ *  content of the objects the monitor reads from an event: the L1 trigger
+ *  mask, the TAC FADC250 waveform (Df250WindowRawData) and the firmware pulse
+ *  (DTACDigiHit), the CAEN TDC time of the TAC and the TAGH/TAGM digi hits.
+ */
+
+#ifndef TACEVENTGENERATOR_H_
+#define TACEVENTGENERATOR_H_
+
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "TACEventData.h"
+
+class TACEventGenerator {
+public:
+	struct Config {
+		// Mean number of TAGH and TAGM hits per event
+		double taghMultiplicity = 20;
+		double tagmMultiplicity = 10;
+		// Fraction of the tagger hits in time with the TAC
+		double matchedFraction = 0.3;
+		// Pulse shape: "gauss" or "exp" (gaussian rise with an exponential tail)
+		std::string pulseShape = "exp";
+		double amplitudeMean = 1500;
+		double amplitudeSigma = 600;
+		// Rise and fall time in samples
+		double riseTime = 1.5;
+		double fallTime = 6.0;
+		double pedestal = 100;
+		double noise = 2.0;
+		unsigned nSamples = 100;
+		// Position of the pulse in samples
+		double pulsePosition = 30;
+		double pulseJitter = 1.0;
+		// TDC time of the TAC in ns
+		double tdcTime = 200;
+		double tdcJitter = 0.5;
+		uint32_t triggerMask = 0b00000010;
+	};
+
+protected:
+	Config config;
+	std::mt19937_64 engine;
+
+	double shape(double t) const {
+		if (config.pulseShape == "gauss" || t < 0)
+			return std::exp(-0.5 * t * t / (config.riseTime * config.riseTime));
+		return std::exp(-t / config.fallTime);
+	}
+
+	void generateTaggerHits(std::vector<TACEventData::TaggerHit>& hits,
+			double multiplicity, unsigned nCounters, double matchTime) {
+		std::poisson_distribution<unsigned> nHitsDist(multiplicity);
+		std::uniform_int_distribution<unsigned> counterDist(1, nCounters);
+		std::uniform_real_distribution<double> flatDist(0.0, 1.0);
+		std::normal_distribution<double> matchDist(matchTime, 2.0);
+		unsigned nHits = nHitsDist(engine);
+		for (unsigned iHit = 0; iHit < nHits; iHit++) {
+			TACEventData::TaggerHit hit;
+			hit.counter = counterDist(engine);
+			if (flatDist(engine) < config.matchedFraction)
+				hit.time = matchDist(engine);
+			else
+				hit.time = 400.0 * flatDist(engine);
+			hits.push_back(hit);
+		}
+	}
+
+public:
+	TACEventGenerator(const Config& conf, uint64_t seed = 12345) :
+			config(conf), engine(seed) {
+		if (config.pulseShape != "gauss" && config.pulseShape != "exp")
+			throw std::invalid_argument("Unknown pulse shape " + config.pulseShape);
+	}
+
+	void generate(TACEventData& event, uint64_t eventNumber) {
+		std::normal_distribution<double> unitGauss(0.0, 1.0);
+		event.clear();
+		event.runNumber = 1;
+		event.eventNumber = eventNumber;
+		event.triggerMask = config.triggerMask;
+
+		// Waveform with a single pulse
+		double amplitude = std::max(50.0,
+				config.amplitudeMean + config.amplitudeSigma * unitGauss(engine));
+		double position = config.pulsePosition + config.pulseJitter * unitGauss(engine);
+		event.nWaveforms = 1;
+		event.samples.resize(config.nSamples);
+		double integral = 0;
+		uint16_t peak = 0;
+		unsigned peakSample = 0;
+		for (unsigned iSample = 0; iSample < config.nSamples; iSample++) {
+			double value = config.pedestal + amplitude * shape(iSample - position)
+					+ config.noise * unitGauss(engine);
+			value = std::min(4095.0, std::max(0.0, value));
+			event.samples[iSample] = uint16_t(value);
+			integral += value - config.pedestal;
+			if (event.samples[iSample] > peak) {
+				peak = event.samples[iSample];
+				peakSample = iSample;
+			}
+		}
+
+		// Firmware pulse found in the same waveform
+		TACEventData::Pulse pulse;
+		pulse.peak = peak;
+		pulse.time = 4.0 * peakSample;
+		pulse.integral = integral;
+		event.pulses.push_back(pulse);
+
+		event.nTDCHits = 1;
+		event.tdcTimes.push_back(config.tdcTime + config.tdcJitter * unitGauss(engine));
+
+		generateTaggerHits(event.taghHits, config.taghMultiplicity, 274, 100.0);
+		generateTaggerHits(event.tagmHits, config.tagmMultiplicity, 102, 90.0);
+	}
+
+	const Config& getConfig() const {
+		return config;
+	}
+};
+
+#endif /* TACEVENTGENERATOR_H_ */
@@ -0,0 +1,503 @@
+/*
+ * tac_aggregator.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Daemon that receives the histogram deltas pushed by the TAC_Monitor plugins
+ *  of several hd_ana processes (see HistogramDeltaProtocol.h) and keeps the
+ *  merged histograms of every run. The histograms are combined following the
+ *  merge modes of TACHistogramDefinitions.h, the same way tac_merge does. The
+ *  merged view is written periodically to <prefix>_<run>.root, the file is
+ *  replaced atomically so that it can be opened at any time.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TH2D.h"
+
+#include "HistogramDeltaProtocol.h"
+#include "TACHistogramDefinitions.h"
+
+using namespace std;
+using namespace HistogramDeltaProtocol;
+
+// Cell contents and entries of a histogram
+struct HistogramContents {
+	vector<double> cells;
+	double entries = 0;
+	// Number of the last DELTA that changed it, to find the latest snapshot
+	uint64_t lastChange = 0;
+};
+
+// Number of DELTA messages handled so far
+static uint64_t nDeltas = 0;
+
+struct MergedHistogram {
+	HistogramDefinition definition;
+	HistogramContents contents;
+	TACHistogramDefinition::MergeMode mergeMode = TACHistogramDefinition::MERGE_ADD;
+};
+
+// Merge mode of a histogram <key>_<trigger bit>, histograms that are not in
+// the table are added
+static TACHistogramDefinition::MergeMode getMergeMode(const string& histName) {
+	string key;
+	unsigned trigBit;
+	if (splitTACHistogramName(histName, key, trigBit)) {
+		auto definition = findTACHistogramDefinition(key);
+		if (definition != nullptr)
+			return definition->mergeMode;
+	}
+	return TACHistogramDefinition::MERGE_ADD;
+}
+
+// Merged histograms of a run and what each source contributed to them
+struct RunView {
+	map<string, MergedHistogram> merged;
+	map<string, map<string, HistogramContents> > sources;
+	bool changed = false;
+
+	// Remove everything a source has sent so far
+	void dropSource(const string& sourceName) {
+		auto sourceIter = sources.find(sourceName);
+		if (sourceIter == sources.end())
+			return;
+		for (auto& contribution : sourceIter->second) {
+			auto& mergedHisto = merged[contribution.first];
+			auto& mergedContents = mergedHisto.contents;
+			if (mergedHisto.mergeMode == TACHistogramDefinition::MERGE_ADD) {
+				auto& cells = contribution.second.cells;
+				for (size_t iCell = 0; iCell < cells.size(); iCell++)
+					mergedContents.cells[iCell] -= cells[iCell];
+				mergedContents.entries -= contribution.second.entries;
+			} else if (mergedHisto.mergeMode == TACHistogramDefinition::MERGE_LATEST
+					&& mergedContents.lastChange == contribution.second.lastChange) {
+				// The snapshot came from this source, take the latest of the others
+				mergedContents.cells.assign(mergedContents.cells.size(), 0.0);
+				mergedContents.entries = 0;
+				mergedContents.lastChange = 0;
+				for (auto& otherSource : sources) {
+					if (otherSource.first == sourceName)
+						continue;
+					auto otherIter = otherSource.second.find(contribution.first);
+					if (otherIter != otherSource.second.end()
+							&& otherIter->second.lastChange > mergedContents.lastChange)
+						mergedContents = otherIter->second;
+				}
+			}
+		}
+		sources.erase(sourceIter);
+		changed = true;
+	}
+};
+
+// What a connection sends for one run
+struct Stream {
+	RunView* runView = nullptr;
+	// Histogram id of the stream -> merged histogram and contribution
+	map<uint32_t, pair<MergedHistogram*, HistogramContents*> > idMap;
+};
+
+// A connected plugin
+struct Connection {
+	int fd = -1;
+	vector<char> buffer;
+	string sourceName;
+	// Streams started by a HELLO on this connection, by run number
+	map<int32_t, Stream> streams;
+	// Stream of the last HELLO or RUN, DEFINE and DELTA go to it. nullptr
+	// if another connection of the source has started the run again.
+	Stream* stream = nullptr;
+};
+
+static map<int32_t, RunView> runViews;
+static map<int, Connection> connections;
+static volatile sig_atomic_t keepRunning = 1;
+
+static void handleSignal(int) {
+	keepRunning = 0;
+}
+
+static bool handleHello(Connection& connection, Reader& reader) {
+	string sourceName = reader.getString();
+	int32_t runNumber = reader.getSigned();
+	if (!reader.isValid())
+		return false;
+	// A HELLO from a known source means it starts its stream from scratch. A
+	// plugin that reconnected may still have frames of the run buffered on
+	// its old connection, they are ignored from now on.
+	for (auto& connectionPair : connections) {
+		Connection& other = connectionPair.second;
+		if (other.sourceName != sourceName)
+			continue;
+		auto streamIter = other.streams.find(runNumber);
+		if (streamIter == other.streams.end())
+			continue;
+		if (other.stream == &streamIter->second)
+			other.stream = nullptr;
+		other.streams.erase(streamIter);
+	}
+	connection.sourceName = sourceName;
+	connection.stream = &connection.streams[runNumber];
+	connection.stream->runView = &runViews[runNumber];
+	connection.stream->runView->dropSource(sourceName);
+	cout << "Source " << sourceName << " started run " << runNumber << endl;
+	return true;
+}
+
+static bool handleRun(Connection& connection, Reader& reader) {
+	int32_t runNumber = reader.getSigned();
+	if (!reader.isValid() || connection.sourceName.empty())
+		return false;
+	auto streamIter = connection.streams.find(runNumber);
+	connection.stream = streamIter != connection.streams.end() ?
+			&streamIter->second : nullptr;
+	return true;
+}
+
+static bool handleDefine(Connection& connection, Reader& reader) {
+	HistogramDefinition def = reader.getDefinition();
+	if (!reader.isValid() || connection.sourceName.empty())
+		return false;
+	if (connection.stream == nullptr)
+		return true;
+	RunView& runView = *connection.stream->runView;
+	auto mergedIter = runView.merged.find(def.name);
+	if (mergedIter == runView.merged.end()) {
+		MergedHistogram& merged = runView.merged[def.name];
+		merged.definition = def;
+		merged.mergeMode = getMergeMode(def.name);
+		merged.contents.cells.assign(def.getNumberOfCells(), 0.0);
+		mergedIter = runView.merged.find(def.name);
+	} else if (mergedIter->second.definition.getNumberOfCells()
+			!= def.getNumberOfCells()) {
+		cout << "Binning of " << def.name << " from " << connection.sourceName
+				<< " does not match, ignoring it" << endl;
+		return true;
+	}
+	HistogramContents& contribution = runView.sources[connection.sourceName][def.name];
+	contribution.cells.assign(def.getNumberOfCells(), 0.0);
+	contribution.entries = 0;
+	contribution.lastChange = 0;
+	connection.stream->idMap[def.id] = make_pair(&mergedIter->second, &contribution);
+	return true;
+}
+
+static bool handleDelta(Connection& connection, Reader& reader) {
+	uint32_t id = reader.getVarint();
+	double entriesChange = reader.getDouble();
+	uint64_t encoding = reader.getVarint();
+	uint64_t nChanged = reader.getVarint();
+	if (!reader.isValid())
+		return false;
+	if (connection.stream == nullptr)
+		return true;
+	auto idIter = connection.stream->idMap.find(id);
+	if (idIter == connection.stream->idMap.end())
+		return true;
+	MergedHistogram& mergedHisto = *idIter->second.first;
+	HistogramContents& merged = mergedHisto.contents;
+	HistogramContents& contribution = *idIter->second.second;
+	bool add = mergedHisto.mergeMode == TACHistogramDefinition::MERGE_ADD;
+	uint64_t iCell = 0;
+	for (uint64_t iChange = 0; iChange < nChanged; iChange++) {
+		iCell += reader.getVarint();
+		double change =
+				encoding == CELLS_VARINT ?
+						double(reader.getSigned()) : reader.getDouble();
+		if (!reader.isValid() || iCell >= merged.cells.size())
+			return false;
+		if (add)
+			merged.cells[iCell] += change;
+		contribution.cells[iCell] += change;
+	}
+	contribution.entries += entriesChange;
+	contribution.lastChange = ++nDeltas;
+	switch (mergedHisto.mergeMode) {
+	case TACHistogramDefinition::MERGE_ADD:
+		merged.entries += entriesChange;
+		break;
+	case TACHistogramDefinition::MERGE_LATEST:
+		// The source that sent the last change has the latest snapshot
+		merged = contribution;
+		break;
+	case TACHistogramDefinition::MERGE_AVERAGE:
+	case TACHistogramDefinition::MERGE_EFFICIENCY:
+		// Recomputed from the merged histograms by writeRunViews()
+		break;
+	}
+	connection.stream->runView->changed = true;
+	return true;
+}
+
+// Handle all complete frames in the buffer, returns false on a protocol error
+static bool handleFrames(Connection& connection) {
+	size_t offset = 0;
+	auto& buffer = connection.buffer;
+	while (buffer.size() - offset >= frameHeaderSize) {
+		uint32_t length;
+		memcpy(&length, &buffer[offset], sizeof(length));
+		if (length > maxPayloadSize)
+			return false;
+		if (buffer.size() - offset < frameHeaderSize + length)
+			break;
+		uint8_t type = uint8_t(buffer[offset + 4]);
+		Reader reader(&buffer[offset + frameHeaderSize], length);
+		bool status = true;
+		switch (type) {
+		case MSG_HELLO:
+			status = handleHello(connection, reader);
+			break;
+		case MSG_RUN:
+			status = handleRun(connection, reader);
+			break;
+		case MSG_DEFINE:
+			status = handleDefine(connection, reader);
+			break;
+		case MSG_DELTA:
+			status = handleDelta(connection, reader);
+			break;
+		default:
+			status = false;
+		}
+		if (!status)
+			return false;
+		offset += frameHeaderSize + length;
+	}
+	buffer.erase(buffer.begin(), buffer.begin() + offset);
+	return true;
+}
+
+// Recompute the average waveforms from the merged sums and entries, and the
+// tagger efficiencies from the merged matched and total hits
+static void computeAverages(const RunView& runView,
+		map<string, unique_ptr<TH1> >& histos) {
+	for (auto& mergedPair : runView.merged) {
+		auto mergeMode = mergedPair.second.mergeMode;
+		if (mergeMode != TACHistogramDefinition::MERGE_AVERAGE
+				&& mergeMode != TACHistogramDefinition::MERGE_EFFICIENCY)
+			continue;
+		string key;
+		unsigned trigBit;
+		if (!splitTACHistogramName(mergedPair.first, key, trigBit))
+			continue;
+		stringstream sumName, entriesName;
+		if (mergeMode == TACHistogramDefinition::MERGE_AVERAGE) {
+			sumName << "TACFADCRAW_SUM_" << trigBit;
+			entriesName << "TACFADCRAW_ENTRIES_" << trigBit;
+		} else {
+			string detComp = key.substr(0, key.find('_'));
+			sumName << detComp << "_ID_MATCHEDPULSE_" << trigBit;
+			entriesName << detComp << "_ID_PULSE_" << trigBit;
+		}
+		auto sumIter = histos.find(sumName.str());
+		auto entriesIter = histos.find(entriesName.str());
+		if (sumIter == histos.end() || entriesIter == histos.end())
+			continue;
+		TH1* histo = histos[mergedPair.first].get();
+		histo->Reset();
+		histo->Divide(sumIter->second.get(), entriesIter->second.get(), 1, 1,
+				mergeMode == TACHistogramDefinition::MERGE_EFFICIENCY ? "B" : "");
+	}
+}
+
+static void writeRunViews(const string& prefix) {
+	for (auto& runPair : runViews) {
+		RunView& runView = runPair.second;
+		if (!runView.changed)
+			continue;
+		string fileName = prefix + "_" + to_string(runPair.first) + ".root";
+		string tmpFileName = fileName + ".tmp";
+		{
+			TFile outFile(tmpFileName.c_str(), "RECREATE");
+			if (outFile.IsZombie()) {
+				cerr << "Could not create " << tmpFileName << endl;
+				continue;
+			}
+			map<string, unique_ptr<TH1> > histos;
+			for (auto& mergedPair : runView.merged) {
+				const HistogramDefinition& def = mergedPair.second.definition;
+				const HistogramContents& contents = mergedPair.second.contents;
+				unique_ptr<TH1>& histo = histos[mergedPair.first];
+				if (def.dimension == 2)
+					histo.reset(new TH2D(def.name.c_str(), def.title.c_str(),
+							def.nBinsX, def.xMin, def.xMax, def.nBinsY, def.yMin,
+							def.yMax));
+				else
+					histo.reset(new TH1D(def.name.c_str(), def.title.c_str(),
+							def.nBinsX, def.xMin, def.xMax));
+				histo->SetDirectory(nullptr);
+				histo->GetXaxis()->SetTitle(def.xTitle.c_str());
+				histo->GetYaxis()->SetTitle(def.yTitle.c_str());
+				for (size_t iCell = 0; iCell < contents.cells.size(); iCell++) {
+					if (contents.cells[iCell] != 0)
+						histo->SetBinContent(iCell, contents.cells[iCell]);
+				}
+				histo->ResetStats();
+				histo->SetEntries(contents.entries);
+			}
+			computeAverages(runView, histos);
+			for (auto& histoPair : histos)
+				outFile.WriteTObject(histoPair.second.get());
+			outFile.Close();
+		}
+		if (rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+			cerr << "Could not rename " << tmpFileName << endl;
+			continue;
+		}
+		runView.changed = false;
+	}
+}
+
+static int listenUnix(const string& path) {
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un unixAddress = { };
+	unixAddress.sun_family = AF_UNIX;
+	path.copy(unixAddress.sun_path, sizeof(unixAddress.sun_path) - 1);
+	unlink(path.c_str());
+	if (fd < 0
+			|| bind(fd, reinterpret_cast<sockaddr*>(&unixAddress), sizeof(unixAddress)) != 0
+			|| listen(fd, 64) != 0) {
+		perror(path.c_str());
+		exit(-1);
+	}
+	return fd;
+}
+
+// TCP connections are only accepted on the loopback interface
+static int listenTCP(int port) {
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	sockaddr_in inetAddress = { };
+	inetAddress.sin_family = AF_INET;
+	inetAddress.sin_port = htons(port);
+	inetAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (fd < 0
+			|| bind(fd, reinterpret_cast<sockaddr*>(&inetAddress), sizeof(inetAddress)) != 0
+			|| listen(fd, 64) != 0) {
+		perror("tcp listen");
+		exit(-1);
+	}
+	return fd;
+}
+
+static void usage() {
+	cout << "Usage:" << endl << "   tac_aggregator [options]" << endl << endl
+			<< "Options:" << endl
+			<< "   -s path     Unix socket path (default /tmp/tac_aggregator.sock)" << endl
+			<< "   -p port     also listen on 127.0.0.1:port" << endl
+			<< "   -t seconds  period for writing the merged histograms (default 10)" << endl
+			<< "   -o prefix   output file prefix (default tac_aggregated)" << endl
+			<< "   -h          print this message" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	string socketPath = "/tmp/tac_aggregator.sock";
+	int tcpPort = 0;
+	int writePeriod = 10;
+	string outPrefix = "tac_aggregated";
+
+	int option;
+	while ((option = getopt(argc, argv, "s:p:t:o:h")) != -1) {
+		switch (option) {
+		case 's':
+			socketPath = optarg;
+			break;
+		case 'p':
+			tcpPort = atoi(optarg);
+			break;
+		case 't':
+			writePeriod = atoi(optarg);
+			break;
+		case 'o':
+			outPrefix = optarg;
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+
+	signal(SIGINT, handleSignal);
+	signal(SIGTERM, handleSignal);
+	signal(SIGPIPE, SIG_IGN);
+	TH1::AddDirectory(false);
+
+	vector<int> listenFDs;
+	if (!socketPath.empty())
+		listenFDs.push_back(listenUnix(socketPath));
+	if (tcpPort > 0)
+		listenFDs.push_back(listenTCP(tcpPort));
+
+	vector<char> readBuffer(1 << 20);
+	time_t lastWrite = time(nullptr);
+
+	while (keepRunning) {
+		vector<pollfd> pollFDs;
+		for (int fd : listenFDs)
+			pollFDs.push_back( { fd, POLLIN, 0 });
+		for (auto& connectionPair : connections)
+			pollFDs.push_back( { connectionPair.first, POLLIN, 0 });
+		int nReady = poll(&pollFDs[0], pollFDs.size(), 1000);
+
+		for (size_t iPoll = 0; nReady > 0 && iPoll < pollFDs.size(); iPoll++) {
+			if (pollFDs[iPoll].revents == 0)
+				continue;
+			int fd = pollFDs[iPoll].fd;
+			if (iPoll < listenFDs.size()) {
+				int clientFD = accept(fd, nullptr, nullptr);
+				if (clientFD >= 0)
+					connections[clientFD].fd = clientFD;
+				continue;
+			}
+			Connection& connection = connections[fd];
+			ssize_t nBytes = read(fd, &readBuffer[0], readBuffer.size());
+			bool keep = nBytes > 0;
+			if (keep) {
+				connection.buffer.insert(connection.buffer.end(), readBuffer.begin(),
+						readBuffer.begin() + nBytes);
+				keep = handleFrames(connection);
+				if (!keep)
+					cout << "Protocol error from " << connection.sourceName << endl;
+			}
+			if (!keep) {
+				// What the source sent so far stays in the merged view
+				close(fd);
+				connections.erase(fd);
+			}
+		}
+
+		if (time(nullptr) - lastWrite >= writePeriod) {
+			writeRunViews(outPrefix);
+			lastWrite = time(nullptr);
+		}
+	}
+
+	writeRunViews(outPrefix);
+	for (auto& connectionPair : connections)
+		close(connectionPair.first);
+	for (int fd : listenFDs)
+		close(fd);
+	if (!socketPath.empty())
+		unlink(socketPath.c_str());
+	return 0;
+}
@@ -0,0 +1,271 @@
+/*
+ * tac_bench.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Scaling benchmark of JEventProcessor_TAC_Monitor. Events are generated by
+ *  TACEventGenerator, so no EVIO file, calibration database or JANA event
+ *  loop is needed. By default only the histogram filling of processEvent()
+ *  is measured. With -e the events go through everything evnt() does after
+ *  it collected the data from JANA: the trigger selection, analyzeEvent()
+ *  with the event summary, the waveform ring, the compression test (-c), the
+ *  snapshot requests and the periodic tasks including the shared memory
+ *  publisher (-S). The JANA lookups of collectEventData() are never measured.
+ *  The benchmark runs with 1..N threads and reports the event rate, the
+ *  fraction of the time the threads spent waiting for the ROOT lock and the
+ *  number of heap allocations per event once the threads are warmed up.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <new>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "TH1.h"
+
+#include "JEventProcessor_TAC_Monitor.h"
+#include "TACEventGenerator.h"
+
+using namespace std;
+
+// Heap allocations of the whole program, counted by the operator new below
+static atomic<uint64_t> nAllocations(0);
+
+void* operator new(size_t size) {
+	nAllocations.fetch_add(1, memory_order_relaxed);
+	void* memory = malloc(size == 0 ? 1 : size);
+	if (memory == nullptr)
+		throw bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+}
+
+// Events each thread processes before the measurement, so that the buffers
+// reused from event to event have reached their size
+static const unsigned warmUpEvents = 1000;
+
+// Gives the benchmark access to the event processing of the monitor
+class BenchmarkMonitor: public JEventProcessor_TAC_Monitor {
+protected:
+	bool fullEvent;
+
+public:
+	BenchmarkMonitor(pthread_rwlock_t* lock, bool full,
+			const vector<string>& codecNames, const string& segmentName) :
+			fullEvent(full) {
+		rootLock = lock;
+		if (fullEvent) {
+			// The codec histograms are made with the run histograms
+			if (!codecNames.empty())
+				dataCompressor = new CompressionTester(codecNames);
+			if (!segmentName.empty())
+				shmPublisher = new HistogramShmPublisher(segmentName, histogramVersions);
+			if (waveformRingSize > 0)
+				waveformRing = new WaveformRing(waveformRingSize);
+		}
+		startRunHistograms(1);
+	}
+	virtual ~BenchmarkMonitor() {
+		// Unlinks the shared memory segment
+		delete shmPublisher;
+		delete dataCompressor;
+		delete waveformRing;
+	}
+	void process(const TACEventData& eventData) {
+		if (!fullEvent) {
+			shared_ptr<RunHistograms> run = acquireRunHistograms(eventData.runNumber);
+			processEvent(*run, eventData);
+			releaseRunHistograms(*run);
+			return;
+		}
+		// What evnt() does, with the generated event in place of the JANA objects
+		TACMetrics::ThreadCounters& metrics = TACMetrics::getThreadCounters();
+		metrics.add(TACMetrics::EVENTS_SEEN);
+		if (!triggerIsUseful(eventData.triggerMask))
+			return;
+		metrics.add(TACMetrics::EVENTS_ACCEPTED);
+		shared_ptr<RunHistograms> run = acquireRunHistograms(eventData.runNumber);
+		if (run == nullptr)
+			return;
+		TACEventArena& arena = TACEventArena::getThreadArena();
+		arena.eventData = eventData;
+		analyzeEvent(*run, arena);
+		releaseRunHistograms(*run);
+	}
+};
+
+struct ThreadResult {
+	uint64_t nEvents = 0;
+	TimedWriteLock::Statistics lockStatistics;
+};
+
+static void usage() {
+	cout << "Usage:" << endl << "   tac_bench [options]" << endl << endl
+			<< "Options:" << endl
+			<< "   -n events   events per thread (default 200000)" << endl
+			<< "   -t threads  maximum number of threads (default: number of cores)" << endl
+			<< "   -H mult     mean TAGH multiplicity (default 20)" << endl
+			<< "   -M mult     mean TAGM multiplicity (default 10)" << endl
+			<< "   -f frac     fraction of tagger hits in time with the TAC (default 0.3)" << endl
+			<< "   -s shape    pulse shape, gauss or exp (default exp)" << endl
+			<< "   -a amp      mean pulse amplitude (default 1500)" << endl
+			<< "   -p size     number of generated events that are replayed (default 10000)" << endl
+			<< "   -e          run all of evnt() after the JANA lookups, not only processEvent()" << endl
+			<< "   -c codecs   comma separated codecs to test with -e (default none)" << endl
+			<< "   -S name     shared memory segment to publish to with -e (default none)" << endl
+			<< "   -h          print this message" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	TACEventGenerator::Config config;
+	uint64_t eventsPerThread = 200000;
+	unsigned maxThreads = thread::hardware_concurrency();
+	unsigned poolSize = 10000;
+	bool fullEvent = false;
+	vector<string> codecNames;
+	string segmentName;
+
+	int option;
+	while ((option = getopt(argc, argv, "n:t:H:M:f:s:a:p:ec:S:h")) != -1) {
+		switch (option) {
+		case 'n':
+			eventsPerThread = strtoull(optarg, nullptr, 10);
+			break;
+		case 't':
+			maxThreads = atoi(optarg);
+			break;
+		case 'H':
+			config.taghMultiplicity = atof(optarg);
+			break;
+		case 'M':
+			config.tagmMultiplicity = atof(optarg);
+			break;
+		case 'f':
+			config.matchedFraction = atof(optarg);
+			break;
+		case 's':
+			config.pulseShape = optarg;
+			break;
+		case 'a':
+			config.amplitudeMean = atof(optarg);
+			break;
+		case 'p':
+			poolSize = atoi(optarg);
+			break;
+		case 'e':
+			fullEvent = true;
+			break;
+		case 'c': {
+			stringstream codecStream(optarg);
+			string codecName;
+			while (getline(codecStream, codecName, ','))
+				if (!codecName.empty())
+					codecNames.push_back(codecName);
+			break;
+		}
+		case 'S':
+			segmentName = optarg;
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+	if (maxThreads < 1)
+		maxThreads = 1;
+	if (poolSize < 1)
+		poolSize = 1;
+
+	// Generate the events up front so that the generator is not measured
+	vector<TACEventData> eventPool(poolSize);
+	TACEventGenerator generator(config);
+	for (unsigned iEvent = 0; iEvent < poolSize; iEvent++)
+		generator.generate(eventPool[iEvent], iEvent + 1);
+
+	pthread_rwlock_t rootLock = PTHREAD_RWLOCK_INITIALIZER;
+	BenchmarkMonitor monitor(&rootLock, fullEvent, codecNames, segmentName);
+	TimedWriteLock::setTimingEnabled(true);
+
+	cout << "TAGH/TAGM multiplicity " << config.taghMultiplicity << "/"
+			<< config.tagmMultiplicity << ", pulse shape " << config.pulseShape
+			<< ", " << eventsPerThread << " events per thread" << endl;
+	if (fullEvent)
+		cout << "Measuring evnt() after the JANA lookups: trigger selection, "
+				<< "analyzeEvent() and periodic tasks" << endl;
+	else
+		cout << "Measuring processEvent() only, without the trigger selection, "
+				<< "compression, waveform ring, snapshots and publishers of evnt()" << endl;
+	cout << setw(8) << "threads" << setw(14) << "events/s" << setw(14)
+			<< "per thread" << setw(12) << "speedup" << setw(12) << "lock wait"
+			<< setw(14) << "locks/event" << setw(14) << "allocs/event" << endl;
+
+	double singleThreadRate = 0;
+	for (unsigned nThreads = 1; nThreads <= maxThreads; nThreads++) {
+		vector<ThreadResult> results(nThreads);
+		vector<thread> workers;
+		atomic<unsigned> nReady(0);
+		atomic<bool> go(false);
+		for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+			workers.emplace_back([&, iThread]() {
+				for (unsigned iWarmUp = 0; iWarmUp < warmUpEvents; iWarmUp++)
+					monitor.process(eventPool[(size_t(iThread) + iWarmUp) % poolSize]);
+				TimedWriteLock::resetThreadStatistics();
+				nReady++;
+				while (!go)
+					this_thread::yield();
+				// Threads start at different places in the pool
+				size_t iEvent = (size_t(iThread) * poolSize) / nThreads;
+				for (uint64_t iProcessed = 0; iProcessed < eventsPerThread; iProcessed++) {
+					monitor.process(eventPool[iEvent]);
+					if (++iEvent == poolSize)
+						iEvent = 0;
+				}
+				results[iThread].nEvents = eventsPerThread;
+				results[iThread].lockStatistics = TimedWriteLock::getThreadStatistics();
+			});
+		}
+		while (nReady < nThreads)
+			this_thread::yield();
+		auto startTime = chrono::steady_clock::now();
+		uint64_t startAllocations = nAllocations.load();
+		go = true;
+		for (auto& worker : workers)
+			worker.join();
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+		uint64_t runAllocations = nAllocations.load() - startAllocations;
+
+		uint64_t nEvents = 0, nLocks = 0, waitNanoseconds = 0;
+		for (auto& result : results) {
+			nEvents += result.nEvents;
+			nLocks += result.lockStatistics.nLocks;
+			waitNanoseconds += result.lockStatistics.waitNanoseconds;
+		}
+		double rate = nEvents / elapsed;
+		if (nThreads == 1)
+			singleThreadRate = rate;
+		double waitFraction = waitNanoseconds * 1.0e-9 / (elapsed * nThreads);
+		cout << setw(8) << nThreads << setw(14) << fixed << setprecision(0) << rate
+				<< setw(14) << rate / nThreads << setw(12) << setprecision(2)
+				<< rate / singleThreadRate << setw(11) << setprecision(1)
+				<< 100.0 * waitFraction << "%" << setw(14) << setprecision(1)
+				<< double(nLocks) / nEvents << setw(14) << setprecision(2)
+				<< double(runAllocations) / nEvents << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * tac_codec_bench.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Throughput of WaveformBatchEncoder for several batch sizes against
+ *  data::data::encode() one waveform at a time, on waveforms generated by
+ *  TACEventGenerator. The records of the two are compared byte by byte.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "data.h"
+#include "DataKernels.h"
+#include "WaveformBatchEncoder.h"
+#include "TACEventGenerator.h"
+
+using namespace std;
+
+static void usage() {
+	cout << "Usage:" << endl << "   tac_codec_bench [options]" << endl << endl
+			<< "Options:" << endl
+			<< "   -n count    number of waveforms (default 100000)" << endl
+			<< "   -r repeat   passes over the waveforms (default 10)" << endl
+			<< "   -b sizes    comma-separated batch sizes (default 8,16,32,64,128)" << endl
+			<< "   -k kernels  avx2, sse4.1 or scalar (default: the best the CPU has)" << endl
+			<< "   -s samples  samples per waveform (default 100)" << endl
+			<< "   -h          print this message" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	TACEventGenerator::Config config;
+	unsigned nWaveforms = 100000;
+	unsigned nRepeat = 10;
+	string batchList = "8,16,32,64,128";
+
+	int option;
+	while ((option = getopt(argc, argv, "n:r:b:k:s:h")) != -1) {
+		switch (option) {
+		case 'n':
+			nWaveforms = atoi(optarg);
+			break;
+		case 'r':
+			nRepeat = atoi(optarg);
+			break;
+		case 'b':
+			batchList = optarg;
+			break;
+		case 'k':
+			if (!DataKernels::selectKernels(optarg)) {
+				cerr << "tac_codec_bench: kernels " << optarg << " are not available" << endl;
+				return -1;
+			}
+			break;
+		case 's':
+			config.nSamples = atoi(optarg);
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+	if (nWaveforms < 1 || nRepeat < 1) {
+		usage();
+		return -1;
+	}
+
+	vector<vector<uint16_t> > waveforms(nWaveforms);
+	vector<const vector<uint16_t>*> waveformPointers(nWaveforms);
+	TACEventGenerator generator(config);
+	TACEventData event;
+	uint64_t rawBytes = 0;
+	for (unsigned iWaveform = 0; iWaveform < nWaveforms; iWaveform++) {
+		generator.generate(event, iWaveform + 1);
+		waveforms[iWaveform] = event.samples;
+		waveformPointers[iWaveform] = &waveforms[iWaveform];
+		rawBytes += 2 * event.samples.size();
+	}
+
+	// One waveform at a time, as CompressionTester gives them to the codec
+	vector<vector<char> > singleRecords(nWaveforms);
+	vector<int> intSamples;
+	data::data encoder;
+	auto startTime = chrono::steady_clock::now();
+	for (unsigned iRepeat = 0; iRepeat < nRepeat; iRepeat++) {
+		for (unsigned iWaveform = 0; iWaveform < nWaveforms; iWaveform++) {
+			intSamples.assign(waveforms[iWaveform].begin(), waveforms[iWaveform].end());
+			encoder.encode(intSamples, singleRecords[iWaveform]);
+		}
+	}
+	double singleSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+	double singleNs = 1e9 * singleSeconds / (double(nWaveforms) * nRepeat);
+
+	cout << nWaveforms << " waveforms of " << config.nSamples << " samples, "
+			<< DataKernels::getKernelName() << " kernels" << endl;
+	cout << setw(8) << "batch" << setw(12) << "ns/wf" << setw(12) << "MB/s"
+			<< setw(10) << "speedup" << setw(10) << "same" << endl;
+	cout << setw(8) << "single" << fixed << setprecision(1) << setw(12) << singleNs
+			<< setw(12) << rawBytes * nRepeat / singleSeconds / 1e6 << setw(10)
+			<< 1.0 << setw(10) << "-" << endl;
+
+	stringstream batchStream(batchList);
+	string batchField;
+	vector<vector<char> > batchRecords;
+	bool allSame = true;
+	while (getline(batchStream, batchField, ',')) {
+		WaveformBatchEncoder batchEncoder(atoi(batchField.c_str()));
+		startTime = chrono::steady_clock::now();
+		for (unsigned iRepeat = 0; iRepeat < nRepeat; iRepeat++)
+			batchEncoder.encode(waveformPointers, batchRecords);
+		double batchSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+		double batchNs = 1e9 * batchSeconds / (double(nWaveforms) * nRepeat);
+		bool same = batchRecords == singleRecords;
+		allSame = allSame && same;
+		cout << setw(8) << batchEncoder.getBatchSize() << setw(12) << batchNs
+				<< setw(12) << rawBytes * nRepeat / batchSeconds / 1e6 << setw(10)
+				<< setprecision(2) << singleNs / batchNs << setw(10)
+				<< (same ? "yes" : "NO") << setprecision(1) << endl;
+	}
+	return allSame ? 0 : 1;
+}
@@ -0,0 +1,704 @@
+/*
+ * tac_fill_bench.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Benchmark of the ways the monitor can fill its histograms. A stream of
+ *  fills with the mix of the plugin (TAC amplitudes and times, and for every
+ *  TAGH/TAGM hit the 1D and 2D tagger histograms of fillTaggerRelatedHistograms)
+ *  is built from generated events or from feature files. The fills come in
+ *  groups, one group for every section the plugin fills under one lock. The
+ *  stream is replayed with 1..N threads by each strategy:
+ *
+ *     locked   TH1::Fill under the write lock of a pthread_rwlock
+ *     clones   every thread fills its own clones, added up at the end
+ *     atomic   atomic integer bins, moved into the histograms at the end
+ *     journal  the fills are kept in a journal per thread, which is applied
+ *              to the histograms under the lock once it is full
+ *
+ *  The fill rate and the latency of the groups are printed. The merge at the
+ *  end of a run is timed separately.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "TH1.h"
+#include "TH1D.h"
+#include "TH2D.h"
+
+#include "TACHistogramDefinitions.h"
+#include "TACFeatureFormat.h"
+#include "TACEventGenerator.h"
+#include "AtomicHistogram.h"
+#include "TimedWriteLock.h"
+
+using namespace std;
+
+// Groups each thread fills before the measurement
+static const unsigned warmUpGroups = 10000;
+
+// One fill of a histogram of the stream
+struct Fill {
+	uint32_t histogram;
+	double x;
+	double y;
+};
+
+// What the plugin fills from one event
+struct EventSummary {
+	unsigned nPulses = 0;
+	double pulsePeak = 0;
+	double pulseTime = 0;
+	double pulseIntegral = 0;
+	double waveMax = 0;
+	double waveTime = 0;
+	vector<TACEventData::TaggerHit> taghHits;
+	vector<TACEventData::TaggerHit> tagmHits;
+};
+
+// The fills of all events, grouped as the plugin groups them under its lock
+class FillStream {
+protected:
+	vector<string> keys;
+
+	uint32_t getHistogram(const string& key) {
+		auto keyIter = find(keys.begin(), keys.end(), key);
+		if (keyIter != keys.end())
+			return keyIter - keys.begin();
+		keys.push_back(key);
+		return keys.size() - 1;
+	}
+
+	void add(const string& key, double x, double y = 0) {
+		fills.push_back(Fill { getHistogram(key), x, y });
+	}
+
+	void endGroup() {
+		if (groupEnds.empty() || groupEnds.back() != fills.size())
+			groupEnds.push_back(fills.size());
+	}
+
+	void addTagger(const vector<TACEventData::TaggerHit>& hits, const string& detComp,
+			const string& tacMethod, double tacPeak, double tacTime,
+			double timeCutValue, double timeCutWidth) {
+		for (auto& hit : hits) {
+			add(detComp + "_ID", hit.counter);
+			add(detComp + "SigTime", hit.time);
+			add("TACTIME" + tacMethod + "vs" + detComp + "TIME", hit.time, tacTime);
+			add(detComp + "TIMEvs" + detComp + "ID", hit.counter, hit.time);
+			if (fabs(hit.time - timeCutValue) < timeCutWidth) {
+				add(detComp + "_ID_MATCHED" + tacMethod, hit.counter);
+				add("TACAMP" + tacMethod + "vs" + detComp + "ID", hit.counter, tacPeak);
+			}
+			endGroup();
+		}
+	}
+
+public:
+	vector<Fill> fills;
+	// End of every group in fills and of every event in groupEnds
+	vector<size_t> groupEnds;
+	vector<size_t> eventEnds;
+
+	double timeCutValue_TAGH = 100.0;
+	double timeCutValue_TAGM = 90.0;
+	double timeCutWidth = 20;
+
+	void addEvent(const EventSummary& event) {
+		add("TACAmpWAVE", event.waveMax);
+		add("TACTimeWAVE", event.waveTime);
+		endGroup();
+		addTagger(event.taghHits, "TAGH", "WAVE", event.waveMax, event.waveTime,
+				timeCutValue_TAGH, timeCutWidth);
+		addTagger(event.tagmHits, "TAGM", "WAVE", event.waveMax, event.waveTime,
+				timeCutValue_TAGM, timeCutWidth);
+		add("TAC_NHITS", event.nPulses);
+		endGroup();
+		add("TACAmpPULSE", event.pulsePeak);
+		add("TACTimePULSE", event.pulseTime);
+		add("TACIntegral", event.pulseIntegral);
+		endGroup();
+		addTagger(event.taghHits, "TAGH", "PULSE", event.pulsePeak, event.pulseTime,
+				timeCutValue_TAGH, timeCutWidth);
+		addTagger(event.tagmHits, "TAGM", "PULSE", event.pulsePeak, event.pulseTime,
+				timeCutValue_TAGM, timeCutWidth);
+		eventEnds.push_back(groupEnds.size());
+	}
+
+	const vector<string>& getKeys() const {
+		return keys;
+	}
+
+	size_t getGroupStart(size_t iGroup) const {
+		return iGroup == 0 ? 0 : groupEnds[iGroup - 1];
+	}
+
+	size_t getEventStart(size_t iEvent) const {
+		return iEvent == 0 ? 0 : eventEnds[iEvent - 1];
+	}
+};
+
+// Atomic bins of a 2D histogram in the cell layout of ROOT, the 2D version of
+// AtomicHistogram
+class AtomicHistogram2D {
+protected:
+	unsigned nBinsX, nBinsY;
+	double lowX, lowY, highX, highY;
+	double binsPerUnitX, binsPerUnitY;
+	unique_ptr<atomic<uint32_t>[]> cells;
+
+	static unsigned getBin(double value, double low, double high,
+			double binsPerUnit, unsigned nBins) {
+		if (value < low)
+			return 0;
+		if (value >= high)
+			return nBins + 1;
+		return min<unsigned>(unsigned((value - low) * binsPerUnit), nBins - 1) + 1;
+	}
+
+public:
+	AtomicHistogram2D(unsigned nx, double xLow, double xHigh, unsigned ny,
+			double yLow, double yHigh) :
+			nBinsX(nx), nBinsY(ny), lowX(xLow), lowY(yLow), highX(xHigh), highY(yHigh),
+			binsPerUnitX(nx / (xHigh - xLow)), binsPerUnitY(ny / (yHigh - yLow)),
+			cells(new atomic<uint32_t>[(nx + 2) * (ny + 2)]) {
+		for (unsigned iCell = 0; iCell < (nBinsX + 2) * (nBinsY + 2); iCell++)
+			cells[iCell].store(0, memory_order_relaxed);
+	}
+
+	AtomicHistogram2D(const AtomicHistogram2D&) = delete;
+	AtomicHistogram2D& operator=(const AtomicHistogram2D&) = delete;
+
+	void fill(double x, double y) {
+		unsigned binX = getBin(x, lowX, highX, binsPerUnitX, nBinsX);
+		unsigned binY = getBin(y, lowY, highY, binsPerUnitY, nBinsY);
+		cells[binX + (nBinsX + 2) * binY].fetch_add(1, memory_order_relaxed);
+	}
+
+	uint64_t moveTo(double* histogramCells) {
+		uint64_t nMoved = 0;
+		for (unsigned iCell = 0; iCell < (nBinsX + 2) * (nBinsY + 2); iCell++) {
+			uint32_t count = cells[iCell].exchange(0, memory_order_relaxed);
+			histogramCells[iCell] += count;
+			nMoved += count;
+		}
+		return nMoved;
+	}
+};
+
+// The ROOT histograms the strategies fill, one for each key of the stream
+class TargetHistograms {
+public:
+	vector<TH1*> histograms;
+	vector<bool> is2D;
+	vector<const TACHistogramDefinition*> definitions;
+
+	TargetHistograms(const vector<string>& keys) {
+		TH1::AddDirectory(false);
+		for (auto& key : keys) {
+			const TACHistogramDefinition* def = findTACHistogramDefinition(key);
+			if (def == nullptr)
+				throw invalid_argument("No histogram definition for " + key);
+			string name = key + "_1";
+			if (def->is2D())
+				histograms.push_back(new TH2D(name.c_str(), key.c_str(), def->nBinsX,
+						def->xMin, def->xMax, def->nBinsY, def->yMin, def->yMax));
+			else
+				histograms.push_back(new TH1D(name.c_str(), key.c_str(), def->nBinsX,
+						def->xMin, def->xMax));
+			is2D.push_back(def->is2D());
+			definitions.push_back(def);
+		}
+	}
+	~TargetHistograms() {
+		for (auto histo : histograms)
+			delete histo;
+	}
+
+	TargetHistograms(const TargetHistograms&) = delete;
+	TargetHistograms& operator=(const TargetHistograms&) = delete;
+
+	void apply(const Fill& fill) {
+		if (is2D[fill.histogram])
+			histograms[fill.histogram]->Fill(fill.x, fill.y);
+		else
+			histograms[fill.histogram]->Fill(fill.x);
+	}
+
+	uint64_t getEntries() const {
+		uint64_t nEntries = 0;
+		for (auto histo : histograms)
+			nEntries += histo->GetEntries();
+		return nEntries;
+	}
+
+	void reset() {
+		for (auto histo : histograms)
+			histo->Reset();
+	}
+};
+
+class FillStrategy {
+protected:
+	string name;
+	TargetHistograms& targets;
+	pthread_rwlock_t rootLock = PTHREAD_RWLOCK_INITIALIZER;
+
+public:
+	FillStrategy(const string& strategyName, TargetHistograms& histograms) :
+			name(strategyName), targets(histograms) {
+	}
+	virtual ~FillStrategy() {
+	}
+
+	FillStrategy(const FillStrategy&) = delete;
+	FillStrategy& operator=(const FillStrategy&) = delete;
+
+	const string& getName() const {
+		return name;
+	}
+
+	// Before the threads of a run are started
+	virtual void start(unsigned nThreads) {
+	}
+	// One group of fills from thread iThread
+	virtual void fill(unsigned iThread, const Fill* begin, const Fill* end) = 0;
+	// By every thread after its last group
+	virtual void finish(unsigned iThread) {
+	}
+	// After the threads ended, everything has to be in the ROOT histograms
+	virtual void merge() {
+	}
+};
+
+class LockedStrategy: public FillStrategy {
+public:
+	LockedStrategy(TargetHistograms& histograms) :
+			FillStrategy("locked", histograms) {
+	}
+	virtual void fill(unsigned iThread, const Fill* begin, const Fill* end) {
+		volatile TimedWriteLock rootRWLock(rootLock);
+		for (const Fill* fill = begin; fill != end; fill++)
+			targets.apply(*fill);
+	}
+};
+
+class CloneStrategy: public FillStrategy {
+protected:
+	vector<vector<TH1*> > clones;
+
+public:
+	CloneStrategy(TargetHistograms& histograms) :
+			FillStrategy("clones", histograms) {
+	}
+	virtual ~CloneStrategy() {
+		start(0);
+	}
+	// Cloning is not thread safe, the clones are made here
+	virtual void start(unsigned nThreads) {
+		for (auto& threadClones : clones)
+			for (auto clone : threadClones)
+				delete clone;
+		clones.assign(nThreads, vector<TH1*>());
+		for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+			for (auto histo : targets.histograms) {
+				stringstream cloneName;
+				cloneName << histo->GetName() << "_thread" << iThread;
+				TH1* clone = static_cast<TH1*>(histo->Clone(cloneName.str().c_str()));
+				clone->Reset();
+				clones[iThread].push_back(clone);
+			}
+		}
+	}
+	virtual void fill(unsigned iThread, const Fill* begin, const Fill* end) {
+		vector<TH1*>& threadClones = clones[iThread];
+		for (const Fill* fill = begin; fill != end; fill++) {
+			if (targets.is2D[fill->histogram])
+				threadClones[fill->histogram]->Fill(fill->x, fill->y);
+			else
+				threadClones[fill->histogram]->Fill(fill->x);
+		}
+	}
+	virtual void merge() {
+		for (auto& threadClones : clones)
+			for (unsigned iHisto = 0; iHisto < threadClones.size(); iHisto++)
+				targets.histograms[iHisto]->Add(threadClones[iHisto]);
+	}
+};
+
+class AtomicStrategy: public FillStrategy {
+protected:
+	vector<unique_ptr<AtomicHistogram> > histograms1D;
+	vector<unique_ptr<AtomicHistogram2D> > histograms2D;
+
+public:
+	AtomicStrategy(TargetHistograms& histograms) :
+			FillStrategy("atomic", histograms) {
+		for (auto def : targets.definitions) {
+			if (def->is2D()) {
+				histograms1D.emplace_back();
+				histograms2D.emplace_back(new AtomicHistogram2D(def->nBinsX, def->xMin,
+						def->xMax, def->nBinsY, def->yMin, def->yMax));
+			} else {
+				histograms1D.emplace_back(new AtomicHistogram(def->nBinsX, def->xMin, def->xMax));
+				histograms2D.emplace_back();
+			}
+		}
+	}
+	virtual void fill(unsigned iThread, const Fill* begin, const Fill* end) {
+		for (const Fill* fill = begin; fill != end; fill++) {
+			if (targets.is2D[fill->histogram])
+				histograms2D[fill->histogram]->fill(fill->x, fill->y);
+			else
+				histograms1D[fill->histogram]->fill(fill->x);
+		}
+	}
+	// As JEventProcessor_TAC_Monitor::moveAtomicHistograms()
+	virtual void merge() {
+		for (unsigned iHisto = 0; iHisto < targets.histograms.size(); iHisto++) {
+			TH1* histo = targets.histograms[iHisto];
+			TArrayD* cellArray = dynamic_cast<TArrayD*>(histo);
+			uint64_t nMoved = targets.is2D[iHisto] ?
+					histograms2D[iHisto]->moveTo(cellArray->fArray) :
+					histograms1D[iHisto]->moveTo(cellArray->fArray);
+			histo->SetEntries(histo->GetEntries() + nMoved);
+		}
+	}
+};
+
+class JournalStrategy: public FillStrategy {
+protected:
+	// Padded so that the journals of two threads do not share a cache line
+	struct Journal {
+		vector<Fill> entries;
+		char padding[64];
+	};
+	size_t journalSize;
+	vector<unique_ptr<Journal> > journals;
+
+	void commit(Journal& journal) {
+		volatile TimedWriteLock rootRWLock(rootLock);
+		for (auto& fill : journal.entries)
+			targets.apply(fill);
+		journal.entries.clear();
+	}
+
+public:
+	JournalStrategy(TargetHistograms& histograms, size_t size) :
+			FillStrategy("journal", histograms), journalSize(size) {
+	}
+	virtual void start(unsigned nThreads) {
+		journals.clear();
+		for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+			journals.emplace_back(new Journal());
+			journals.back()->entries.reserve(journalSize + 64);
+		}
+	}
+	// The groups are not split, the journal is committed after the one that
+	// filled it
+	virtual void fill(unsigned iThread, const Fill* begin, const Fill* end) {
+		Journal& journal = *journals[iThread];
+		journal.entries.insert(journal.entries.end(), begin, end);
+		if (journal.entries.size() >= journalSize)
+			commit(journal);
+	}
+	virtual void finish(unsigned iThread) {
+		commit(*journals[iThread]);
+	}
+};
+
+// Value below which the given fraction of the latencies is
+static uint32_t getPercentile(vector<uint32_t>& latencies, double fraction) {
+	if (latencies.empty())
+		return 0;
+	size_t index = min(latencies.size() - 1, size_t(fraction * latencies.size()));
+	nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+	return latencies[index];
+}
+
+// Read up to maxEvents events from feature files, the cut values are taken
+// from the first file
+static bool readFeatureFiles(const vector<string>& fileNames, size_t maxEvents,
+		FillStream& stream) {
+	using namespace TACFeatureFormat;
+	bool first = true;
+	size_t nEvents = 0;
+	Block block;
+	for (auto& fileName : fileNames) {
+		FileReader reader;
+		if (!reader.open(fileName)) {
+			cerr << "tac_fill_bench: " << reader.getErrorMessage() << endl;
+			return false;
+		}
+		const FileHeader& header = reader.getHeader();
+		if (first) {
+			stream.timeCutValue_TAGH = header.taghTimeCutValue;
+			stream.timeCutValue_TAGM = header.tagmTimeCutValue;
+			stream.timeCutWidth = header.timeCutWidth;
+			first = false;
+		}
+		for (size_t iBlock = 0; iBlock < reader.getNumberOfBlocks() && nEvents < maxEvents; iBlock++) {
+			if (!reader.decodeBlock(iBlock, block)) {
+				cerr << "tac_fill_bench: block " << iBlock << " of " << fileName
+						<< " is corrupt" << endl;
+				continue;
+			}
+			auto& columns = block.columns;
+			size_t taghStart = 0, tagmStart = 0;
+			for (uint32_t iEvent = 0; iEvent < block.nEvents && nEvents < maxEvents; iEvent++) {
+				EventSummary event;
+				event.nPulses = columns[N_PULSES].ints[iEvent];
+				event.pulsePeak = columns[PULSE_PEAK].reals[iEvent];
+				event.pulseTime = columns[PULSE_TIME].reals[iEvent];
+				event.pulseIntegral = columns[PULSE_INTEGRAL].reals[iEvent];
+				event.waveMax = columns[WAVE_PEAK].ints[iEvent];
+				event.waveTime = columns[WAVE_TIME].ints[iEvent] * header.fadc250RawTimeScale;
+				uint64_t nTAGH = columns[N_TAGH_HITS].ints[iEvent];
+				uint64_t nTAGM = columns[N_TAGM_HITS].ints[iEvent];
+				for (uint64_t iHit = 0; iHit < nTAGH; iHit++)
+					event.taghHits.push_back(TACEventData::TaggerHit { unsigned(
+							columns[TAGH_COUNTER].ints[taghStart + iHit]),
+							columns[TAGH_TIME].reals[taghStart + iHit] });
+				for (uint64_t iHit = 0; iHit < nTAGM; iHit++)
+					event.tagmHits.push_back(TACEventData::TaggerHit { unsigned(
+							columns[TAGM_COUNTER].ints[tagmStart + iHit]),
+							columns[TAGM_TIME].reals[tagmStart + iHit] });
+				taghStart += nTAGH;
+				tagmStart += nTAGM;
+				stream.addEvent(event);
+				nEvents++;
+			}
+		}
+	}
+	return nEvents > 0;
+}
+
+static void generateEvents(const TACEventGenerator::Config& config, size_t nEvents,
+		FillStream& stream) {
+	TACEventGenerator generator(config);
+	TACEventData eventData;
+	for (size_t iEvent = 0; iEvent < nEvents; iEvent++) {
+		generator.generate(eventData, iEvent + 1);
+		EventSummary event;
+		event.nPulses = eventData.pulses.size();
+		event.pulsePeak = eventData.pulses[0].peak;
+		event.pulseTime = eventData.pulses[0].time;
+		event.pulseIntegral = eventData.pulses[0].integral;
+		auto maxIter = max_element(eventData.samples.begin(), eventData.samples.end());
+		event.waveMax = *maxIter;
+		event.waveTime = 4.0 * (maxIter - eventData.samples.begin());
+		event.taghHits = eventData.taghHits;
+		event.tagmHits = eventData.tagmHits;
+		stream.addEvent(event);
+	}
+}
+
+static void usage() {
+	cout << "Usage:" << endl << "   tac_fill_bench [options] [tac_features_<run>.bin ...]" << endl << endl
+			<< "The fills are taken from the feature files if any are given, otherwise" << endl
+			<< "from generated events." << endl << endl
+			<< "Options:" << endl
+			<< "   -n events      events per thread (default 100000)" << endl
+			<< "   -t threads     maximum number of threads (default: number of cores)" << endl
+			<< "   -S strategies  comma-separated list of locked, clones, atomic, journal" << endl
+			<< "                  (default: all of them)" << endl
+			<< "   -j fills       journal size (default 1024)" << endl
+			<< "   -H mult        mean TAGH multiplicity of generated events (default 20)" << endl
+			<< "   -M mult        mean TAGM multiplicity of generated events (default 10)" << endl
+			<< "   -p size        number of events that are replayed (default 10000)" << endl
+			<< "   -h             print this message" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	TACEventGenerator::Config config;
+	uint64_t eventsPerThread = 100000;
+	unsigned maxThreads = thread::hardware_concurrency();
+	size_t poolSize = 10000;
+	size_t journalSize = 1024;
+	string strategyList = "locked,clones,atomic,journal";
+
+	int option;
+	while ((option = getopt(argc, argv, "n:t:S:j:H:M:p:h")) != -1) {
+		switch (option) {
+		case 'n':
+			eventsPerThread = strtoull(optarg, nullptr, 10);
+			break;
+		case 't':
+			maxThreads = atoi(optarg);
+			break;
+		case 'S':
+			strategyList = optarg;
+			break;
+		case 'j':
+			journalSize = strtoull(optarg, nullptr, 10);
+			break;
+		case 'H':
+			config.taghMultiplicity = atof(optarg);
+			break;
+		case 'M':
+			config.tagmMultiplicity = atof(optarg);
+			break;
+		case 'p':
+			poolSize = strtoull(optarg, nullptr, 10);
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+	if (maxThreads < 1)
+		maxThreads = 1;
+	if (poolSize < 1)
+		poolSize = 1;
+	if (journalSize < 1)
+		journalSize = 1;
+
+	FillStream stream;
+	vector<string> fileNames(argv + optind, argv + argc);
+	if (fileNames.empty()) {
+		generateEvents(config, poolSize, stream);
+	} else if (!readFeatureFiles(fileNames, poolSize, stream)) {
+		cerr << "tac_fill_bench: no events read" << endl;
+		return -1;
+	}
+	poolSize = stream.eventEnds.size();
+
+	unique_ptr<TargetHistograms> targets;
+	try {
+		targets.reset(new TargetHistograms(stream.getKeys()));
+	} catch (exception& error) {
+		cerr << "tac_fill_bench: " << error.what() << endl;
+		return -1;
+	}
+	vector<unique_ptr<FillStrategy> > strategies;
+	stringstream strategyStream(strategyList);
+	string strategyName;
+	while (getline(strategyStream, strategyName, ',')) {
+		if (strategyName == "locked")
+			strategies.emplace_back(new LockedStrategy(*targets));
+		else if (strategyName == "clones")
+			strategies.emplace_back(new CloneStrategy(*targets));
+		else if (strategyName == "atomic")
+			strategies.emplace_back(new AtomicStrategy(*targets));
+		else if (strategyName == "journal")
+			strategies.emplace_back(new JournalStrategy(*targets, journalSize));
+		else {
+			cerr << "tac_fill_bench: unknown strategy " << strategyName << endl;
+			return -1;
+		}
+	}
+
+	size_t nTwoDimensional = 0;
+	for (auto& fill : stream.fills)
+		nTwoDimensional += targets->is2D[fill.histogram];
+	cout << poolSize << " events, " << setprecision(3)
+			<< double(stream.fills.size()) / poolSize << " fills and "
+			<< double(stream.groupEnds.size()) / poolSize << " lock sections per event, "
+			<< 100.0 * nTwoDimensional / stream.fills.size() << "% 2D fills, "
+			<< eventsPerThread << " events per thread" << endl;
+
+	for (auto& strategy : strategies) {
+		cout << endl << "Strategy " << strategy->getName() << ", latency of a lock section in ns" << endl;
+		cout << setw(8) << "threads" << setw(14) << "fills/s" << setw(14) << "per thread"
+				<< setw(10) << "speedup" << setw(9) << "p50" << setw(9) << "p99"
+				<< setw(9) << "p99.9" << setw(10) << "max" << setw(11) << "merge ms" << endl;
+		double singleThreadRate = 0;
+		for (unsigned nThreads = 1; nThreads <= maxThreads; nThreads++) {
+			targets->reset();
+			strategy->start(nThreads);
+			vector<vector<uint32_t> > latencies(nThreads);
+			// All fills including the warm-up and the measured ones
+			vector<uint64_t> nFills(nThreads, 0);
+			vector<uint64_t> nMeasuredFills(nThreads, 0);
+			vector<thread> workers;
+			atomic<unsigned> nReady(0);
+			atomic<bool> go(false);
+			for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+				workers.emplace_back([&, iThread]() {
+					const size_t nGroups = stream.groupEnds.size();
+					for (size_t iWarmUp = 0; iWarmUp < warmUpGroups; iWarmUp++) {
+						size_t iGroup = (iThread + iWarmUp) % nGroups;
+						strategy->fill(iThread, &stream.fills[stream.getGroupStart(iGroup)],
+								&stream.fills[0] + stream.groupEnds[iGroup]);
+					}
+					for (size_t iWarmUp = 0; iWarmUp < warmUpGroups; iWarmUp++) {
+						size_t iGroup = (iThread + iWarmUp) % nGroups;
+						nFills[iThread] += stream.groupEnds[iGroup] - stream.getGroupStart(iGroup);
+					}
+					vector<uint32_t>& threadLatencies = latencies[iThread];
+					threadLatencies.reserve(eventsPerThread * nGroups / poolSize + 1000);
+					nReady++;
+					while (!go)
+						this_thread::yield();
+					// Threads start at different places in the pool
+					size_t iEvent = (size_t(iThread) * poolSize) / nThreads;
+					uint64_t threadFills = 0;
+					for (uint64_t iProcessed = 0; iProcessed < eventsPerThread; iProcessed++) {
+						for (size_t iGroup = stream.getEventStart(iEvent);
+								iGroup < stream.eventEnds[iEvent]; iGroup++) {
+							const Fill* begin = &stream.fills[0] + stream.getGroupStart(iGroup);
+							const Fill* end = &stream.fills[0] + stream.groupEnds[iGroup];
+							auto startTime = chrono::steady_clock::now();
+							strategy->fill(iThread, begin, end);
+							threadLatencies.push_back(chrono::duration_cast<chrono::nanoseconds>(
+									chrono::steady_clock::now() - startTime).count());
+							threadFills += end - begin;
+						}
+						if (++iEvent == poolSize)
+							iEvent = 0;
+					}
+					strategy->finish(iThread);
+					nMeasuredFills[iThread] = threadFills;
+				});
+			}
+			while (nReady < nThreads)
+				this_thread::yield();
+			auto startTime = chrono::steady_clock::now();
+			go = true;
+			for (auto& worker : workers)
+				worker.join();
+			double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+			auto mergeStart = chrono::steady_clock::now();
+			strategy->merge();
+			double mergeTime = chrono::duration<double, milli>(chrono::steady_clock::now() - mergeStart).count();
+
+			uint64_t totalFills = 0, expectedEntries = 0;
+			vector<uint32_t> allLatencies;
+			for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+				totalFills += nMeasuredFills[iThread];
+				expectedEntries += nFills[iThread] + nMeasuredFills[iThread];
+				allLatencies.insert(allLatencies.end(), latencies[iThread].begin(),
+						latencies[iThread].end());
+				vector<uint32_t>().swap(latencies[iThread]);
+			}
+			double rate = totalFills / elapsed;
+			if (nThreads == 1)
+				singleThreadRate = rate;
+			cout << setw(8) << nThreads << setw(14) << fixed << setprecision(0) << rate
+					<< setw(14) << rate / nThreads << setw(10) << setprecision(2)
+					<< rate / singleThreadRate << setw(9) << getPercentile(allLatencies, 0.5)
+					<< setw(9) << getPercentile(allLatencies, 0.99)
+					<< setw(9) << getPercentile(allLatencies, 0.999)
+					<< setw(10) << *max_element(allLatencies.begin(), allLatencies.end())
+					<< setw(11) << setprecision(2) << mergeTime << endl;
+			if (uint64_t(targets->getEntries()) != expectedEntries)
+				cerr << "tac_fill_bench: " << strategy->getName() << " lost "
+						<< int64_t(expectedEntries - targets->getEntries()) << " fills" << endl;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,339 @@
+/*
+ * tac_merge.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Merge the tac_monitor_<run>.root files written by the TAC_Monitor plugin.
+ *  The files are read by a pool of threads, each thread accumulates the files
+ *  it read, and the per-thread results are then combined pairwise in a tree.
+ *  The histogram set is known from TACHistogramDefinitions.h: TACFADCRAW keeps
+ *  the waveform from the latest run and TACFADCRAW_AVG is recomputed from the
+ *  merged TACFADCRAW_SUM and TACFADCRAW_ENTRIES. Histograms can be weighted
+ *  per run number when files from different runs are merged.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "TROOT.h"
+#include "TFile.h"
+#include "TKey.h"
+#include "TH1.h"
+
+#include "TACHistogramDefinitions.h"
+
+using namespace std;
+
+// Ordering of the histogram sources, used to pick the latest TACFADCRAW
+struct SourceOrder {
+	int runNumber = -1;
+	size_t fileIndex = 0;
+
+	bool operator<(const SourceOrder& other) const {
+		if (runNumber != other.runNumber)
+			return runNumber < other.runNumber;
+		return fileIndex < other.fileIndex;
+	}
+};
+
+// Histograms accumulated from one or more files, keyed by histogram name
+class HistogramSet {
+protected:
+	struct Entry {
+		unique_ptr<TH1> histo;
+		TACHistogramDefinition::MergeMode mergeMode;
+		SourceOrder order;
+	};
+	map<string, Entry> entryMap;
+	unsigned nFiles = 0;
+
+public:
+	// Take ownership of a histogram read from a file with the given weight
+	void insert(TH1* histo, double weight, SourceOrder order) {
+		string key;
+		unsigned trigBit;
+		auto mergeMode = TACHistogramDefinition::MERGE_ADD;
+		if (splitTACHistogramName(histo->GetName(), key, trigBit)) {
+			auto definition = findTACHistogramDefinition(key);
+			if (definition != nullptr)
+				mergeMode = definition->mergeMode;
+		}
+		if (mergeMode == TACHistogramDefinition::MERGE_ADD && weight != 1.0)
+			histo->Scale(weight);
+
+		Entry entry;
+		entry.histo.reset(histo);
+		entry.mergeMode = mergeMode;
+		entry.order = order;
+		merge(histo->GetName(), std::move(entry));
+	}
+
+	// Merge all histograms of the other set into this one
+	void merge(HistogramSet& other) {
+		for (auto& entryPair : other.entryMap)
+			merge(entryPair.first, std::move(entryPair.second));
+		other.entryMap.clear();
+		nFiles += other.nFiles;
+		other.nFiles = 0;
+	}
+
+	// Recompute the average waveforms from the merged sums and entries, and
+	// the tagger efficiencies from the merged matched and total hits
+	void computeAverages() {
+		for (auto& entryPair : entryMap) {
+			auto& entry = entryPair.second;
+			if (entry.mergeMode != TACHistogramDefinition::MERGE_AVERAGE
+					&& entry.mergeMode != TACHistogramDefinition::MERGE_EFFICIENCY)
+				continue;
+			string key;
+			unsigned trigBit;
+			if (!splitTACHistogramName(entryPair.first, key, trigBit))
+				continue;
+			stringstream sumName, entriesName;
+			if (entry.mergeMode == TACHistogramDefinition::MERGE_AVERAGE) {
+				sumName << "TACFADCRAW_SUM_" << trigBit;
+				entriesName << "TACFADCRAW_ENTRIES_" << trigBit;
+			} else {
+				string detComp = key.substr(0, key.find('_'));
+				sumName << detComp << "_ID_MATCHEDPULSE_" << trigBit;
+				entriesName << detComp << "_ID_PULSE_" << trigBit;
+			}
+			auto sumIter = entryMap.find(sumName.str());
+			auto entriesIter = entryMap.find(entriesName.str());
+			if (sumIter == entryMap.end() || entriesIter == entryMap.end())
+				continue;
+			entry.histo->Reset();
+			entry.histo->Divide(sumIter->second.histo.get(),
+					entriesIter->second.histo.get(), 1, 1,
+					entry.mergeMode == TACHistogramDefinition::MERGE_EFFICIENCY ? "B" : "");
+		}
+	}
+
+	void write(TDirectory* dir) {
+		dir->cd();
+		for (auto& entryPair : entryMap)
+			entryPair.second.histo->Write();
+	}
+
+	void countFile() {
+		nFiles++;
+	}
+
+	unsigned getNumberOfFiles() const {
+		return nFiles;
+	}
+
+	size_t size() const {
+		return entryMap.size();
+	}
+
+protected:
+	void merge(const string& name, Entry&& entry) {
+		auto entryIter = entryMap.find(name);
+		if (entryIter == entryMap.end()) {
+			entryMap[name] = std::move(entry);
+			return;
+		}
+		auto& current = entryIter->second;
+		switch (current.mergeMode) {
+		case TACHistogramDefinition::MERGE_ADD:
+			current.histo->Add(entry.histo.get());
+			break;
+		case TACHistogramDefinition::MERGE_LATEST:
+			if (current.order < entry.order)
+				current = std::move(entry);
+			break;
+		case TACHistogramDefinition::MERGE_AVERAGE:
+		case TACHistogramDefinition::MERGE_EFFICIENCY:
+			// Recomputed by computeAverages() once everything is merged
+			break;
+		}
+	}
+};
+
+// Extract the run number from a tac_monitor_<run>.root file name, -1 if there is none
+static int getRunNumber(const string& fileName) {
+	string baseName = fileName.substr(fileName.find_last_of('/') + 1);
+	const string prefix = "tac_monitor_";
+	auto prefixPos = baseName.find(prefix);
+	if (prefixPos == string::npos)
+		return -1;
+	string runString = baseName.substr(prefixPos + prefix.size());
+	runString = runString.substr(0, runString.find('.'));
+	if (runString.empty() || runString.find_first_not_of("0123456789") != string::npos)
+		return -1;
+	return atoi(runString.c_str());
+}
+
+// Read all histograms of a file into the set, returns false on error
+static bool readFile(const string& fileName, size_t fileIndex,
+		const map<int, double>& runWeights, HistogramSet& histoSet) {
+	unique_ptr<TFile> inFile(TFile::Open(fileName.c_str(), "READ"));
+	if (!inFile || inFile->IsZombie()) {
+		cerr << "Could not open " << fileName << endl;
+		return false;
+	}
+	SourceOrder order;
+	order.runNumber = getRunNumber(fileName);
+	order.fileIndex = fileIndex;
+	double weight = 1.0;
+	auto weightIter = runWeights.find(order.runNumber);
+	if (weightIter != runWeights.end())
+		weight = weightIter->second;
+
+	// Only the highest cycle of each key is used
+	map<string, TKey*> keyMap;
+	TIter nextKey(inFile->GetListOfKeys());
+	while (TKey* key = dynamic_cast<TKey*>(nextKey())) {
+		auto keyIter = keyMap.find(key->GetName());
+		if (keyIter == keyMap.end() || keyIter->second->GetCycle() < key->GetCycle())
+			keyMap[key->GetName()] = key;
+	}
+	for (auto& keyPair : keyMap) {
+		TH1* histo = dynamic_cast<TH1*>(keyPair.second->ReadObj());
+		if (histo == nullptr)
+			continue;
+		histo->SetDirectory(nullptr);
+		histoSet.insert(histo, weight, order);
+	}
+	histoSet.countFile();
+	return true;
+}
+
+static void readWeightFile(const string& fileName, map<int, double>& runWeights) {
+	ifstream weightStream(fileName);
+	if (!weightStream) {
+		cerr << "Could not open weight file " << fileName << endl;
+		exit(-1);
+	}
+	string line;
+	while (getline(weightStream, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+		stringstream lineStream(line);
+		int runNumber;
+		double weight;
+		if (lineStream >> runNumber >> weight)
+			runWeights[runNumber] = weight;
+	}
+}
+
+static void usage() {
+	cout << "Usage:" << endl
+			<< "   tac_merge [options] file1.root file2.root ..." << endl << endl
+			<< "Options:" << endl
+			<< "   -o file      output file name (default tac_monitor_merged.root)" << endl
+			<< "   -j n         number of threads (default: number of cores)" << endl
+			<< "   -w run=wgt   weight for the histograms of a run (can be repeated)" << endl
+			<< "   -W file      file with \"run weight\" lines" << endl
+			<< "   -h           print this message" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	string outFileName = "tac_monitor_merged.root";
+	unsigned nThreads = thread::hardware_concurrency();
+	map<int, double> runWeights;
+
+	int option;
+	while ((option = getopt(argc, argv, "o:j:w:W:h")) != -1) {
+		switch (option) {
+		case 'o':
+			outFileName = optarg;
+			break;
+		case 'j':
+			nThreads = atoi(optarg);
+			break;
+		case 'w': {
+			string weightString = optarg;
+			auto equalPos = weightString.find('=');
+			if (equalPos == string::npos) {
+				usage();
+				return -1;
+			}
+			runWeights[atoi(weightString.substr(0, equalPos).c_str())] = atof(
+					weightString.substr(equalPos + 1).c_str());
+			break;
+		}
+		case 'W':
+			readWeightFile(optarg, runWeights);
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+	vector<string> inFileNames(argv + optind, argv + argc);
+	if (inFileNames.empty()) {
+		usage();
+		return -1;
+	}
+	if (nThreads < 1)
+		nThreads = 1;
+	if (nThreads > inFileNames.size())
+		nThreads = inFileNames.size();
+
+	ROOT::EnableThreadSafety();
+	TH1::AddDirectory(false);
+	auto startTime = chrono::steady_clock::now();
+
+	// Each thread reads files from the common list and accumulates them
+	vector<HistogramSet> threadSets(nThreads);
+	atomic<size_t> nextFile(0);
+	atomic<unsigned> nErrors(0);
+	vector<thread> workers;
+	for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+		workers.emplace_back([&, iThread]() {
+			for (size_t iFile = nextFile++; iFile < inFileNames.size(); iFile = nextFile++) {
+				if (!readFile(inFileNames[iFile], iFile, runWeights, threadSets[iThread]))
+					nErrors++;
+			}
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	// Tree reduction of the per-thread sets, each level merges pairs in parallel
+	for (size_t stride = 1; stride < threadSets.size(); stride *= 2) {
+		workers.clear();
+		for (size_t iSet = 0; iSet + stride < threadSets.size(); iSet += 2 * stride) {
+			workers.emplace_back([&threadSets, iSet, stride]() {
+				threadSets[iSet].merge(threadSets[iSet + stride]);
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	HistogramSet& mergedSet = threadSets[0];
+	mergedSet.computeAverages();
+
+	TFile outFile(outFileName.c_str(), "RECREATE");
+	if (outFile.IsZombie()) {
+		cerr << "Could not create " << outFileName << endl;
+		return -1;
+	}
+	mergedSet.write(&outFile);
+	outFile.Close();
+
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+	cout << "Merged " << mergedSet.size() << " histograms from "
+			<< mergedSet.getNumberOfFiles() << " files into " << outFileName
+			<< " using " << nThreads << " threads in " << elapsed << " s" << endl;
+	if (nErrors > 0) {
+		cerr << nErrors << " files could not be read" << endl;
+		return 1;
+	}
+	return 0;
+}
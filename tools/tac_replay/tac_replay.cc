@@ -0,0 +1,562 @@
+/*
+ * tac_replay.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Regenerate the TAC_Monitor histograms from the tac_features_<run>.bin files
+ *  with new timing windows and TAC threshold, without running hd_ana. The
+ *  files are memory-mapped and their blocks are processed by a pool of
+ *  threads. Every thread fills its own plain bin arrays, the tagger time cuts
+ *  of a whole block are evaluated in one loop over the time column, and the
+ *  per-thread results are added in a tree at the end. The histograms are the
+ *  set from TACHistogramDefinitions.h, filled the same way as the plugin does.
+ *
+ *  Files that only hold the tagger hits within a window around the cuts
+ *  (TAC:FEATURES_TAGGER_WINDOW) are refused unless -p is given, the tagger
+ *  histograms made from them do not count the hits outside the window.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TH1.h"
+#include "TH2.h"
+
+#include "TACHistogramDefinitions.h"
+#include "TACFeatureFormat.h"
+
+using namespace std;
+using namespace TACFeatureFormat;
+
+// Cuts and constants used to fill the histograms, the defaults are the plugin ones
+struct ReplayConfig {
+	uint32_t triggerMask = 0b00000010;
+	unsigned numberOfTriggerBits = 16;
+	double timeCutValue_TAGH = 100.0;
+	double timeCutWidth_TAGH = 20.0;
+	double timeCutValue_TAGM = 90.0;
+	double timeCutWidth_TAGM = 20.0;
+	unsigned tacThreshold = 200;
+	unsigned maxPulseValue = 4095;
+	unsigned overflowPulseValue = 4500;
+	double fadc250RawTimeScale = 4.0;
+};
+
+// Fixed-bin histogram with the ROOT cell layout (underflow and overflow included)
+class BinnedHistogram {
+protected:
+	int nBinsX = 0;
+	double xMin = 0, xMax = 0;
+	int nBinsY = 0;
+	double yMin = 0, yMax = 0;
+	vector<double> cells;
+	double entries = 0;
+
+	// Same bin finding as TAxis::FindBin for fixed bins
+	static int findBin(double value, int nBins, double low, double high) {
+		if (value < low)
+			return 0;
+		if (!(value < high))
+			return nBins + 1;
+		return 1 + int(nBins * (value - low) / (high - low));
+	}
+
+public:
+	void define(const TACHistogramDefinition& definition) {
+		nBinsX = definition.nBinsX;
+		xMin = definition.xMin;
+		xMax = definition.xMax;
+		nBinsY = definition.is2D() ? definition.nBinsY : 0;
+		yMin = definition.yMin;
+		yMax = definition.yMax;
+		cells.assign(size_t(nBinsX + 2) * (nBinsY > 0 ? nBinsY + 2 : 1), 0.0);
+	}
+
+	void fill(double x) {
+		cells[findBin(x, nBinsX, xMin, xMax)] += 1.0;
+		entries++;
+	}
+	void fill(double x, double y) {
+		cells[findBin(x, nBinsX, xMin, xMax)
+				+ (nBinsX + 2) * findBin(y, nBinsY, yMin, yMax)] += 1.0;
+		entries++;
+	}
+	double& cell(int bin) {
+		return cells[bin];
+	}
+	int getNbinsX() const {
+		return nBinsX;
+	}
+
+	void add(const BinnedHistogram& other) {
+		for (size_t iCell = 0; iCell < cells.size(); iCell++)
+			cells[iCell] += other.cells[iCell];
+		entries += other.entries;
+	}
+
+	// Copy the contents into a ROOT histogram with the same binning
+	void copyTo(TH1* histo) const {
+		for (size_t iCell = 0; iCell < cells.size(); iCell++) {
+			if (cells[iCell] != 0)
+				histo->SetBinContent(iCell, cells[iCell]);
+		}
+		histo->ResetStats();
+		if (entries > 0)
+			histo->SetEntries(entries);
+	}
+};
+
+// Indices into the histogram table of the histograms filled per detector and method
+struct TaggerHistogramIndex {
+	int id, sigTime, timeVsId;
+	// Hits with a TAC pulse, the denominator of the efficiency
+	int idPulse;
+	// Index 0 for WAVE, 1 for PULSE
+	int matchedId[2], tacTimeVsTime[2], tacAmpVsId[2];
+};
+
+static int histogramIndex(const string& key) {
+	auto& definitions = getTACHistogramDefinitions();
+	for (size_t iDef = 0; iDef < definitions.size(); iDef++) {
+		if (definitions[iDef].key == key)
+			return iDef;
+	}
+	cerr << "Unknown histogram " << key << endl;
+	exit(-1);
+}
+
+static TaggerHistogramIndex taggerHistogramIndex(const string& detComp) {
+	TaggerHistogramIndex index;
+	index.id = histogramIndex(detComp + "_ID");
+	index.sigTime = histogramIndex(detComp + "SigTime");
+	index.timeVsId = histogramIndex(detComp + "TIMEvs" + detComp + "ID");
+	index.idPulse = histogramIndex(detComp + "_ID_PULSE");
+	const string methods[2] = { "WAVE", "PULSE" };
+	for (unsigned iMethod = 0; iMethod < 2; iMethod++) {
+		index.matchedId[iMethod] = histogramIndex(detComp + "_ID_MATCHED" + methods[iMethod]);
+		index.tacTimeVsTime[iMethod] = histogramIndex("TACTIME" + methods[iMethod] + "vs" + detComp + "TIME");
+		index.tacAmpVsId[iMethod] = histogramIndex("TACAMP" + methods[iMethod] + "vs" + detComp + "ID");
+	}
+	return index;
+}
+
+// Histograms of all useful trigger bits filled by one thread
+class ReplaySet {
+protected:
+	const ReplayConfig& config;
+	// Histograms per trigger bit, in the order of the definition table
+	vector<vector<BinnedHistogram> > histograms;
+	vector<unsigned> trigBits;
+
+	int iRaw, iRawSum, iRawEntries, iNHits, iNTDCHits, iTDCTime, iTDCADCTime,
+			iAmpPulse, iAmpWave, iIntegral, iTimePulse, iTimeWave;
+	TaggerHistogramIndex taghIndex, tagmIndex;
+
+	// Waveform of the latest event for TACFADCRAW
+	vector<uint16_t> latestSamples;
+	pair<int32_t, uint64_t> latestEvent = { -1, 0 };
+
+	// Cut results for all tagger hits of a block
+	vector<uint8_t> taghMatched, tagmMatched;
+
+	uint64_t nEvents = 0;
+
+	void fillTagger(vector<BinnedHistogram>& hists,
+			const TaggerHistogramIndex& index, unsigned method, double tacPeak,
+			double tacTime, const uint64_t* counters, const double* times,
+			const uint8_t* matched, uint64_t nHits) {
+		for (uint64_t iHit = 0; iHit < nHits; iHit++) {
+			double detID = counters[iHit];
+			double tagTime = times[iHit];
+			hists[index.id].fill(detID);
+			if (method == 1)
+				hists[index.idPulse].fill(detID);
+			hists[index.sigTime].fill(tagTime);
+			hists[index.tacTimeVsTime[method]].fill(tagTime, tacTime);
+			hists[index.timeVsId].fill(detID, tagTime);
+			if (matched[iHit]) {
+				hists[index.matchedId[method]].fill(detID);
+				hists[index.tacAmpVsId[method]].fill(detID, tacPeak);
+			}
+		}
+	}
+
+	// Evaluate |t - value| < width for all hits of the block in one pass
+	static void evaluateTimeCut(const vector<double>& times, double value,
+			double width, vector<uint8_t>& matched) {
+		size_t nHits = times.size();
+		matched.resize(nHits);
+		const double* time = times.data();
+		uint8_t* result = matched.data();
+		for (size_t iHit = 0; iHit < nHits; iHit++)
+			result[iHit] = fabs(time[iHit] - value) < width;
+	}
+
+public:
+	ReplaySet(const ReplayConfig& conf) :
+			config(conf) {
+		auto& definitions = getTACHistogramDefinitions();
+		for (unsigned trigBit = 0; trigBit < config.numberOfTriggerBits; trigBit++) {
+			if ((config.triggerMask & (1u << trigBit)) == 0)
+				continue;
+			trigBits.push_back(trigBit);
+			histograms.emplace_back(definitions.size());
+			for (size_t iDef = 0; iDef < definitions.size(); iDef++)
+				histograms.back()[iDef].define(definitions[iDef]);
+		}
+		iRaw = histogramIndex("TACFADCRAW");
+		iRawSum = histogramIndex("TACFADCRAW_SUM");
+		iRawEntries = histogramIndex("TACFADCRAW_ENTRIES");
+		iNHits = histogramIndex("TAC_NHITS");
+		iNTDCHits = histogramIndex("TAC_NTDCHITS");
+		iTDCTime = histogramIndex("TAC_TDCTIME");
+		iTDCADCTime = histogramIndex("TAC_TDCADCTIME");
+		iAmpPulse = histogramIndex("TACAmpPULSE");
+		iAmpWave = histogramIndex("TACAmpWAVE");
+		iIntegral = histogramIndex("TACIntegral");
+		iTimePulse = histogramIndex("TACTimePULSE");
+		iTimeWave = histogramIndex("TACTimeWAVE");
+		taghIndex = taggerHistogramIndex("TAGH");
+		tagmIndex = taggerHistogramIndex("TAGM");
+	}
+
+	// decodeBlock() has checked the lengths of the columns
+	void process(const Block& block, bool hasSamples) {
+		auto& columns = block.columns;
+		hasSamples = hasSamples && columns[N_SAMPLES].size() == block.nEvents;
+		evaluateTimeCut(columns[TAGH_TIME].reals, config.timeCutValue_TAGH,
+				config.timeCutWidth_TAGH, taghMatched);
+		evaluateTimeCut(columns[TAGM_TIME].reals, config.timeCutValue_TAGM,
+				config.timeCutWidth_TAGM, tagmMatched);
+
+		// Positions in the variable length columns
+		size_t sampleStart = 0, tdcStart = 0, taghStart = 0, tagmStart = 0;
+		for (uint32_t iEvent = 0; iEvent < block.nEvents; iEvent++) {
+			uint64_t nSamples = hasSamples ? columns[N_SAMPLES].ints[iEvent] : 0;
+			uint64_t nTDCTimes = columns[N_TDC_TIMES].ints[iEvent];
+			uint64_t nTAGH = columns[N_TAGH_HITS].ints[iEvent];
+			uint64_t nTAGM = columns[N_TAGM_HITS].ints[iEvent];
+			const uint64_t* samples = columns[SAMPLES].ints.data() + sampleStart;
+			uint32_t eventTriggerMask = columns[TRIGGER_MASK].ints[iEvent];
+			bool singleWaveform = columns[N_WAVEFORMS].ints[iEvent] == 1;
+
+			// WAVE quantities, recomputed from the samples when they are there
+			double waveMax = columns[WAVE_PEAK].ints[iEvent];
+			double waveTime = columns[WAVE_TIME].ints[iEvent];
+			if (singleWaveform && hasSamples) {
+				waveMax = 0;
+				waveTime = 0;
+				bool crossed = false;
+				for (uint64_t iSample = 0; iSample < nSamples; iSample++) {
+					if (samples[iSample] > waveMax)
+						waveMax = samples[iSample];
+					if (!crossed && samples[iSample] > config.tacThreshold) {
+						waveTime = iSample;
+						crossed = true;
+					}
+				}
+				pair<int32_t, uint64_t> thisEvent(block.runNumber,
+						columns[EVENT_NUMBER].ints[iEvent]);
+				if (latestEvent < thisEvent) {
+					latestEvent = thisEvent;
+					latestSamples.assign(samples, samples + nSamples);
+				}
+			}
+			if (waveMax >= config.maxPulseValue)
+				waveMax = config.overflowPulseValue;
+
+			double pulsePeak = columns[PULSE_PEAK].reals[iEvent];
+			double pulseTime = columns[PULSE_TIME].reals[iEvent];
+			double pulseIntegral = columns[PULSE_INTEGRAL].reals[iEvent];
+			if (pulsePeak >= config.maxPulseValue) {
+				pulsePeak = config.overflowPulseValue;
+				pulseIntegral = config.overflowPulseValue * 3.0;
+			}
+
+			for (size_t iBit = 0; iBit < trigBits.size(); iBit++) {
+				if ((eventTriggerMask & (1u << trigBits[iBit])) == 0)
+					continue;
+				auto& hists = histograms[iBit];
+				if (singleWaveform) {
+					if (hasSamples) {
+						int nBins = hists[iRawSum].getNbinsX();
+						for (uint64_t iSample = 0; iSample < nSamples && int(iSample) < nBins; iSample++) {
+							hists[iRawEntries].cell(iSample + 1) += 1.0;
+							hists[iRawSum].cell(iSample + 1) += samples[iSample];
+						}
+					}
+					hists[iAmpWave].fill(waveMax);
+					hists[iTimeWave].fill(waveTime * config.fadc250RawTimeScale);
+					// The plugin uses the sample number as the WAVE time of the TAC here
+					fillTagger(hists, taghIndex, 0, waveMax, waveTime,
+							columns[TAGH_COUNTER].ints.data() + taghStart,
+							columns[TAGH_TIME].reals.data() + taghStart,
+							taghMatched.data() + taghStart, nTAGH);
+					fillTagger(hists, tagmIndex, 0, waveMax, waveTime,
+							columns[TAGM_COUNTER].ints.data() + tagmStart,
+							columns[TAGM_TIME].reals.data() + tagmStart,
+							tagmMatched.data() + tagmStart, nTAGM);
+				}
+
+				hists[iNHits].fill(columns[N_PULSES].ints[iEvent]);
+				hists[iAmpPulse].fill(pulsePeak);
+				hists[iTimePulse].fill(pulseTime);
+				hists[iIntegral].fill(pulseIntegral);
+				fillTagger(hists, taghIndex, 1, pulsePeak, pulseTime,
+						columns[TAGH_COUNTER].ints.data() + taghStart,
+						columns[TAGH_TIME].reals.data() + taghStart,
+						taghMatched.data() + taghStart, nTAGH);
+				fillTagger(hists, tagmIndex, 1, pulsePeak, pulseTime,
+						columns[TAGM_COUNTER].ints.data() + tagmStart,
+						columns[TAGM_TIME].reals.data() + tagmStart,
+						tagmMatched.data() + tagmStart, nTAGM);
+
+				hists[iNTDCHits].fill(columns[N_TDC_HITS].ints[iEvent]);
+				for (uint64_t iTime = 0; iTime < nTDCTimes; iTime++)
+					hists[iTDCTime].fill(columns[TDC_TIMES].reals[tdcStart + iTime]);
+				// Paired with the largest pulse as in the plugin
+				if (columns[N_PULSES].ints[iEvent] > 0) {
+					for (uint64_t iTime = 0; iTime < nTDCTimes; iTime++)
+						hists[iTDCADCTime].fill(columns[TDC_TIMES].reals[tdcStart + iTime] - pulseTime);
+				}
+			}
+
+			sampleStart += nSamples;
+			tdcStart += nTDCTimes;
+			taghStart += nTAGH;
+			tagmStart += nTAGM;
+		}
+		nEvents += block.nEvents;
+	}
+
+	void merge(const ReplaySet& other) {
+		for (size_t iBit = 0; iBit < histograms.size(); iBit++) {
+			for (size_t iHist = 0; iHist < histograms[iBit].size(); iHist++)
+				histograms[iBit][iHist].add(other.histograms[iBit][iHist]);
+		}
+		if (latestEvent < other.latestEvent) {
+			latestEvent = other.latestEvent;
+			latestSamples = other.latestSamples;
+		}
+		nEvents += other.nEvents;
+	}
+
+	// Create the ROOT histograms the way createHistograms() does and write them
+	void write(TDirectory* dir) {
+		dir->cd();
+		auto& definitions = getTACHistogramDefinitions();
+		for (size_t iBit = 0; iBit < trigBits.size(); iBit++) {
+			unsigned trigBit = trigBits[iBit];
+			auto& hists = histograms[iBit];
+			for (unsigned iSample = 0; iSample < latestSamples.size()
+					&& int(iSample) < hists[iRaw].getNbinsX(); iSample++)
+				hists[iRaw].cell(iSample + 1) = latestSamples[iSample];
+
+			map<string, unique_ptr<TH1> > rootHistos;
+			for (size_t iDef = 0; iDef < definitions.size(); iDef++) {
+				auto& def = definitions[iDef];
+				string histName = def.key + "_" + to_string(trigBit);
+				string histTitle = def.titlePrefix + to_string(trigBit);
+				unique_ptr<TH1> histo;
+				if (def.is2D()) {
+					histo.reset(new TH2D(histName.c_str(), histTitle.c_str(),
+							def.nBinsX, def.xMin, def.xMax, def.nBinsY,
+							def.yMin, def.yMax));
+					histo->GetYaxis()->SetTitle(def.yTitle.c_str());
+				} else {
+					histo.reset(new TH1D(histName.c_str(), histTitle.c_str(),
+							def.nBinsX, def.xMin, def.xMax));
+				}
+				histo->GetXaxis()->SetTitle(def.xTitle.c_str());
+				hists[iDef].copyTo(histo.get());
+				rootHistos[def.key] = std::move(histo);
+			}
+			rootHistos["TACFADCRAW_AVG"]->Divide(rootHistos["TACFADCRAW_SUM"].get(),
+					rootHistos["TACFADCRAW_ENTRIES"].get(), 1, 1);
+			for (string detComp : { "TAGH", "TAGM" }) {
+				rootHistos[detComp + "_EFFICIENCY"]->Divide(
+						rootHistos[detComp + "_ID_MATCHEDPULSE"].get(),
+						rootHistos[detComp + "_ID_PULSE"].get(), 1, 1, "B");
+			}
+			for (auto& histoPair : rootHistos)
+				histoPair.second->Write();
+		}
+	}
+
+	uint64_t getNumberOfEvents() const {
+		return nEvents;
+	}
+};
+
+static void usage() {
+	cout << "Usage:" << endl
+			<< "   tac_replay [options] tac_features_1.bin tac_features_2.bin ..." << endl << endl
+			<< "Options:" << endl
+			<< "   -o file      output file name (default tac_replay.root)" << endl
+			<< "   -j n         number of threads (default: number of cores)" << endl
+			<< "   -m mask      trigger mask (default 0x2)" << endl
+			<< "   -H t         TAGH coincidence time in ns (default 100)" << endl
+			<< "   -M t         TAGM coincidence time in ns (default 90)" << endl
+			<< "   -w w         TAGH coincidence half-width in ns (default 20)" << endl
+			<< "   -W w         TAGM coincidence half-width in ns (default 20)" << endl
+			<< "   -T thr       TAC FADC threshold (default 200)" << endl
+			<< "   -p           also replay files with the tagger hits of a window only," << endl
+			<< "                their TAGH and TAGM histograms miss the other hits" << endl
+			<< "   -h           print this message" << endl;
+}
+
+int main(int argc, char* argv[]) {
+	ReplayConfig config;
+	string outFileName = "tac_replay.root";
+	unsigned nThreads = thread::hardware_concurrency();
+	bool allowTaggerWindow = false;
+
+	int option;
+	while ((option = getopt(argc, argv, "o:j:m:H:M:w:W:T:ph")) != -1) {
+		switch (option) {
+		case 'o':
+			outFileName = optarg;
+			break;
+		case 'j':
+			nThreads = atoi(optarg);
+			break;
+		case 'm':
+			config.triggerMask = strtoul(optarg, nullptr, 0);
+			break;
+		case 'H':
+			config.timeCutValue_TAGH = atof(optarg);
+			break;
+		case 'M':
+			config.timeCutValue_TAGM = atof(optarg);
+			break;
+		case 'w':
+			config.timeCutWidth_TAGH = atof(optarg);
+			break;
+		case 'W':
+			config.timeCutWidth_TAGM = atof(optarg);
+			break;
+		case 'T':
+			config.tacThreshold = atoi(optarg);
+			break;
+		case 'p':
+			allowTaggerWindow = true;
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+	vector<string> inFileNames(argv + optind, argv + argc);
+	if (inFileNames.empty()) {
+		usage();
+		return -1;
+	}
+	if (nThreads < 1)
+		nThreads = 1;
+
+	auto startTime = chrono::steady_clock::now();
+
+	// Map all files and make one list of blocks
+	vector<unique_ptr<FileReader> > readers;
+	vector<pair<size_t, size_t> > workList;
+	size_t totalBytes = 0;
+	for (auto& fileName : inFileNames) {
+		unique_ptr<FileReader> reader(new FileReader());
+		if (!reader->open(fileName)) {
+			cerr << reader->getErrorMessage() << endl;
+			return -1;
+		}
+		auto& header = reader->getHeader();
+		if (header.fadc250RawTimeScale > 0)
+			config.fadc250RawTimeScale = header.fadc250RawTimeScale;
+		if (!header.hasSamples && header.tacThreshold != config.tacThreshold)
+			cerr << fileName << " has no samples, the WAVE times use threshold "
+					<< header.tacThreshold << endl;
+		// The _ID, _ID_PULSE, time and efficiency histograms of the tagger need all hits
+		if (header.taggerWindow > 0 && !allowTaggerWindow) {
+			cerr << fileName << " only has the tagger hits within " << header.taggerWindow
+					<< " ns of the original cuts, its TAGH and TAGM histograms would not be"
+					<< " the ones of the plugin. Write the features with"
+					<< " TAC:FEATURES_TAGGER_WINDOW=0, or give -p to replay it anyway" << endl;
+			return -1;
+		}
+		if (header.taggerWindow > 0
+				&& (fabs(config.timeCutValue_TAGH - header.taghTimeCutValue) + config.timeCutWidth_TAGH > header.taggerWindow
+						|| fabs(config.timeCutValue_TAGM - header.tagmTimeCutValue) + config.timeCutWidth_TAGM > header.taggerWindow))
+			cerr << fileName << " only has tagger hits within " << header.taggerWindow
+					<< " ns of the original cuts, matches outside are missed" << endl;
+		for (size_t iBlock = 0; iBlock < reader->getNumberOfBlocks(); iBlock++)
+			workList.emplace_back(readers.size(), iBlock);
+		totalBytes += reader->getFileSize();
+		readers.push_back(std::move(reader));
+	}
+	if (nThreads > workList.size())
+		nThreads = max<size_t>(1, workList.size());
+
+	// Each thread decodes and fills blocks from the common list
+	vector<unique_ptr<ReplaySet> > threadSets;
+	for (unsigned iThread = 0; iThread < nThreads; iThread++)
+		threadSets.emplace_back(new ReplaySet(config));
+	atomic<size_t> nextBlock(0);
+	atomic<unsigned> nErrors(0);
+	vector<thread> workers;
+	for (unsigned iThread = 0; iThread < nThreads; iThread++) {
+		workers.emplace_back([&, iThread]() {
+			Block block;
+			for (size_t iWork = nextBlock++; iWork < workList.size(); iWork = nextBlock++) {
+				auto& reader = *readers[workList[iWork].first];
+				if (!reader.decodeBlock(workList[iWork].second, block)) {
+					nErrors++;
+					continue;
+				}
+				threadSets[iThread]->process(block, reader.getHeader().hasSamples);
+			}
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+
+	// Tree reduction of the per-thread sets
+	for (size_t stride = 1; stride < threadSets.size(); stride *= 2) {
+		workers.clear();
+		for (size_t iSet = 0; iSet + stride < threadSets.size(); iSet += 2 * stride) {
+			workers.emplace_back([&threadSets, iSet, stride]() {
+				threadSets[iSet]->merge(*threadSets[iSet + stride]);
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	TH1::AddDirectory(false);
+	TFile outFile(outFileName.c_str(), "RECREATE");
+	if (outFile.IsZombie()) {
+		cerr << "Could not create " << outFileName << endl;
+		return -1;
+	}
+	threadSets[0]->write(&outFile);
+	outFile.Close();
+
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+	cout << "Replayed " << threadSets[0]->getNumberOfEvents() << " events ("
+			<< totalBytes / 1048576.0 << " MB) from " << inFileNames.size()
+			<< " files into " << outFileName << " using " << nThreads
+			<< " threads in " << elapsed << " s" << endl;
+	if (nErrors > 0) {
+		cerr << nErrors << " blocks could not be decoded" << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * tac_shm_view.cc
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: hovanes
+ *
+ *  Shows the histograms the TAC_Monitor plugin publishes in shared memory
+ *  (TAC:SHM_NAME), using HistogramShmReader. Without -H it lists every
+ *  histogram with its entries and how many were added since the previous
+ *  refresh. With -H it prints the non-empty cells of one histogram and how
+ *  much each changed. The plugin is not slowed down by any of this.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <csignal>
+#include <unistd.h>
+
+#include "HistogramShmReader.h"
+
+using namespace std;
+
+static volatile sig_atomic_t keepRunning = 1;
+
+static void handleSignal(int) {
+	keepRunning = 0;
+}
+
+static void usage() {
+	cout << "Usage:" << endl << "   tac_shm_view [options] [segment]" << endl << endl
+			<< "The segment name is /tac_monitor by default." << endl << endl
+			<< "Options:" << endl
+			<< "   -i seconds  refresh interval (default 2)" << endl
+			<< "   -n count    number of refreshes, 0 to run until interrupted (default 1)" << endl
+			<< "   -H name     show the cells of this histogram, like TACAmpPULSE_3" << endl
+			<< "   -h          print this message" << endl;
+}
+
+// Every histogram with its entries and the change since the previous call
+static void showTable(const HistogramShmReader& reader, vector<double>& lastEntries) {
+	lastEntries.resize(reader.size(), 0);
+	cout << "Run " << reader.getRunNumber() << ", " << reader.size()
+			<< " histograms, publication " << reader.getPublishCount() << endl;
+	for (unsigned index = 0; index < reader.size(); index++) {
+		// A histogram that cannot be read shows no change
+		double entries = lastEntries[index];
+		reader.read(index, [&](const HistogramShmFormat::HistogramHeader& header,
+				const double*) {
+			entries = header.entries;
+		});
+		cout << setw(40) << left << reader.getHeader(index).name << right
+				<< setw(16) << fixed << setprecision(0) << entries << setw(12)
+				<< showpos << entries - lastEntries[index] << noshowpos << endl;
+		lastEntries[index] = entries;
+	}
+}
+
+// Non-empty cells of one histogram and their change since the previous call
+static void showCells(const HistogramShmReader& reader, int index,
+		vector<double>& lastCells) {
+	vector<double> cells;
+	double entries = 0;
+	if (!reader.copy(index, cells, entries)) {
+		cout << "The histogram is being written all the time or its writer died, try again"
+				<< endl;
+		return;
+	}
+	lastCells.resize(cells.size(), 0);
+	auto& header = reader.getHeader(index);
+	int nColumns = header.nBinsX + 2;
+	cout << header.name << ", " << fixed << setprecision(0) << entries
+			<< " entries" << endl;
+	for (size_t iCell = 0; iCell < cells.size(); iCell++) {
+		if (cells[iCell] == 0 && lastCells[iCell] == 0)
+			continue;
+		cout << setw(8) << iCell % nColumns;
+		if (header.dimension > 1)
+			cout << setw(8) << iCell / nColumns;
+		cout << setw(16) << setprecision(3) << cells[iCell] << setw(16) << showpos
+				<< cells[iCell] - lastCells[iCell] << noshowpos << endl;
+	}
+	lastCells.swap(cells);
+}
+
+int main(int argc, char* argv[]) {
+	string segmentName = "/tac_monitor";
+	string histogramName;
+	unsigned interval = 2;
+	unsigned nRefreshes = 1;
+
+	int option;
+	while ((option = getopt(argc, argv, "i:n:H:h")) != -1) {
+		switch (option) {
+		case 'i':
+			interval = atoi(optarg);
+			break;
+		case 'n':
+			nRefreshes = atoi(optarg);
+			break;
+		case 'H':
+			histogramName = optarg;
+			break;
+		default:
+			usage();
+			return option == 'h' ? 0 : -1;
+		}
+	}
+	if (optind < argc)
+		segmentName = argv[optind];
+
+	signal(SIGINT, handleSignal);
+	signal(SIGTERM, handleSignal);
+
+	HistogramShmReader reader;
+	vector<double> lastValues;
+	for (unsigned iRefresh = 0; keepRunning && (nRefreshes == 0 || iRefresh < nRefreshes);
+			iRefresh++) {
+		if (iRefresh > 0)
+			sleep(interval);
+		// A new run of the plugin comes in a new segment
+		if (!reader.isOpen() || reader.isClosed()) {
+			lastValues.clear();
+			if (!reader.open(segmentName)) {
+				cerr << "Cannot open the segment " << segmentName << endl;
+				continue;
+			}
+		}
+		if (histogramName.empty()) {
+			showTable(reader, lastValues);
+		} else {
+			int index = reader.find(histogramName);
+			if (index < 0) {
+				cerr << "No histogram " << histogramName << " in " << segmentName << endl;
+				return -1;
+			}
+			showCells(reader, index, lastValues);
+		}
+	}
+	return 0;
+}